@@ -0,0 +1,46 @@
+#include "AllocationCounter.h"
+
+#include <cstdlib>
+#include <new>
+
+static thread_local size_t s_allocations = 0;
+
+size_t
+AllocationCounter::GetAllocations()
+{
+	return s_allocations;
+}
+
+//Replacing the global operator new/delete counts every allocation of the program,
+//operator new[] and the nothrow versions forward here by default
+void*
+operator new(std::size_t size)
+{
+	++s_allocations;
+	if (size == 0)
+		size = 1;
+
+	while (true)
+	{
+		void *ptr = std::malloc(size);
+		if (ptr)
+			return ptr;
+
+		std::new_handler handler = std::get_new_handler();
+		if (!handler)
+			throw std::bad_alloc();
+		handler();
+	}
+}
+
+void
+operator delete(void *ptr) noexcept
+{
+	std::free(ptr);
+}
+
+void
+operator delete(void *ptr, std::size_t) noexcept
+{
+	std::free(ptr);
+}
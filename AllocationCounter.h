@@ -0,0 +1,14 @@
+#pragma once
+#include <cstddef>
+
+/*
+	AllocationCounter class counts the heap allocations done through operator new
+	The counter is kept per thread, so a delta taken around a piece of code is not
+	disturbed by other threads
+*/
+class AllocationCounter
+{
+public:
+	//Number of allocations done by the calling thread since it started
+	static size_t GetAllocations();
+};
@@ -0,0 +1,197 @@
+#include "BatchRunner.h"
+#include "Parser.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <set>
+#include <sstream>
+#include <thread>
+
+namespace fs = std::filesystem;
+
+using Clock = std::chrono::steady_clock;
+
+bool
+BatchRunner::AddDirectory(const std::string &path)
+{
+	std::error_code error;
+	if (!fs::is_directory(path, error))
+		return false;
+	std::vector<std::string> paths;
+	for (const fs::directory_entry &entry : fs::directory_iterator(path, error))
+		if (entry.is_regular_file(error))
+			paths.push_back(entry.path().string());
+	std::sort(paths.begin(), paths.end());
+	for (const std::string &script : paths)
+		AddScript(script, fs::path(script).filename().string());
+	return true;
+}
+
+bool
+BatchRunner::AddManifest(const std::string &path)
+{
+	std::ifstream manifest(path);
+	if (!manifest)
+		return false;
+	fs::path directory = fs::path(path).parent_path();
+	std::string line;
+	while (std::getline(manifest, line))
+	{
+		if (!line.empty() && line.back() == '\r')
+			line.pop_back();
+		if (line.empty())
+			continue;
+		//a script out of the manifest directory keeps only its file name
+		fs::path name = fs::path(line).lexically_normal();
+		if (name.is_absolute() || name.empty() || *name.begin() == "..")
+			name = name.filename();
+		AddScript((directory / line).string(), name.string());
+	}
+	return true;
+}
+
+void
+BatchRunner::AddScript(const std::string &path, const std::string &name)
+{
+	ScriptResult result;
+	result.m_path = path;
+	result.m_name = name.empty() ? fs::path(path).filename().string() : name;
+	if (!m_names.insert(result.m_name).second)
+	{
+		result.m_name = std::to_string(m_results.size()) + "-" + result.m_name;
+		m_names.insert(result.m_name);
+	}
+	std::error_code error;
+	result.m_bytes = static_cast<size_t>(fs::file_size(path, error));
+	if (error)
+		result.m_bytes = 0;
+	m_results.push_back(result);
+}
+
+bool
+BatchRunner::Run(size_t threads)
+{
+	m_threads = threads ? threads : std::max(1u, std::thread::hardware_concurrency());
+	if (!m_resultsDirectory.empty())
+	{
+		std::error_code error;
+		std::set<fs::path> scripts;
+		for (const ScriptResult &result : m_results)
+		{
+			fs::path script = fs::weakly_canonical(result.m_path, error);
+			if (!error)
+				scripts.insert(script);
+		}
+		for (const ScriptResult &result : m_results)
+		{
+			fs::path output = fs::weakly_canonical(fs::path(m_resultsDirectory) / result.m_name, error);
+			if (!error && scripts.count(output))
+				return false;
+		}
+		fs::create_directories(m_resultsDirectory, error);
+	}
+
+	//biggest first, the scripts are taken in that order by the threads
+	std::vector<size_t> order(m_results.size());
+	for (size_t script = 0; script < order.size(); ++script)
+		order[script] = script;
+	std::stable_sort(order.begin(), order.end(), [this](size_t a, size_t b) { return m_results[a].m_bytes > m_results[b].m_bytes; });
+
+	std::atomic<size_t> next(0);
+	auto work = [this, &order, &next]() {
+		Parser parser;
+		for (size_t script = next++; script < order.size(); script = next++)
+			RunScript(parser, m_results[order[script]]);
+	};
+	Clock::time_point begin = Clock::now();
+	if (m_threads == 1)
+		work();
+	else
+	{
+		std::vector<std::thread> workers;
+		for (size_t t = 0; t < m_threads; ++t)
+			workers.emplace_back(work);
+		for (std::thread &worker : workers)
+			worker.join();
+	}
+	m_nanoseconds = std::chrono::duration<double, std::nano>(Clock::now() - begin).count();
+	return true;
+}
+
+void
+BatchRunner::RunScript(Parser &parser, ScriptResult &result) const
+{
+	Clock::time_point begin = Clock::now();
+	result.m_output.clear();
+	result.m_statements = result.m_errors = 0;
+	result.m_written = false;
+	std::ifstream file(result.m_path, std::ios::binary);
+	result.m_read = static_cast<bool>(file);
+	if (result.m_read)
+	{
+		parser.Reset();
+		std::string line;
+		while (std::getline(file, line))
+		{
+			if (!line.empty() && line.back() == '\r')
+				line.pop_back();
+			if (!line.empty())
+				parser.AddStatement(line);
+		}
+		parser.EvaluateStatements();
+
+		std::ostringstream out;
+		parser.PrintErrors(out);
+		parser.PrintVariables(out);
+		result.m_output = out.str();
+		result.m_statements = parser.GetStatementCount();
+		result.m_errors = parser.GetErrors().size();
+	}
+
+	if (result.m_read && !m_resultsDirectory.empty())
+	{
+		fs::path path = fs::path(m_resultsDirectory) / result.m_name;
+		std::error_code error;
+		fs::create_directories(path.parent_path(), error);
+		std::ofstream output(path, std::ios::binary | std::ios::trunc);
+		output << result.m_output;
+		result.m_written = static_cast<bool>(output.flush());
+	}
+	result.m_nanoseconds = std::chrono::duration<double, std::nano>(Clock::now() - begin).count();
+}
+
+void
+BatchRunner::WriteReport(std::ostream &out, size_t slowest) const
+{
+	size_t statements = 0, errors = 0, unread = 0, unwritten = 0;
+	for (const ScriptResult &result : m_results)
+	{
+		statements += result.m_statements;
+		errors += result.m_errors ? 1 : 0;
+		unread += result.m_read ? 0 : 1;
+		unwritten += result.m_read && !m_resultsDirectory.empty() && !result.m_written ? 1 : 0;
+	}
+	double seconds = m_nanoseconds / 1e9;
+	out << "Ran " << m_results.size() << " scripts, " << statements << " statements, in " << m_nanoseconds / 1e6 << " ms on "
+		<< m_threads << (m_threads == 1 ? " thread: " : " threads: ") << m_results.size() / seconds << " scripts/s, " << statements / seconds << " statements/s" << std::endl;
+	if (errors)
+		out << errors << " scripts reported errors" << std::endl;
+	if (unread)
+		out << unread << " scripts could not be read" << std::endl;
+	if (unwritten)
+		out << unwritten << " results could not be written" << std::endl;
+
+	std::vector<const ScriptResult*> sorted;
+	for (const ScriptResult &result : m_results)
+		sorted.push_back(&result);
+	slowest = std::min(slowest, sorted.size());
+	std::partial_sort(sorted.begin(), sorted.begin() + slowest, sorted.end(),
+		[](const ScriptResult *a, const ScriptResult *b) { return a->m_nanoseconds > b->m_nanoseconds; });
+	if (slowest)
+		out << "Slowest scripts:" << std::endl;
+	for (size_t i = 0; i < slowest; ++i)
+		out << "  " << sorted[i]->m_path << ": " << sorted[i]->m_nanoseconds / 1e6 << " ms, " << sorted[i]->m_statements << " statements" << std::endl;
+}
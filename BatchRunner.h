@@ -0,0 +1,74 @@
+#pragma once
+#include <cstddef>
+#include <ostream>
+#include <string>
+#include <unordered_set>
+#include <vector>
+
+class Parser;
+
+/*
+	BatchRunner class evaluates many independent scripts on every core. A script is a file of
+	statements, one per line, its empty lines being skipped.
+
+	Each thread keeps one Parser, reset between its scripts, and the parsers share the
+	built-in function table. The output of a script, its errors then its variables as main
+	prints them, is kept in its result and written to the results directory when there is one,
+	at the path of the script relative to its directory or manifest. The biggest scripts are started first so a long one does
+	not end up alone at the end of the run.
+*/
+class BatchRunner
+{
+public:
+	/*
+		ScriptResult utility class to hold the run of a script
+	*/
+	struct ScriptResult
+	{
+		std::string m_path;
+		//Path of its output relative to the results directory, unique in the batch
+		std::string m_name;
+		std::string m_output;
+		size_t m_bytes = 0;
+		size_t m_statements = 0;
+		size_t m_errors = 0;
+		double m_nanoseconds = 0;
+		//Whether the script could be read and its result written
+		bool m_read = false;
+		bool m_written = false;
+	};
+
+	//Every regular file of the directory is a script, by name order. False if it is not a directory
+	bool AddDirectory(const std::string &path);
+	//Every line of the manifest is the path of a script, relative to the manifest directory.
+	//False if the manifest could not be read
+	bool AddManifest(const std::string &path);
+	//name is the path of its output relative to the results directory, the file name of the
+	//script if empty. A name already taken in the batch is prefixed by the index of the script
+	void AddScript(const std::string &path, const std::string &name = "");
+
+	//Write the output of every script to its name in directory, created if needed.
+	//Empty to keep the outputs in the results only
+	void SetResultsDirectory(const std::string &directory) { m_resultsDirectory = directory; }
+
+	//Run every script, 0 threads for one per core. False without running any when an output
+	//would overwrite a script, e.g. the results directory is the one of the scripts
+	bool Run(size_t threads = 0);
+
+	//Results by the order the scripts were added
+	const std::vector<ScriptResult>& GetResults() const { return m_results; }
+	size_t GetThreads() const { return m_threads; }
+	double GetNanoseconds() const { return m_nanoseconds; }
+
+	//Print the throughput of the last run and its slowest scripts
+	void WriteReport(std::ostream &out, size_t slowest = 10) const;
+
+private:
+	void RunScript(Parser &parser, ScriptResult &result) const;
+
+	std::vector<ScriptResult> m_results;
+	std::unordered_set<std::string> m_names;
+	std::string m_resultsDirectory;
+	size_t m_threads = 0;
+	double m_nanoseconds = 0;
+};
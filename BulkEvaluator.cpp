@@ -0,0 +1,79 @@
+#include "BulkEvaluator.h"
+#include "LaneEnvironment.h"
+
+#include <algorithm>
+
+BulkEvaluator::BulkEvaluator(const Program &program, NumericType type)
+	: m_program(program)
+	, m_type(type)
+{
+}
+
+bool
+BulkEvaluator::Run(const ColumnFile &input, const std::vector<std::string> &selected, ColumnFile &output, std::string &unknown)
+{
+	std::vector<size_t> outputSlots(selected.size());
+	for (size_t column = 0; column < selected.size(); ++column)
+	{
+		if (!m_program.FindVariable(selected[column], outputSlots[column]))
+		{
+			unknown = selected[column];
+			return false;
+		}
+	}
+	std::vector<size_t> inputColumns, inputSlots;
+	for (size_t column = 0; column < input.GetColumnCount(); ++column)
+	{
+		size_t slot = 0;
+		if (m_program.FindVariable(input.GetName(column), slot))
+		{
+			inputColumns.push_back(column);
+			inputSlots.push_back(slot);
+		}
+	}
+
+	std::vector<std::vector<double>> values(selected.size(), std::vector<double>(input.GetRowCount()));
+	m_failedRows.clear();
+	if (m_type == NumericType::Float)
+		Run<float>(input, inputColumns, inputSlots, outputSlots, values);
+	else
+		Run<double>(input, inputColumns, inputSlots, outputSlots, values);
+
+	output.Clear();
+	for (size_t column = 0; column < selected.size(); ++column)
+		output.AddColumn(selected[column], std::move(values[column]));
+	return true;
+}
+
+template <typename V>
+void
+BulkEvaluator::Run(const ColumnFile &input, const std::vector<size_t> &inputColumns, const std::vector<size_t> &inputSlots,
+	const std::vector<size_t> &outputSlots, std::vector<std::vector<double>> &values)
+{
+	size_t rows = input.GetRowCount();
+	LaneEnvironment<s_lanes, V> lanes(m_program);
+	for (size_t first = 0; first < rows; first += s_lanes)
+	{
+		//the lanes past the last row repeat it
+		size_t count = std::min(s_lanes, rows - first);
+		lanes.Reset();
+		for (size_t i = 0; i < inputColumns.size(); ++i)
+		{
+			const double *column = input.GetColumn(inputColumns[i]);
+			Lanes<s_lanes, V> value;
+			for (size_t lane = 0; lane < s_lanes; ++lane)
+				value.m_lane[lane] = Numeric<V>::FromDouble(column[first + std::min(lane, count - 1)]);
+			lanes.RecordVariable(inputSlots[i], value);
+		}
+		lanes.Run();
+
+		for (size_t column = 0; column < outputSlots.size(); ++column)
+		{
+			const Lanes<s_lanes, V> &value = lanes.LookupVariable(outputSlots[column]);
+			std::copy(value.m_lane, value.m_lane + count, values[column].begin() + first);
+		}
+		for (size_t lane = 0; lane < count; ++lane)
+			if (!lanes.GetErrors(lane).empty())
+				m_failedRows.push_back(first + lane);
+	}
+}
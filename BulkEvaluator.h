@@ -0,0 +1,45 @@
+#pragma once
+#include "ColumnFile.h"
+#include "NumericEngine.h"
+#include "Program.h"
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+/*
+	BulkEvaluator class runs a Program once per row of a ColumnFile instead of reading a
+	statement per input value: every column sets the variable of its name, then the selected
+	variables are collected as the output columns.
+	Each row starts from the initial values of the program. The rows are evaluated s_lanes
+	at a time, see LaneEnvironment, so every instruction is dispatched once per block of rows,
+	in double or in float
+*/
+class BulkEvaluator
+{
+public:
+	static const size_t s_lanes = 8;
+
+	//type is Double or Float, see IsSupported
+	explicit BulkEvaluator(const Program &program, NumericType type = NumericType::Double);
+	//Whether the rows can be evaluated in type
+	static bool IsSupported(NumericType type) { return type == NumericType::Double || type == NumericType::Float; }
+
+	//Evaluate every row of input into output, a column per selected variable. False without
+	//evaluating anything if a selected variable is unknown to the program, it is then unknown.
+	//The columns of input the program does not know are not read
+	bool Run(const ColumnFile &input, const std::vector<std::string> &selected, ColumnFile &output, std::string &unknown);
+
+	//Rows of the last run which reported an error, by row order
+	const std::vector<size_t>& GetFailedRows() const { return m_failedRows; }
+
+private:
+	//Run in lanes of V, the selected and input slots being found
+	template <typename V>
+	void Run(const ColumnFile &input, const std::vector<size_t> &inputColumns, const std::vector<size_t> &inputSlots,
+		const std::vector<size_t> &outputSlots, std::vector<std::vector<double>> &values);
+
+	const Program &m_program;
+	NumericType m_type;
+	std::vector<size_t> m_failedRows;
+};
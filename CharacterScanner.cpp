@@ -0,0 +1,222 @@
+#include "CharacterScanner.h"
+
+#include <algorithm>
+
+#if (defined(__x86_64__) || defined(__i386__)) && defined(__GNUC__)
+#include <immintrin.h>
+#define CHARACTER_SCANNER_X86
+#endif
+
+static constexpr std::array<uint8_t, 256>
+BuildClasses()
+{
+	std::array<uint8_t, 256> classes {};
+	for (int c = 0; c < 256; ++c)
+	{
+		if (c == ' ' || (c >= '\t' && c <= '\r'))
+			classes[c] |= CharacterScanner::s_space;
+		if ((c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z'))
+			classes[c] |= CharacterScanner::s_alpha;
+		if (c >= '0' && c <= '9')
+			classes[c] |= CharacterScanner::s_digit;
+	}
+	return classes;
+}
+
+const std::array<uint8_t, 256> CharacterScanner::s_classes = BuildClasses();
+
+template <uint8_t Classes>
+static size_t
+SkipScalar(const char *text, size_t position, size_t length)
+{
+	const std::array<uint8_t, 256> &classes = CharacterScanner::s_classes;
+	while (position < length && (classes[static_cast<unsigned char>(text[position])] & Classes))
+		++position;
+	return position;
+}
+
+#ifdef CHARACTER_SCANNER_X86
+
+//Bytes of the run, as signed bytes every non ASCII one is negative and of no class
+static inline __m128i
+ClassifySSE2(__m128i bytes, uint8_t classes)
+{
+	__m128i match = _mm_setzero_si128();
+	if (classes & CharacterScanner::s_space)
+		match = _mm_or_si128(_mm_cmpeq_epi8(bytes, _mm_set1_epi8(' ')),
+			_mm_and_si128(_mm_cmpgt_epi8(bytes, _mm_set1_epi8('\t' - 1)), _mm_cmplt_epi8(bytes, _mm_set1_epi8('\r' + 1))));
+	if (classes & CharacterScanner::s_alpha)
+	{
+		//clearing the case bit maps the lower case letters on the upper case ones
+		__m128i upper = _mm_and_si128(bytes, _mm_set1_epi8(static_cast<char>(0xDF)));
+		match = _mm_or_si128(match, _mm_and_si128(_mm_cmpgt_epi8(upper, _mm_set1_epi8('A' - 1)), _mm_cmplt_epi8(upper, _mm_set1_epi8('Z' + 1))));
+	}
+	if (classes & CharacterScanner::s_digit)
+		match = _mm_or_si128(match, _mm_and_si128(_mm_cmpgt_epi8(bytes, _mm_set1_epi8('0' - 1)), _mm_cmplt_epi8(bytes, _mm_set1_epi8('9' + 1))));
+	return match;
+}
+
+template <uint8_t Classes>
+static size_t
+SkipSSE2(const char *text, size_t position, size_t length)
+{
+	for (; position + 16 <= length; position += 16)
+	{
+		__m128i bytes = _mm_loadu_si128(reinterpret_cast<const __m128i*>(text + position));
+		unsigned int mask = static_cast<unsigned int>(_mm_movemask_epi8(ClassifySSE2(bytes, Classes)));
+		if (mask != 0xFFFF)
+			return position + __builtin_ctz(~mask);
+	}
+	return SkipScalar<Classes>(text, position, length);
+}
+
+__attribute__((target("avx2"))) static inline __m256i
+ClassifyAVX2(__m256i bytes, uint8_t classes)
+{
+	__m256i match = _mm256_setzero_si256();
+	if (classes & CharacterScanner::s_space)
+		match = _mm256_or_si256(_mm256_cmpeq_epi8(bytes, _mm256_set1_epi8(' ')),
+			_mm256_and_si256(_mm256_cmpgt_epi8(bytes, _mm256_set1_epi8('\t' - 1)), _mm256_cmpgt_epi8(_mm256_set1_epi8('\r' + 1), bytes)));
+	if (classes & CharacterScanner::s_alpha)
+	{
+		__m256i upper = _mm256_and_si256(bytes, _mm256_set1_epi8(static_cast<char>(0xDF)));
+		match = _mm256_or_si256(match, _mm256_and_si256(_mm256_cmpgt_epi8(upper, _mm256_set1_epi8('A' - 1)), _mm256_cmpgt_epi8(_mm256_set1_epi8('Z' + 1), upper)));
+	}
+	if (classes & CharacterScanner::s_digit)
+		match = _mm256_or_si256(match, _mm256_and_si256(_mm256_cmpgt_epi8(bytes, _mm256_set1_epi8('0' - 1)), _mm256_cmpgt_epi8(_mm256_set1_epi8('9' + 1), bytes)));
+	return match;
+}
+
+template <uint8_t Classes>
+__attribute__((target("avx2"))) static size_t
+SkipAVX2(const char *text, size_t position, size_t length)
+{
+	//a run shorter than 16 bytes ends within the first SSE2 block
+	if (position + 16 <= length)
+	{
+		__m128i bytes = _mm_loadu_si128(reinterpret_cast<const __m128i*>(text + position));
+		unsigned int mask = static_cast<unsigned int>(_mm_movemask_epi8(ClassifySSE2(bytes, Classes)));
+		if (mask != 0xFFFF)
+			return position + __builtin_ctz(~mask);
+		position += 16;
+	}
+	for (; position + 32 <= length; position += 32)
+	{
+		__m256i bytes = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(text + position));
+		unsigned int mask = static_cast<unsigned int>(_mm256_movemask_epi8(ClassifyAVX2(bytes, Classes)));
+		if (mask != 0xFFFFFFFFu)
+			return position + __builtin_ctz(~mask);
+	}
+	return SkipSSE2<Classes>(text, position, length);
+}
+
+#endif
+
+static const uint8_t s_space = CharacterScanner::s_space;
+static const uint8_t s_digit = CharacterScanner::s_digit;
+static const uint8_t s_alphanumeric = CharacterScanner::s_alpha | CharacterScanner::s_digit;
+
+/*
+	Kernels utility class to hold the functions of an implementation
+*/
+struct Kernels
+{
+	size_t (*m_spaces)(const char*, size_t, size_t);
+	size_t (*m_alphanumerics)(const char*, size_t, size_t);
+	size_t (*m_digits)(const char*, size_t, size_t);
+};
+
+static Kernels
+GetKernels(CharacterScanner::Implementation implementation)
+{
+	switch (implementation)
+	{
+#ifdef CHARACTER_SCANNER_X86
+	case CharacterScanner::Implementation::AVX2:
+		return Kernels{SkipAVX2<s_space>, SkipAVX2<s_alphanumeric>, SkipAVX2<s_digit>};
+	case CharacterScanner::Implementation::SSE2:
+		return Kernels{SkipSSE2<s_space>, SkipSSE2<s_alphanumeric>, SkipSSE2<s_digit>};
+#endif
+	default:
+		return Kernels{SkipScalar<s_space>, SkipScalar<s_alphanumeric>, SkipScalar<s_digit>};
+	}
+}
+
+//Scalar until the best implementation is selected when the program starts, a statement read
+//by the initialization of another file may come first
+static CharacterScanner::Implementation s_implementation = CharacterScanner::Implementation::Scalar;
+static Kernels s_kernels {SkipScalar<s_space>, SkipScalar<s_alphanumeric>, SkipScalar<s_digit>};
+static const bool s_selected = CharacterScanner::SetImplementation(CharacterScanner::GetBestImplementation());
+
+//Most runs of a statement are a few bytes long, shorter than a vector: the first bytes are
+//classified one at a time and the kernel only called for a longer run
+static const size_t s_prologue = 8;
+
+template <uint8_t Classes>
+static inline size_t
+Skip(size_t (*kernel)(const char*, size_t, size_t), const char *text, size_t position, size_t length)
+{
+	size_t end = SkipScalar<Classes>(text, position, std::min(length, position + s_prologue));
+	return end == position + s_prologue ? kernel(text, end, length) : end;
+}
+
+size_t
+CharacterScanner::SkipSpaces(const char *text, size_t position, size_t length)
+{
+	return Skip<s_space>(s_kernels.m_spaces, text, position, length);
+}
+
+size_t
+CharacterScanner::SkipAlphanumerics(const char *text, size_t position, size_t length)
+{
+	return Skip<s_alphanumeric>(s_kernels.m_alphanumerics, text, position, length);
+}
+
+size_t
+CharacterScanner::SkipDigits(const char *text, size_t position, size_t length)
+{
+	return Skip<s_digit>(s_kernels.m_digits, text, position, length);
+}
+
+CharacterScanner::Implementation
+CharacterScanner::GetBestImplementation()
+{
+#ifdef CHARACTER_SCANNER_X86
+	__builtin_cpu_init();
+	if (__builtin_cpu_supports("avx2"))
+		return Implementation::AVX2;
+	if (__builtin_cpu_supports("sse2"))
+		return Implementation::SSE2;
+#endif
+	return Implementation::Scalar;
+}
+
+CharacterScanner::Implementation
+CharacterScanner::GetImplementation()
+{
+	return s_implementation;
+}
+
+bool
+CharacterScanner::SetImplementation(Implementation implementation)
+{
+	if (implementation > GetBestImplementation())
+		return false;
+	s_implementation = implementation;
+	s_kernels = GetKernels(implementation);
+	return true;
+}
+
+const char*
+CharacterScanner::GetImplementationName(Implementation implementation)
+{
+	switch (implementation)
+	{
+	case Implementation::AVX2:
+		return "avx2";
+	case Implementation::SSE2:
+		return "sse2";
+	default:
+		return "scalar";
+	}
+}
@@ -0,0 +1,47 @@
+#pragma once
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+/*
+	CharacterScanner class classifies the characters of a statement the way the C locale does,
+	without locale calls: white spaces, letters and digits.
+	The Skip functions return the end of the run of a class starting at position, classifying
+	16 bytes at a time with SSE2 or 32 with AVX2 where the processor has them, chosen once
+	when the program starts, and a byte at a time otherwise
+*/
+class CharacterScanner
+{
+public:
+	enum class Implementation
+	{
+		Scalar,
+		SSE2,
+		AVX2
+	};
+
+	static bool IsSpace(char c) { return s_classes[static_cast<unsigned char>(c)] & s_space; }
+	static bool IsAlpha(char c) { return s_classes[static_cast<unsigned char>(c)] & s_alpha; }
+	static bool IsDigit(char c) { return s_classes[static_cast<unsigned char>(c)] & s_digit; }
+	static bool IsAlphanumeric(char c) { return s_classes[static_cast<unsigned char>(c)] & (s_alpha | s_digit); }
+
+	//End of the run of ' ', '\t', '\n', '\v', '\f' and '\r' from position in text of length bytes
+	static size_t SkipSpaces(const char *text, size_t position, size_t length);
+	//End of the run of letters and digits
+	static size_t SkipAlphanumerics(const char *text, size_t position, size_t length);
+	//End of the run of digits
+	static size_t SkipDigits(const char *text, size_t position, size_t length);
+
+	//The fastest implementation the processor supports
+	static Implementation GetBestImplementation();
+	static Implementation GetImplementation();
+	//Use another implementation, e.g. to compare them. False if the processor does not support it
+	static bool SetImplementation(Implementation implementation);
+	static const char* GetImplementationName(Implementation implementation);
+
+	static const uint8_t s_space = 1;
+	static const uint8_t s_alpha = 2;
+	static const uint8_t s_digit = 4;
+	//Classes of every byte, by the byte as unsigned
+	static const std::array<uint8_t, 256> s_classes;
+};
@@ -0,0 +1,302 @@
+#include "ColumnFile.h"
+
+#include <algorithm>
+#include <charconv>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#define COLUMN_FILE_MMAP
+#endif
+
+static bool
+IsLittleEndian()
+{
+	const uint16_t one = 1;
+	unsigned char first = 0;
+	std::memcpy(&first, &one, 1);
+	return first == 1;
+}
+
+static double
+SwapBytes(double value)
+{
+	unsigned char bytes[sizeof(double)];
+	std::memcpy(bytes, &value, sizeof(double));
+	std::reverse(bytes, bytes + sizeof(double));
+	std::memcpy(&value, bytes, sizeof(double));
+	return value;
+}
+
+static bool
+EndsWith(const std::string &text, const std::string &suffix)
+{
+	return text.size() >= suffix.size() && text.compare(text.size() - suffix.size(), suffix.size(), suffix) == 0;
+}
+
+//The field without its surrounding spaces
+static void
+Trim(const char *&begin, const char *&end)
+{
+	while (begin < end && (*begin == ' ' || *begin == '\t'))
+		++begin;
+	while (end > begin && (end[-1] == ' ' || end[-1] == '\t' || end[-1] == '\r'))
+		--end;
+}
+
+ColumnFile::~ColumnFile()
+{
+	Close();
+}
+
+bool
+ColumnFile::Load(const std::string &path, const std::vector<std::string> &names)
+{
+	return EndsWith(path, ".csv") ? LoadCsv(path) : LoadBinary(path, names);
+}
+
+bool
+ColumnFile::LoadCsv(const std::string &path)
+{
+	Clear();
+	const char *data = nullptr;
+	size_t size = 0;
+	if (!Open(path, data, size))
+		return false;
+
+	const char *end = data + size;
+	size_t line = 0;
+	for (const char *begin = data; begin < end; ++line)
+	{
+		bool header = m_names.empty();
+		const char *lineEnd = std::find(begin, end, '\n');
+		const char *next = lineEnd < end ? lineEnd + 1 : end;
+		const char *trimmedBegin = begin, *trimmedEnd = lineEnd;
+		Trim(trimmedBegin, trimmedEnd);
+		size_t column = 0;
+		for (const char *field = begin; trimmedBegin < trimmedEnd && field <= lineEnd; ++column)
+		{
+			const char *fieldEnd = std::find(field, lineEnd, ',');
+			const char *valueBegin = field, *valueEnd = fieldEnd;
+			Trim(valueBegin, valueEnd);
+			field = fieldEnd + 1;
+			if (header)
+			{
+				m_names.emplace_back(valueBegin, valueEnd);
+				m_columns.emplace_back();
+				continue;
+			}
+
+			double value = 0;
+			std::from_chars_result result = std::from_chars(valueBegin, valueEnd, value);
+			if (column >= m_names.size())
+				return Fail("Line " + std::to_string(line + 1) + ": more than " + std::to_string(m_names.size()) + " values");
+			if (valueBegin == valueEnd || result.ptr != valueEnd)
+				return Fail("Line " + std::to_string(line + 1) + ": invalid number '" + std::string(valueBegin, valueEnd) + "'");
+			m_columns[column].push_back(value);
+		}
+		if (!header && column && column != m_names.size())
+			return Fail("Line " + std::to_string(line + 1) + ": " + std::to_string(column) + " values, expected " + std::to_string(m_names.size()));
+		begin = next;
+	}
+	if (m_names.empty())
+		return Fail("No header line");
+	m_rows = m_columns[0].size();
+	m_fileBytes = size;
+	Close();
+	return true;
+}
+
+bool
+ColumnFile::LoadBinary(const std::string &path, const std::vector<std::string> &names)
+{
+	Clear();
+	const char *data = nullptr;
+	size_t size = 0;
+	if (names.empty())
+		return Fail("No column names");
+	if (!Open(path, data, size))
+		return false;
+	if (size % (names.size() * sizeof(double)))
+		return Fail(std::to_string(size) + " bytes is not a number of rows of " + std::to_string(names.size()) + " doubles");
+
+	m_names = names;
+	m_rows = size / (names.size() * sizeof(double));
+	m_fileBytes = size;
+	//the mapping is aligned on a page so every column is aligned for doubles
+	if (m_mapping && IsLittleEndian())
+	{
+		m_mapped = reinterpret_cast<const double*>(data);
+		return true;
+	}
+
+	m_columns.assign(names.size(), std::vector<double>(m_rows));
+	for (size_t column = 0; column < names.size(); ++column)
+	{
+		std::memcpy(m_columns[column].data(), data + column * m_rows * sizeof(double), m_rows * sizeof(double));
+		if (!IsLittleEndian())
+			for (double &value : m_columns[column])
+				value = SwapBytes(value);
+	}
+	Close();
+	return true;
+}
+
+bool
+ColumnFile::Save(const std::string &path) const
+{
+	return EndsWith(path, ".csv") ? SaveCsv(path) : SaveBinary(path);
+}
+
+bool
+ColumnFile::SaveCsv(const std::string &path) const
+{
+	std::string buffer;
+	for (size_t column = 0; column < m_names.size(); ++column)
+		buffer += (column ? "," : "") + m_names[column];
+	buffer += '\n';
+
+	//the shortest text reading back as the same double
+	char number[32];
+	for (size_t row = 0; row < m_rows; ++row)
+	{
+		for (size_t column = 0; column < m_names.size(); ++column)
+		{
+			if (column)
+				buffer += ',';
+			std::to_chars_result result = std::to_chars(number, number + sizeof(number), GetColumn(column)[row]);
+			buffer.append(number, result.ptr);
+		}
+		buffer += '\n';
+	}
+
+	std::ofstream file(path, std::ios::binary | std::ios::trunc);
+	file.write(buffer.data(), buffer.size());
+	return static_cast<bool>(file.flush());
+}
+
+bool
+ColumnFile::SaveBinary(const std::string &path) const
+{
+	std::ofstream file(path, std::ios::binary | std::ios::trunc);
+	std::vector<double> swapped;
+	for (size_t column = 0; column < m_names.size(); ++column)
+	{
+		const double *values = GetColumn(column);
+		if (!IsLittleEndian())
+		{
+			swapped.assign(values, values + m_rows);
+			for (double &value : swapped)
+				value = SwapBytes(value);
+			values = swapped.data();
+		}
+		file.write(reinterpret_cast<const char*>(values), m_rows * sizeof(double));
+	}
+	return static_cast<bool>(file.flush());
+}
+
+void
+ColumnFile::AddColumn(const std::string &name, std::vector<double> values)
+{
+	if (m_names.empty())
+		m_rows = values.size();
+	m_names.push_back(name);
+	m_columns.push_back(std::move(values));
+}
+
+void
+ColumnFile::Clear()
+{
+	Close();
+	m_names.clear();
+	m_columns.clear();
+	m_rows = 0;
+	m_fileBytes = 0;
+	m_error.clear();
+}
+
+bool
+ColumnFile::Fail(const std::string &error)
+{
+	Clear();
+	m_error = error;
+	return false;
+}
+
+#ifdef COLUMN_FILE_MMAP
+
+bool
+ColumnFile::Open(const std::string &path, const char *&data, size_t &size)
+{
+	int fd = ::open(path.c_str(), O_RDONLY);
+	struct stat status;
+	if (fd < 0 || ::fstat(fd, &status) != 0)
+	{
+		if (fd >= 0)
+			::close(fd);
+		m_error = "Could not open " + path;
+		return false;
+	}
+
+	size = static_cast<size_t>(status.st_size);
+	data = "";
+	if (!size)
+	{
+		::close(fd);
+		return true;
+	}
+	void *mapped = ::mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+	::close(fd);
+	if (mapped == MAP_FAILED)
+	{
+		m_error = "Could not map " + path;
+		return false;
+	}
+	m_mapping = mapped;
+	m_mappingSize = size;
+	data = static_cast<const char*>(mapped);
+	return true;
+}
+
+void
+ColumnFile::Close()
+{
+	if (m_mapping)
+		::munmap(m_mapping, m_mappingSize);
+	m_mapping = nullptr;
+	m_mappingSize = 0;
+	m_mapped = nullptr;
+	m_buffer.clear();
+}
+
+#else
+
+bool
+ColumnFile::Open(const std::string &path, const char *&data, size_t &size)
+{
+	std::ifstream file(path, std::ios::binary);
+	if (!file)
+	{
+		m_error = "Could not open " + path;
+		return false;
+	}
+	m_buffer.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+	data = m_buffer.data();
+	size = m_buffer.size();
+	return true;
+}
+
+void
+ColumnFile::Close()
+{
+	m_mapped = nullptr;
+	m_buffer.clear();
+}
+
+#endif
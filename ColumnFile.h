@@ -0,0 +1,62 @@
+#pragma once
+#include <cstddef>
+#include <string>
+#include <vector>
+
+/*
+	ColumnFile class holds named columns of doubles with the same number of rows, read from or
+	written to a file in one of two formats:
+	CSV, a header line of names then a line of comma separated numbers per row,
+	binary, the columns one after the other as 8 bytes little-endian doubles, the names and
+	so the number of columns being given by the caller.
+	A binary file is memory-mapped where supported and its columns read in place
+*/
+class ColumnFile
+{
+public:
+	ColumnFile() = default;
+	~ColumnFile();
+	ColumnFile(const ColumnFile &) = delete;
+	ColumnFile& operator=(const ColumnFile &) = delete;
+
+	//CSV for a path ending in .csv, binary with the names otherwise. False if the file could not
+	//be read or is malformed, see GetError, the columns are then empty
+	bool Load(const std::string &path, const std::vector<std::string> &names);
+	bool LoadCsv(const std::string &path);
+	bool LoadBinary(const std::string &path, const std::vector<std::string> &names);
+	//False if the file could not be written
+	bool Save(const std::string &path) const;
+	bool SaveCsv(const std::string &path) const;
+	bool SaveBinary(const std::string &path) const;
+
+	//Append a column, which must have as many rows as the others
+	void AddColumn(const std::string &name, std::vector<double> values);
+	void Clear();
+
+	size_t GetColumnCount() const { return m_names.size(); }
+	size_t GetRowCount() const { return m_rows; }
+	const std::string& GetName(size_t column) const { return m_names[column]; }
+	const double* GetColumn(size_t column) const { return m_mapped ? m_mapped + column * m_rows : m_columns[column].data(); }
+	//Size of the file of the last Load
+	size_t GetFileBytes() const { return m_fileBytes; }
+	//Why the last Load failed
+	const std::string& GetError() const { return m_error; }
+
+private:
+	//Map or read the whole file, the data stays valid until Close
+	bool Open(const std::string &path, const char *&data, size_t &size);
+	void Close();
+	//Clear the columns, keeping error as the reason of the failure
+	bool Fail(const std::string &error);
+
+	std::vector<std::string> m_names;
+	std::vector<std::vector<double>> m_columns;
+	//Columns read in place from the mapped file, null when they are in m_columns
+	const double *m_mapped = nullptr;
+	void *m_mapping = nullptr;
+	size_t m_mappingSize = 0;
+	std::vector<char> m_buffer;
+	size_t m_rows = 0;
+	size_t m_fileBytes = 0;
+	std::string m_error;
+};
@@ -0,0 +1,635 @@
+#pragma once
+#include "Parser.h"
+
+#include <array>
+#include <cmath>
+#include <cstddef>
+
+/*
+	Compile-time front end of the Parser grammar
+
+	A statement written as a literal, e.g.
+		using namespace compiletime::literals;
+		"a*2+sin(b)"_expr.Evaluate(parser);
+	is parsed by the compiler into an expression-template type, so evaluating it costs
+	no tokenizing, no parsing and no allocation and every node is inlined.
+	Variables are read from and written to a Parser, their slots are resolved once by Bind.
+
+	The grammar is the one of Parser without function definitions: assignments and
+	compound assignments, + - * / % ^, groups, ++/-- and the built-in functions.
+	An invalid statement fails to compile.
+	Whether a variable is defined is not known at compile time, so x++ is always read as a
+	postfix increment, where the Parser requires x to be defined: x+++y is x++ + y here but
+	x + ++y for a Parser in which x is undefined.
+
+	String literal operator templates are a GNU extension supported by gcc and clang.
+*/
+namespace compiletime
+{
+
+enum class NodeKind
+{
+	Number,
+	Variable,
+	Add,
+	Substract,
+	Multiply,
+	Divide,
+	Modulus,
+	Power,
+	Call,
+	Call2,
+	PrefixIncrement,
+	PrefixDecrement,
+	PostfixIncrement,
+	PostfixDecrement,
+	Assign
+};
+
+//Built-in functions of Parser::GetFunctionsMap and Parser::GetBinaryFunctionsMap
+enum class FunctionId
+{
+	Sin, Asin, Cos, Acos, Tan, Atan, Ceil, Floor,
+	Min, Max, Atan2, Pow,
+	None
+};
+
+struct Node
+{
+	NodeKind m_kind = NodeKind::Number;
+	double m_value = 0;
+	int m_left = -1;
+	int m_right = -1;
+	//variable index or FunctionId
+	int m_index = 0;
+	int m_position = -1;
+};
+
+struct VariableName
+{
+	int m_offset = 0;
+	int m_length = 0;
+};
+
+//A statement of N-2 characters has at most N nodes and N variables
+template <size_t N>
+struct Ast
+{
+	std::array<Node, N> m_nodes{};
+	int m_nodeCount = 0;
+	std::array<VariableName, N> m_variables{};
+	int m_variableCount = 0;
+	int m_root = -1;
+};
+
+/*
+	AstParser class reads a statement the way Parser does and fills an Ast in a constant expression
+*/
+template <size_t N>
+class AstParser
+{
+public:
+	constexpr AstParser(const char *text, size_t length)
+		: m_text(text), m_length(static_cast<int>(length))
+	{
+	}
+
+	constexpr Ast<N> Parse()
+	{
+		int root = EvaluateAssignment();
+		if (root < 0)
+			root = EvaluateCalculation();
+		m_ast.m_root = root;
+		return m_ast;
+	}
+
+private:
+	static constexpr bool IsSpace(char c) { return c == ' ' || c == '\t' || c == '\n' || c == '\r' || c == '\f' || c == '\v'; }
+	static constexpr bool IsDigit(char c) { return c >= '0' && c <= '9'; }
+	static constexpr bool IsAlpha(char c) { return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z'); }
+	static constexpr bool IsAlnum(char c) { return IsAlpha(c) || IsDigit(c); }
+
+	constexpr void SkipWhiteSpaces()
+	{
+		while (m_pos < m_length && IsSpace(m_text[m_pos]))
+			++m_pos;
+	}
+
+	constexpr bool ReachedEnd()
+	{
+		SkipWhiteSpaces();
+		return m_pos >= m_length;
+	}
+
+	constexpr bool EvaluateCharacter(char expected)
+	{
+		SkipWhiteSpaces();
+		if (m_pos < m_length && m_text[m_pos] == expected)
+		{
+			++m_pos;
+			return true;
+		}
+		return false;
+	}
+
+	constexpr bool EvaluateCharacters(char first, char second)
+	{
+		SkipWhiteSpaces();
+		if (m_pos + 1 < m_length && m_text[m_pos] == first && m_text[m_pos + 1] == second)
+		{
+			m_pos += 2;
+			return true;
+		}
+		return false;
+	}
+
+	//Offset of the name read, its length in length, -1 if there is none
+	constexpr int EvaluateName(int &length)
+	{
+		SkipWhiteSpaces();
+		int offset = m_pos;
+		if (m_pos < m_length && IsAlpha(m_text[m_pos]))
+			while (m_pos < m_length && IsAlnum(m_text[m_pos]))
+				++m_pos;
+		length = m_pos - offset;
+		return length > 0 ? offset : -1;
+	}
+
+	constexpr bool IsName(int offset, int length, const char *name) const
+	{
+		int i = 0;
+		for (; i < length && name[i]; ++i)
+			if (m_text[offset + i] != name[i])
+				return false;
+		return i == length && !name[i];
+	}
+
+	constexpr FunctionId GetFunction(int offset, int length) const
+	{
+		const char *names[] = {"sin", "asin", "cos", "acos", "tan", "atan", "ceil", "floor", "min", "max", "atan2", "pow"};
+		for (int i = 0; i < static_cast<int>(FunctionId::None); ++i)
+			if (IsName(offset, length, names[i]))
+				return static_cast<FunctionId>(i);
+		return FunctionId::None;
+	}
+
+	constexpr int GetVariable(int offset, int length)
+	{
+		for (int i = 0; i < m_ast.m_variableCount; ++i)
+		{
+			const VariableName &var = m_ast.m_variables[i];
+			bool same = var.m_length == length;
+			for (int c = 0; same && c < length; ++c)
+				same = m_text[var.m_offset + c] == m_text[offset + c];
+			if (same)
+				return i;
+		}
+		m_ast.m_variables[m_ast.m_variableCount] = VariableName{offset, length};
+		return m_ast.m_variableCount++;
+	}
+
+	constexpr int AddNode(NodeKind kind, int left = -1, int right = -1, int index = 0, double value = 0, int position = -1)
+	{
+		Node &node = m_ast.m_nodes[m_ast.m_nodeCount];
+		node.m_kind = kind;
+		node.m_left = left;
+		node.m_right = right;
+		node.m_index = index;
+		node.m_value = value;
+		node.m_position = position;
+		return m_ast.m_nodeCount++;
+	}
+
+	//Forget what a failed rule read
+	constexpr int Rewind(int pos, int nodes, int variables)
+	{
+		m_pos = pos;
+		m_ast.m_nodeCount = nodes;
+		m_ast.m_variableCount = variables;
+		return -1;
+	}
+
+	constexpr int EvaluateAssignment()
+	{
+		int pos = m_pos, nodes = m_ast.m_nodeCount, variables = m_ast.m_variableCount;
+		int length = 0;
+		int offset = EvaluateName(length);
+		if (offset < 0)
+			return Rewind(pos, nodes, variables);
+		int var = GetVariable(offset, length);
+
+		int rhs = -1;
+		int opPos = m_pos;
+		if (EvaluateCharacter('=') && (rhs = EvaluateSum()) >= 0 && ReachedEnd())
+			return AddNode(NodeKind::Assign, rhs, -1, var);
+		Rewind(opPos, m_ast.m_nodeCount, m_ast.m_variableCount);
+
+		const char ops[] = {'+', '-', '*', '/', '^', '%'};
+		const NodeKind kinds[] = {NodeKind::Add, NodeKind::Substract, NodeKind::Multiply, NodeKind::Divide, NodeKind::Power, NodeKind::Modulus};
+		for (int i = 0; i < 6; ++i)
+		{
+			int opNodes = m_ast.m_nodeCount;
+			if (EvaluateCharacters(ops[i], '=') && (rhs = EvaluateSum()) >= 0 && ReachedEnd())
+			{
+				int lhs = AddNode(NodeKind::Variable, -1, -1, var);
+				int value = AddNode(kinds[i], lhs, rhs, 0, 0, opPos);
+				return AddNode(NodeKind::Assign, value, -1, var);
+			}
+			Rewind(opPos, opNodes, m_ast.m_variableCount);
+		}
+		return Rewind(pos, nodes, variables);
+	}
+
+	constexpr int EvaluateCalculation()
+	{
+		int result = EvaluateSum();
+		return result >= 0 && ReachedEnd() ? result : -1;
+	}
+
+	constexpr int EvaluateSum()
+	{
+		int pos = m_pos, nodes = m_ast.m_nodeCount, variables = m_ast.m_variableCount;
+		int lhs = EvaluateProduct();
+		while (lhs >= 0)
+		{
+			NodeKind kind = NodeKind::Add;
+			if (EvaluateCharacter('+'))
+				kind = NodeKind::Add;
+			else if (EvaluateCharacter('-'))
+				kind = NodeKind::Substract;
+			else
+				break;
+			int rhs = EvaluateProduct();
+			lhs = rhs >= 0 ? AddNode(kind, lhs, rhs) : -1;
+		}
+		return lhs >= 0 ? lhs : Rewind(pos, nodes, variables);
+	}
+
+	constexpr int EvaluateProduct()
+	{
+		int pos = m_pos, nodes = m_ast.m_nodeCount, variables = m_ast.m_variableCount;
+		int lhs = EvaluatePower();
+		while (lhs >= 0)
+		{
+			NodeKind kind = NodeKind::Multiply;
+			if (EvaluateCharacter('*'))
+				kind = NodeKind::Multiply;
+			else if (EvaluateCharacter('/'))
+				kind = NodeKind::Divide;
+			else if (EvaluateCharacter('%'))
+				kind = NodeKind::Modulus;
+			else
+				break;
+			int opPos = m_pos - 1;
+			int rhs = EvaluatePower();
+			lhs = rhs >= 0 ? AddNode(kind, lhs, rhs, 0, 0, opPos) : -1;
+		}
+		return lhs >= 0 ? lhs : Rewind(pos, nodes, variables);
+	}
+
+	constexpr int EvaluatePower()
+	{
+		int exp = EvaluateTerm();
+		if (exp < 0)
+			return exp;
+		int pos = m_pos, nodes = m_ast.m_nodeCount, variables = m_ast.m_variableCount;
+		int rhs = -1;
+		if (EvaluateCharacter('^') && (rhs = EvaluatePower()) >= 0)
+			return AddNode(NodeKind::Power, exp, rhs);
+		Rewind(pos, nodes, variables);
+		return exp;
+	}
+
+	constexpr int EvaluateTerm()
+	{
+		int exp = EvaluateGroup();
+		if (exp < 0)
+			exp = EvaluateFunction();
+		if (exp < 0)
+			exp = EvaluateVariable();
+		if (exp < 0)
+			exp = EvaluateNumber();
+		return exp;
+	}
+
+	constexpr int EvaluateGroup()
+	{
+		int pos = m_pos, nodes = m_ast.m_nodeCount, variables = m_ast.m_variableCount;
+		int exp = -1;
+		if (EvaluateCharacter('(') && (exp = EvaluateSum()) >= 0 && EvaluateCharacter(')'))
+			return exp;
+		return Rewind(pos, nodes, variables);
+	}
+
+	constexpr int EvaluateFunction()
+	{
+		int pos = m_pos, nodes = m_ast.m_nodeCount, variables = m_ast.m_variableCount;
+		int length = 0;
+		int offset = -1;
+
+		//prefix function, e.g. ++i
+		bool increment = EvaluateCharacters('+', '+');
+		if (increment || EvaluateCharacters('-', '-'))
+		{
+			if ((offset = EvaluateName(length)) >= 0)
+				return AddNode(increment ? NodeKind::PrefixIncrement : NodeKind::PrefixDecrement, -1, -1, GetVariable(offset, length));
+			return Rewind(pos, nodes, variables);
+		}
+
+		if ((offset = EvaluateName(length)) < 0)
+			return Rewind(pos, nodes, variables);
+
+		//postfix function, e.g. i++
+		increment = EvaluateCharacters('+', '+');
+		if (increment || EvaluateCharacters('-', '-'))
+			return AddNode(increment ? NodeKind::PostfixIncrement : NodeKind::PostfixDecrement, -1, -1, GetVariable(offset, length));
+
+		FunctionId func = GetFunction(offset, length);
+		if (func == FunctionId::None || !EvaluateCharacter('('))
+			return Rewind(pos, nodes, variables);
+
+		int first = EvaluateSum();
+		int second = -1;
+		bool binary = func >= FunctionId::Min;
+		if (first >= 0 && binary && EvaluateCharacter(',') && (second = EvaluateSum()) >= 0 && EvaluateCharacter(')'))
+			return AddNode(NodeKind::Call2, first, second, static_cast<int>(func));
+		if (first >= 0 && !binary && EvaluateCharacter(')'))
+			return AddNode(NodeKind::Call, first, -1, static_cast<int>(func));
+		return Rewind(pos, nodes, variables);
+	}
+
+	constexpr int EvaluateVariable()
+	{
+		int length = 0;
+		int offset = EvaluateName(length);
+		return offset >= 0 ? AddNode(NodeKind::Variable, -1, -1, GetVariable(offset, length)) : -1;
+	}
+
+	constexpr int EvaluateNumber()
+	{
+		SkipWhiteSpaces();
+		if (m_pos >= m_length || !IsDigit(m_text[m_pos]))
+			return -1;
+
+		//a mantissa below 2^53 and a power of ten up to 10^22 are exact, so one division or
+		//multiplication rounds like strtod. Longer mantissas or larger exponents round more than
+		//once and may be an ulp away from it
+		double mantissa = 0;
+		int exponent = 0;
+		for (; m_pos < m_length && IsDigit(m_text[m_pos]); ++m_pos)
+			mantissa = mantissa * 10 + (m_text[m_pos] - '0');
+		if (m_pos < m_length && m_text[m_pos] == '.')
+			for (++m_pos; m_pos < m_length && IsDigit(m_text[m_pos]); ++m_pos, --exponent)
+				mantissa = mantissa * 10 + (m_text[m_pos] - '0');
+		if (m_pos + 1 < m_length && (m_text[m_pos] == 'e' || m_text[m_pos] == 'E'))
+		{
+			int pos = m_pos + 1;
+			bool negative = m_text[pos] == '-';
+			if (m_text[pos] == '+' || m_text[pos] == '-')
+				++pos;
+			if (pos < m_length && IsDigit(m_text[pos]))
+			{
+				int value = 0;
+				for (; pos < m_length && IsDigit(m_text[pos]); ++pos)
+					value = value * 10 + (m_text[pos] - '0');
+				exponent += negative ? -value : value;
+				m_pos = pos;
+			}
+		}
+
+		double scale = 1;
+		for (int i = 0; i < (exponent < 0 ? -exponent : exponent); ++i)
+			scale *= 10;
+		return AddNode(NodeKind::Number, -1, -1, 0, exponent < 0 ? mantissa / scale : mantissa * scale);
+	}
+
+	const char *m_text;
+	int m_length;
+	int m_pos = 0;
+	Ast<N> m_ast{};
+};
+
+/*
+	Literal class holds a statement and its Ast, both computed by the compiler
+*/
+template <char... Cs>
+struct Literal
+{
+	static constexpr char s_text[] = {Cs..., '\0'};
+	static constexpr size_t s_length = sizeof...(Cs);
+	static constexpr Ast<sizeof...(Cs) + 2> ast = AstParser<sizeof...(Cs) + 2>(s_text, s_length).Parse();
+	static_assert(ast.m_root >= 0, "compiletime: the statement does not follow the Parser grammar");
+};
+
+template <FunctionId F>
+inline double ApplyFunction(double x)
+{
+	if constexpr (F == FunctionId::Sin) return std::sin(x);
+	else if constexpr (F == FunctionId::Asin) return std::asin(x);
+	else if constexpr (F == FunctionId::Cos) return std::cos(x);
+	else if constexpr (F == FunctionId::Acos) return std::acos(x);
+	else if constexpr (F == FunctionId::Tan) return std::tan(x);
+	else if constexpr (F == FunctionId::Atan) return std::atan(x);
+	else if constexpr (F == FunctionId::Ceil) return std::ceil(x);
+	else return std::floor(x);
+}
+
+template <FunctionId F>
+inline double ApplyFunction(double x, double y)
+{
+	if constexpr (F == FunctionId::Min) return std::fmin(x, y);
+	else if constexpr (F == FunctionId::Max) return std::fmax(x, y);
+	else if constexpr (F == FunctionId::Atan2) return std::atan2(x, y);
+	else return std::pow(x, y);
+}
+
+/*
+	Expression template nodes, Env is a BoundExpression
+*/
+template <double (*Value)()>
+struct NumberNode
+{
+	template <typename Env> static double Evaluate(Env &) { return Value(); }
+};
+
+template <int V>
+struct VariableNode
+{
+	template <typename Env> static double Evaluate(Env &env) { return env.Lookup(V); }
+};
+
+template <NodeKind K, typename Lhs, typename Rhs, int Position>
+struct ArithmeticNode
+{
+	template <typename Env> static double Evaluate(Env &env)
+	{
+		double a = Lhs::Evaluate(env);
+		double b = Rhs::Evaluate(env);
+		if constexpr (K == NodeKind::Add) return a + b;
+		else if constexpr (K == NodeKind::Substract) return a - b;
+		else if constexpr (K == NodeKind::Multiply) return a * b;
+		else if constexpr (K == NodeKind::Power) return std::pow(a, b);
+		else if constexpr (K == NodeKind::Divide)
+		{
+			if (b == 0.0)
+			{
+				env.ReportError(ErrorCode::DivisionByZero, Position);
+				return 0;
+			}
+			return a / b;
+		}
+		else
+		{
+			if (b == 0.0)
+			{
+				env.ReportError(ErrorCode::ModulusByZero, Position);
+				return 0;
+			}
+			return std::fmod(a, b);
+		}
+	}
+};
+
+template <FunctionId F, typename Arg>
+struct CallNode
+{
+	template <typename Env> static double Evaluate(Env &env) { return ApplyFunction<F>(Arg::Evaluate(env)); }
+};
+
+template <FunctionId F, typename Lhs, typename Rhs>
+struct Call2Node
+{
+	template <typename Env> static double Evaluate(Env &env)
+	{
+		double a = Lhs::Evaluate(env);
+		return ApplyFunction<F>(a, Rhs::Evaluate(env));
+	}
+};
+
+template <int V, int Delta, bool Prefix>
+struct IncrementNode
+{
+	template <typename Env> static double Evaluate(Env &env)
+	{
+		double value = env.Lookup(V);
+		env.Record(V, value + Delta);
+		return Prefix ? value + Delta : value;
+	}
+};
+
+template <int V, typename Value>
+struct AssignNode
+{
+	template <typename Env> static double Evaluate(Env &env)
+	{
+		double x = Value::Evaluate(env);
+		env.Record(V, x);
+		return x;
+	}
+};
+
+//Map node I of the Ast of literal L to its expression template type
+template <typename L, int I, NodeKind K = L::ast.m_nodes[I].m_kind>
+struct Build
+{
+	static constexpr const Node &node = L::ast.m_nodes[I];
+	using type = ArithmeticNode<K, typename Build<L, node.m_left>::type, typename Build<L, node.m_right>::type, node.m_position>;
+};
+
+template <typename L, int I>
+struct Build<L, I, NodeKind::Number>
+{
+	static constexpr double Value() { return L::ast.m_nodes[I].m_value; }
+	using type = NumberNode<&Value>;
+};
+
+template <typename L, int I>
+struct Build<L, I, NodeKind::Variable>
+{
+	using type = VariableNode<L::ast.m_nodes[I].m_index>;
+};
+
+template <typename L, int I>
+struct Build<L, I, NodeKind::Call>
+{
+	static constexpr const Node &node = L::ast.m_nodes[I];
+	using type = CallNode<static_cast<FunctionId>(node.m_index), typename Build<L, node.m_left>::type>;
+};
+
+template <typename L, int I>
+struct Build<L, I, NodeKind::Call2>
+{
+	static constexpr const Node &node = L::ast.m_nodes[I];
+	using type = Call2Node<static_cast<FunctionId>(node.m_index), typename Build<L, node.m_left>::type, typename Build<L, node.m_right>::type>;
+};
+
+template <typename L, int I>
+struct Build<L, I, NodeKind::PrefixIncrement> { using type = IncrementNode<L::ast.m_nodes[I].m_index, 1, true>; };
+template <typename L, int I>
+struct Build<L, I, NodeKind::PrefixDecrement> { using type = IncrementNode<L::ast.m_nodes[I].m_index, -1, true>; };
+template <typename L, int I>
+struct Build<L, I, NodeKind::PostfixIncrement> { using type = IncrementNode<L::ast.m_nodes[I].m_index, 1, false>; };
+template <typename L, int I>
+struct Build<L, I, NodeKind::PostfixDecrement> { using type = IncrementNode<L::ast.m_nodes[I].m_index, -1, false>; };
+
+template <typename L, int I>
+struct Build<L, I, NodeKind::Assign>
+{
+	static constexpr const Node &node = L::ast.m_nodes[I];
+	using type = AssignNode<node.m_index, typename Build<L, node.m_left>::type>;
+};
+
+/*
+	BoundExpression class holds the slots of the variables of a literal in a Parser
+*/
+template <typename L>
+class BoundExpression
+{
+public:
+	using Root = typename Build<L, L::ast.m_root>::type;
+
+	BoundExpression(Parser &parser)
+		: m_parser(&parser)
+	{
+		for (int i = 0; i < L::ast.m_variableCount; ++i)
+		{
+			const VariableName &var = L::ast.m_variables[i];
+			m_slots[i] = parser.GetVariableSlot(std::string(L::s_text + var.m_offset, var.m_length));
+		}
+	}
+
+	double Evaluate() { return Root::Evaluate(*this); }
+
+	double Lookup(int var) const { return m_parser->LookupVariable(m_slots[var]); }
+	void Record(int var, double value) { m_parser->RecordVariable(m_slots[var], value); }
+	void ReportError(ErrorCode code, int position) { m_parser->ReportError(code, position); }
+
+private:
+	Parser *m_parser;
+	std::array<size_t, (L::ast.m_variableCount > 0 ? L::ast.m_variableCount : 1)> m_slots{};
+};
+
+/*
+	StaticExpression class is the value of a _expr literal
+*/
+template <typename L>
+class StaticExpression
+{
+public:
+	static constexpr const char* GetText() { return L::s_text; }
+
+	//Resolve the variables once to evaluate many times
+	BoundExpression<L> Bind(Parser &parser) const { return BoundExpression<L>(parser); }
+	double Evaluate(Parser &parser) const { return Bind(parser).Evaluate(); }
+};
+
+namespace literals
+{
+template <typename Char, Char... Cs>
+constexpr StaticExpression<Literal<Cs...>> operator""_expr()
+{
+	return {};
+}
+}
+
+}
@@ -0,0 +1,332 @@
+#include "CompiledCache.h"
+#include "Parser.h"
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+
+static const char s_magic[8] = {'E', 'X', 'P', 'R', 'C', 'A', 'C', 'H'};
+
+//Index of name in names, appended if it is not there yet
+static size_t
+IndexOf(std::vector<std::string> &names, const std::string &name)
+{
+	auto find = std::find(names.begin(), names.end(), name);
+	if (find != names.end())
+		return find - names.begin();
+	names.push_back(name);
+	return names.size() - 1;
+}
+
+uint64_t
+CompiledCache::GetKey(const std::string &statement)
+{
+	uint64_t hash = Parser::GetFunctionTableVersion();
+	for (unsigned char c : statement)
+	{
+		hash ^= c;
+		hash *= 1099511628211ull;
+	}
+	return hash;
+}
+
+void
+CompiledCache::Store(const std::string &statement, const Parser &parser, const CompiledExpression &compiled)
+{
+	//a definition compiles to nothing, it must be read to define its function
+	if (compiled.Empty())
+		return;
+
+	Entry entry;
+	entry.m_statement = statement;
+	entry.m_code.reserve(compiled.GetCode().size());
+	for (Instruction instruction : compiled.GetCode())
+	{
+		switch (instruction.m_op)
+		{
+		case OpCode::Variable:
+		case OpCode::Assign:
+		case OpCode::Increment:
+		case OpCode::PostIncrement:
+		case OpCode::LoopBegin:
+		case OpCode::LoopEnd:
+			instruction.m_index = IndexOf(entry.m_variables, parser.GetVariableName(instruction.m_index));
+			break;
+		case OpCode::Call:
+		{
+			std::string name = parser.GetFunctionName(compiled.GetFunctions()[instruction.m_index]);
+			if (name.empty())
+				return;
+			instruction.m_index = IndexOf(entry.m_functions, name);
+			break;
+		}
+		case OpCode::Call2:
+		{
+			std::string name = parser.GetFunctionName(compiled.GetBinaryFunctions()[instruction.m_index]);
+			if (name.empty())
+				return;
+			instruction.m_index = IndexOf(entry.m_binaryFunctions, name);
+			break;
+		}
+		case OpCode::Argument:
+		case OpCode::Return:
+			//the body of a user function may be defined again
+			return;
+		default:
+			break;
+		}
+		entry.m_code.push_back(instruction);
+	}
+	for (size_t slot : parser.GetRequiredVariables())
+		entry.m_required.push_back(parser.GetVariableName(slot));
+	entry.m_undefined = parser.GetUndefinedVariables();
+
+	m_entries[GetKey(statement)] = std::move(entry);
+}
+
+bool
+CompiledCache::Lookup(const std::string &statement, Parser &parser, CompiledExpression &compiled)
+{
+	auto find = m_entries.find(GetKey(statement));
+	bool found = find != m_entries.end() && find->second.m_statement == statement;
+	for (size_t i = 0; found && i < find->second.m_required.size(); ++i)
+		found = parser.HasVariable(find->second.m_required[i]);
+	for (size_t i = 0; found && i < find->second.m_undefined.size(); ++i)
+		found = !parser.HasVariable(find->second.m_undefined[i]);
+	if (!found)
+	{
+		++m_misses;
+		return false;
+	}
+
+	const Entry &entry = find->second;
+	std::vector<const CompiledExpression::Function*> functions;
+	std::vector<const CompiledExpression::BinaryFunction*> binaryFunctions;
+	for (const std::string &name : entry.m_functions)
+		functions.push_back(parser.GetFunction(name));
+	for (const std::string &name : entry.m_binaryFunctions)
+		binaryFunctions.push_back(parser.GetBinaryFunction(name));
+	if (std::count(functions.begin(), functions.end(), nullptr) || std::count(binaryFunctions.begin(), binaryFunctions.end(), nullptr))
+	{
+		++m_misses;
+		return false;
+	}
+
+	std::vector<size_t> slots;
+	slots.reserve(entry.m_variables.size());
+	for (const std::string &name : entry.m_variables)
+		slots.push_back(parser.GetVariableSlot(name));
+
+	compiled.Clear();
+	std::vector<size_t> loops;
+	for (const Instruction &instruction : entry.m_code)
+	{
+		switch (instruction.m_op)
+		{
+		case OpCode::Number:
+			compiled.AddNumber(instruction.m_value);
+			break;
+		case OpCode::Variable:
+			compiled.AddVariable(slots[instruction.m_index]);
+			break;
+		case OpCode::Assign:
+			compiled.AddAssign(slots[instruction.m_index]);
+			break;
+		case OpCode::Increment:
+		case OpCode::PostIncrement:
+			compiled.AddIncrement(slots[instruction.m_index], instruction.m_value, instruction.m_op == OpCode::Increment);
+			break;
+		case OpCode::Call:
+			compiled.AddCall(functions[instruction.m_index]);
+			break;
+		case OpCode::Call2:
+			compiled.AddCall(binaryFunctions[instruction.m_index]);
+			break;
+		case OpCode::Pop:
+			compiled.AddPop();
+			break;
+		case OpCode::LoopBegin:
+			loops.push_back(compiled.AddLoopBegin(slots[instruction.m_index]));
+			break;
+		case OpCode::LoopEnd:
+			compiled.AddLoopEnd(slots[instruction.m_index], loops.back());
+			loops.pop_back();
+			break;
+		default:
+			compiled.AddOperation(instruction.m_op, instruction.m_position);
+			break;
+		}
+	}
+	++m_hits;
+	return true;
+}
+
+template <typename T>
+static void
+Write(std::string &buffer, T value)
+{
+	buffer.append(reinterpret_cast<const char*>(&value), sizeof(value));
+}
+
+static void
+WriteString(std::string &buffer, const std::string &text)
+{
+	Write(buffer, static_cast<uint32_t>(text.size()));
+	buffer += text;
+}
+
+static void
+WriteStrings(std::string &buffer, const std::vector<std::string> &texts)
+{
+	Write(buffer, static_cast<uint32_t>(texts.size()));
+	for (const std::string &text : texts)
+		WriteString(buffer, text);
+}
+
+/*
+	Reader utility class to read a file in memory, every read fails once one did
+*/
+struct Reader
+{
+	const char *m_data;
+	size_t m_size;
+	size_t m_offset = 0;
+	bool m_failed = false;
+
+	template <typename T>
+	T Read()
+	{
+		T value{};
+		if (m_failed || m_size - m_offset < sizeof(value))
+		{
+			m_failed = true;
+			return value;
+		}
+		std::memcpy(&value, m_data + m_offset, sizeof(value));
+		m_offset += sizeof(value);
+		return value;
+	}
+
+	std::string ReadString()
+	{
+		uint32_t length = Read<uint32_t>();
+		if (m_failed || m_size - m_offset < length)
+		{
+			m_failed = true;
+			return std::string();
+		}
+		m_offset += length;
+		return std::string(m_data + m_offset - length, length);
+	}
+
+	std::vector<std::string> ReadStrings()
+	{
+		std::vector<std::string> texts(std::min<size_t>(Read<uint32_t>(), m_size));
+		for (std::string &text : texts)
+			text = ReadString();
+		return texts;
+	}
+};
+
+bool
+CompiledCache::Save(const std::string &path) const
+{
+	std::string buffer(s_magic, sizeof(s_magic));
+	Write(buffer, static_cast<uint32_t>(s_formatVersion));
+	Write(buffer, Parser::GetFunctionTableVersion());
+	Write(buffer, static_cast<uint32_t>(m_entries.size()));
+	for (const auto &key : m_entries)
+	{
+		const Entry &entry = key.second;
+		WriteString(buffer, entry.m_statement);
+		WriteStrings(buffer, entry.m_variables);
+		WriteStrings(buffer, entry.m_functions);
+		WriteStrings(buffer, entry.m_binaryFunctions);
+		WriteStrings(buffer, entry.m_required);
+		WriteStrings(buffer, entry.m_undefined);
+		Write(buffer, static_cast<uint32_t>(entry.m_code.size()));
+		for (const Instruction &instruction : entry.m_code)
+		{
+			Write(buffer, static_cast<uint8_t>(instruction.m_op));
+			Write(buffer, static_cast<int32_t>(instruction.m_position));
+			Write(buffer, static_cast<uint32_t>(instruction.m_index));
+			Write(buffer, instruction.m_value);
+		}
+	}
+
+	std::ofstream file(path, std::ios::binary | std::ios::trunc);
+	file.write(buffer.data(), buffer.size());
+	return static_cast<bool>(file.flush());
+}
+
+bool
+CompiledCache::Load(const std::string &path)
+{
+	m_entries.clear();
+	m_versionMismatch = false;
+	std::ifstream file(path, std::ios::binary);
+	if (!file)
+		return false;
+	std::string data((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+
+	Reader reader{data.data(), data.size()};
+	if (data.size() < sizeof(s_magic) || std::memcmp(data.data(), s_magic, sizeof(s_magic)) != 0)
+		return false;
+	reader.m_offset = sizeof(s_magic);
+	uint32_t format = reader.Read<uint32_t>();
+	uint64_t functions = reader.Read<uint64_t>();
+	if (reader.m_failed || format != s_formatVersion || functions != Parser::GetFunctionTableVersion())
+	{
+		m_versionMismatch = true;
+		return false;
+	}
+
+	uint32_t count = reader.Read<uint32_t>();
+	for (uint32_t i = 0; i < count && !reader.m_failed; ++i)
+	{
+		Entry entry;
+		size_t loops = 0;
+		entry.m_statement = reader.ReadString();
+		entry.m_variables = reader.ReadStrings();
+		entry.m_functions = reader.ReadStrings();
+		entry.m_binaryFunctions = reader.ReadStrings();
+		entry.m_required = reader.ReadStrings();
+		entry.m_undefined = reader.ReadStrings();
+		uint32_t instructions = reader.Read<uint32_t>();
+		for (uint32_t j = 0; j < instructions && !reader.m_failed; ++j)
+		{
+			Instruction instruction;
+			uint8_t op = reader.Read<uint8_t>();
+			instruction.m_op = static_cast<OpCode>(op);
+			instruction.m_position = reader.Read<int32_t>();
+			instruction.m_index = reader.Read<uint32_t>();
+			instruction.m_value = reader.Read<double>();
+
+			//names must exist and only instructions Store keeps are accepted
+			size_t names = op == static_cast<uint8_t>(OpCode::Call) ? entry.m_functions.size() :
+				op == static_cast<uint8_t>(OpCode::Call2) ? entry.m_binaryFunctions.size() : entry.m_variables.size();
+			bool named = instruction.m_op == OpCode::Variable || instruction.m_op == OpCode::Assign ||
+				instruction.m_op == OpCode::Increment || instruction.m_op == OpCode::PostIncrement ||
+				instruction.m_op == OpCode::Call || instruction.m_op == OpCode::Call2 ||
+				instruction.m_op == OpCode::LoopBegin || instruction.m_op == OpCode::LoopEnd;
+			//every loop end closes a loop begin
+			if (instruction.m_op == OpCode::LoopBegin)
+				++loops;
+			else if (instruction.m_op == OpCode::LoopEnd && !loops--)
+				reader.m_failed = true;
+			if (op > static_cast<uint8_t>(OpCode::LoopEnd) || instruction.m_op == OpCode::Argument || instruction.m_op == OpCode::Return ||
+				(named && instruction.m_index >= names))
+				reader.m_failed = true;
+			entry.m_code.push_back(instruction);
+		}
+		if (loops)
+			reader.m_failed = true;
+		if (!reader.m_failed)
+			m_entries[GetKey(entry.m_statement)] = std::move(entry);
+	}
+
+	if (reader.m_failed)
+		m_entries.clear();
+	return !reader.m_failed;
+}
@@ -0,0 +1,70 @@
+#pragma once
+#include "CompiledExpression.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+class Parser;
+
+/*
+	CompiledCache class keeps the compiled form of statements by the hash of their text,
+	so a Parser using it reads a statement it already compiled only once, see Parser::SetCompiledCache.
+	The cache can be saved to a file and loaded by the next run.
+
+	An entry names its variables and functions instead of holding slots and pointers,
+	it is bound to the parser at every hit. Only statements whose compiled form does not
+	depend on what was read before are stored: not definitions nor calls of user functions.
+	A statement which was only valid with some variables defined, e.g. i++, is found only
+	while they are defined, and one read while some were undefined, e.g. x+++y read as
+	x + ++y, only while they are still undefined.
+*/
+class CompiledCache
+{
+public:
+	static const unsigned int s_formatVersion = 2;
+
+	//Replace the entries by those of the file. False if the file could not be read, or was
+	//written for another format or function table, the cache is then empty
+	bool Load(const std::string &path);
+	//False if the file could not be written
+	bool Save(const std::string &path) const;
+
+	//Fill compiled with the entry of statement bound to the variables of parser, false on a miss
+	bool Lookup(const std::string &statement, Parser &parser, CompiledExpression &compiled);
+	//Store what parser just compiled for statement, if it can be reused
+	void Store(const std::string &statement, const Parser &parser, const CompiledExpression &compiled);
+
+	void Clear() { m_entries.clear(); }
+	size_t GetEntries() const { return m_entries.size(); }
+	size_t GetHits() const { return m_hits; }
+	size_t GetMisses() const { return m_misses; }
+	//Whether the last Load found a file of another version
+	bool HadVersionMismatch() const { return m_versionMismatch; }
+
+	//Key of a statement, its text hashed with the function table version
+	static uint64_t GetKey(const std::string &statement);
+
+private:
+	/*
+		Entry utility class to hold a compiled statement without references to a parser
+		m_index of an instruction is the index of its name in m_variables or in the functions
+	*/
+	struct Entry
+	{
+		std::string m_statement;
+		std::vector<Instruction> m_code;
+		std::vector<std::string> m_variables;
+		std::vector<std::string> m_functions;
+		std::vector<std::string> m_binaryFunctions;
+		std::vector<std::string> m_required;
+		std::vector<std::string> m_undefined;
+	};
+
+	std::unordered_map<uint64_t, Entry> m_entries;
+	size_t m_hits = 0;
+	size_t m_misses = 0;
+	bool m_versionMismatch = false;
+};
@@ -0,0 +1,190 @@
+#include "CompiledExpression.h"
+#include "Parser.h"
+
+void
+CompiledExpression::Clear()
+{
+	m_code.clear();
+	m_functions.clear();
+	m_binaryFunctions.clear();
+	m_depth = 0;
+	m_maxDepth = 0;
+}
+
+void
+CompiledExpression::SetArguments(size_t arguments)
+{
+	Clear();
+	m_depth = arguments;
+	m_maxDepth = arguments;
+}
+
+void
+CompiledExpression::Add(const Instruction &instruction, int stackEffect)
+{
+	m_code.push_back(instruction);
+	m_depth += stackEffect;
+	if (m_depth > m_maxDepth)
+		m_maxDepth = m_depth;
+}
+
+void
+CompiledExpression::AddNumber(double value)
+{
+	Add(Instruction{OpCode::Number, -1, 0, value}, 1);
+}
+
+void
+CompiledExpression::AddVariable(size_t slot)
+{
+	Add(Instruction{OpCode::Variable, -1, slot, 0}, 1);
+}
+
+void
+CompiledExpression::AddAssign(size_t slot)
+{
+	Add(Instruction{OpCode::Assign, -1, slot, 0}, 0);
+}
+
+void
+CompiledExpression::AddIncrement(size_t slot, double step, bool prefix)
+{
+	Add(Instruction{prefix ? OpCode::Increment : OpCode::PostIncrement, -1, slot, step}, 1);
+}
+
+void
+CompiledExpression::AddOperation(OpCode op, int position)
+{
+	Add(Instruction{op, position, 0, 0}, -1);
+}
+
+void
+CompiledExpression::AddCall(const Function *function)
+{
+	Add(Instruction{OpCode::Call, -1, m_functions.size(), 0}, 0);
+	m_functions.push_back(function);
+}
+
+void
+CompiledExpression::AddCall(const BinaryFunction *function)
+{
+	Add(Instruction{OpCode::Call2, -1, m_binaryFunctions.size(), 0}, -1);
+	m_binaryFunctions.push_back(function);
+}
+
+void
+CompiledExpression::AddArgument(size_t index)
+{
+	Add(Instruction{OpCode::Argument, -1, index, 0}, 1);
+}
+
+void
+CompiledExpression::AddPop()
+{
+	Add(Instruction{OpCode::Pop, -1, 0, 0}, -1);
+}
+
+size_t
+CompiledExpression::AddLoopBegin(size_t slot)
+{
+	//the exit is known once the body is compiled
+	Add(Instruction{OpCode::LoopBegin, -1, slot, 0}, 0);
+	return m_code.size() - 1;
+}
+
+void
+CompiledExpression::AddLoopEnd(size_t slot, size_t begin)
+{
+	//the counter stays on the stack as the value of the loop
+	Add(Instruction{OpCode::LoopEnd, -1, slot, static_cast<double>(begin + 1)}, -1);
+	m_code[begin].m_value = static_cast<double>(m_code.size());
+}
+
+void
+CompiledExpression::Inline(const CompiledExpression &body, size_t arguments)
+{
+	//the body addresses its arguments from the bottom of its own stack
+	size_t frame = m_depth - arguments;
+	size_t functions = m_functions.size();
+	size_t binaryFunctions = m_binaryFunctions.size();
+	m_functions.insert(m_functions.end(), body.m_functions.begin(), body.m_functions.end());
+	m_binaryFunctions.insert(m_binaryFunctions.end(), body.m_binaryFunctions.begin(), body.m_binaryFunctions.end());
+
+	for (Instruction instruction : body.m_code)
+	{
+		if (instruction.m_op == OpCode::Argument)
+			instruction.m_index += frame;
+		else if (instruction.m_op == OpCode::Call)
+			instruction.m_index += functions;
+		else if (instruction.m_op == OpCode::Call2)
+			instruction.m_index += binaryFunctions;
+		m_code.push_back(instruction);
+	}
+	if (frame + body.m_maxDepth > m_maxDepth)
+		m_maxDepth = frame + body.m_maxDepth;
+	m_depth = frame + body.m_depth;
+
+	Add(Instruction{OpCode::Return, -1, arguments, 0}, -static_cast<int>(arguments));
+}
+
+void
+CompiledExpression::Append(const CompiledExpression &code, const std::vector<size_t> &slots)
+{
+	size_t frame = m_depth;
+	size_t offset = m_code.size();
+	size_t functions = m_functions.size();
+	size_t binaryFunctions = m_binaryFunctions.size();
+	m_functions.insert(m_functions.end(), code.m_functions.begin(), code.m_functions.end());
+	m_binaryFunctions.insert(m_binaryFunctions.end(), code.m_binaryFunctions.begin(), code.m_binaryFunctions.end());
+
+	for (Instruction instruction : code.m_code)
+	{
+		switch (instruction.m_op)
+		{
+		case OpCode::Variable:
+		case OpCode::Assign:
+		case OpCode::Increment:
+		case OpCode::PostIncrement:
+			instruction.m_index = slots[instruction.m_index];
+			break;
+		case OpCode::LoopBegin:
+		case OpCode::LoopEnd:
+			instruction.m_index = slots[instruction.m_index];
+			instruction.m_value += static_cast<double>(offset);
+			break;
+		case OpCode::Argument:
+			instruction.m_index += frame;
+			break;
+		case OpCode::Call:
+			instruction.m_index += functions;
+			break;
+		case OpCode::Call2:
+			instruction.m_index += binaryFunctions;
+			break;
+		default:
+			break;
+		}
+		m_code.push_back(instruction);
+	}
+	if (frame + code.m_maxDepth > m_maxDepth)
+		m_maxDepth = frame + code.m_maxDepth;
+	m_depth = frame + code.m_depth;
+}
+
+double
+CompiledExpression::Call(Parser &parser, const Function &function, double a)
+{
+	return parser.CallFunction(function, a);
+}
+
+double
+CompiledExpression::Call(Parser &parser, const BinaryFunction &function, double a, double b)
+{
+	return parser.CallFunction(function, a, b);
+}
+
+double
+CompiledExpression::Evaluate(Parser *parser, std::vector<double> &stack, size_t arguments) const
+{
+	return Evaluate<double>(*parser, stack, arguments);
+}
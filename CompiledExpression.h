@@ -0,0 +1,236 @@
+#pragma once
+#include "ErrorCode.h"
+#include "Numeric.h"
+#include <cstddef>
+#include <functional>
+#include <vector>
+
+class Parser;
+
+/*
+	OpCode enumerates the instructions of a CompiledExpression
+*/
+enum class OpCode : unsigned char
+{
+	Number,			//push m_value
+	Variable,		//push the variable of slot m_index
+	Assign,			//store the top of the stack in the variable of slot m_index, the value stays on the stack
+	Increment,		//add m_value to the variable of slot m_index, push the new value
+	PostIncrement,	//add m_value to the variable of slot m_index, push the previous value
+	Add,			//pop rhs and lhs, push lhs OP rhs
+	Substract,
+	Multiply,
+	Divide,
+	Modulus,
+	Power,
+	Call,			//replace the top of the stack by function m_index applied on it
+	Call2,			//pop rhs and lhs, push binary function m_index applied on them
+	Argument,		//push the value at index m_index of the stack, an argument of an inlined function
+	Return,			//pop the result and m_index arguments below it, push the result
+	Pop,			//pop the value of a statement of a loop body
+	LoopBegin,		//with the end on top of the counter: if counter < end store the counter in the variable
+					//of slot m_index, otherwise pop the end and jump to the instruction of index m_value
+	LoopEnd			//increment the counter, if counter < end store it in the variable of slot m_index and jump
+					//to the instruction of index m_value, otherwise pop the end
+};
+
+/*
+	Instruction utility class to hold a single operation of a CompiledExpression
+*/
+struct Instruction
+{
+	OpCode m_op;
+	int m_position;
+	size_t m_index;
+	double m_value;
+};
+
+/*
+	CompiledExpression class holds an expression tree flattened in postfix order.
+	It is evaluated by a loop over the instructions with an explicit stack of values,
+	so the depth of the tree does not consume the native stack and there is no
+	virtual call per node.
+*/
+class CompiledExpression
+{
+public:
+	using Function = std::function<double(double)>;
+	using BinaryFunction = std::function<double(double, double)>;
+
+	void Clear();
+	bool Empty() const { return m_code.empty(); }
+
+	//Start the body of a function, its arguments are the first values of the stack
+	void SetArguments(size_t arguments);
+
+	void AddNumber(double value);
+	void AddVariable(size_t slot);
+	void AddAssign(size_t slot);
+	void AddIncrement(size_t slot, double step, bool prefix);
+	void AddOperation(OpCode op, int position = -1);
+	void AddCall(const Function *function);
+	void AddCall(const BinaryFunction *function);
+	void AddArgument(size_t index);
+	void AddPop();
+	//Start a loop over the variable of slot, the counter and the end being on the stack.
+	//Returns the index of the instruction to give to AddLoopEnd after the body
+	size_t AddLoopBegin(size_t slot);
+	void AddLoopEnd(size_t slot, size_t begin);
+
+	//Append a function body, its arguments being the last arguments values added
+	void Inline(const CompiledExpression &body, size_t arguments);
+	//Append code compiled by another parser, which pushes its value after those already on the
+	//stack. slots gives the slot here of each slot of code
+	void Append(const CompiledExpression &code, const std::vector<size_t> &slots);
+
+	const std::vector<Instruction>& GetCode() const { return m_code; }
+	//Functions of the Call and Call2 instructions by m_index
+	const std::vector<const Function*>& GetFunctions() const { return m_functions; }
+	const std::vector<const BinaryFunction*>& GetBinaryFunctions() const { return m_binaryFunctions; }
+
+	//Evaluate against the variables of parser, stack is a scratch buffer reused between calls.
+	//For a function body the first arguments values of stack are its arguments
+	double Evaluate(Parser *parser, std::vector<double> &stack, size_t arguments = 0) const;
+
+	//Evaluate in the value type T, see Numeric. Environment holds the variables by slot:
+	//T LookupVariable(size_t), void RecordVariable(size_t, T) and void ReportError(ErrorCode, int)
+	template <typename T, typename Environment>
+	T Evaluate(Environment &environment, std::vector<T> &stack, size_t arguments = 0) const;
+
+private:
+	void Add(const Instruction &instruction, int stackEffect);
+
+	//Call a function of the maps, evaluated against a Parser through its function cache, see
+	//Parser::SetFunctionCache
+	template <typename T, typename Environment>
+	static T Call(Environment &, const Function &function, T a) { return Numeric<T>::Call(function, a); }
+	template <typename T, typename Environment>
+	static T Call(Environment &, const BinaryFunction &function, T a, T b) { return Numeric<T>::Call(function, a, b); }
+	static double Call(Parser &parser, const Function &function, double a);
+	static double Call(Parser &parser, const BinaryFunction &function, double a, double b);
+
+	std::vector<Instruction> m_code;
+	std::vector<const Function*> m_functions;
+	std::vector<const BinaryFunction*> m_binaryFunctions;
+	size_t m_depth = 0;
+	size_t m_maxDepth = 0;
+};
+
+template <typename T, typename Environment>
+T
+CompiledExpression::Evaluate(Environment &environment, std::vector<T> &stack, size_t arguments) const
+{
+	using Arithmetic = Numeric<T>;
+	if (m_code.empty())
+		return T(0);
+	if (stack.size() < m_maxDepth)
+		stack.resize(m_maxDepth);
+
+	T *base = stack.data();
+	T *top = base + arguments - 1;
+	const Instruction *code = m_code.data();
+	for (const Instruction *next = code, *end = code + m_code.size(); next != end;)
+	{
+		const Instruction &instruction = *next++;
+		switch (instruction.m_op)
+		{
+		case OpCode::Number:
+			*++top = Arithmetic::FromDouble(instruction.m_value);
+			break;
+		case OpCode::Variable:
+			*++top = environment.LookupVariable(instruction.m_index);
+			break;
+		case OpCode::Assign:
+			environment.RecordVariable(instruction.m_index, *top);
+			break;
+		case OpCode::Increment:
+		case OpCode::PostIncrement:
+		{
+			T value = environment.LookupVariable(instruction.m_index);
+			T incremented = Arithmetic::Add(value, Arithmetic::FromDouble(instruction.m_value));
+			environment.RecordVariable(instruction.m_index, incremented);
+			*++top = instruction.m_op == OpCode::Increment ? incremented : value;
+			break;
+		}
+		case OpCode::Add:
+			--top;
+			top[0] = Arithmetic::Add(top[0], top[1]);
+			break;
+		case OpCode::Substract:
+			--top;
+			top[0] = Arithmetic::Substract(top[0], top[1]);
+			break;
+		case OpCode::Multiply:
+			--top;
+			top[0] = Arithmetic::Multiply(top[0], top[1]);
+			break;
+		case OpCode::Divide:
+			--top;
+			if (Arithmetic::IsZero(top[1]))
+			{
+				environment.ReportError(ErrorCode::DivisionByZero, instruction.m_position);
+				top[0] = T(0);
+			}
+			else
+				top[0] = Arithmetic::Divide(top[0], top[1]);
+			break;
+		case OpCode::Modulus:
+			--top;
+			if (Arithmetic::IsZero(top[1]))
+			{
+				environment.ReportError(ErrorCode::ModulusByZero, instruction.m_position);
+				top[0] = T(0);
+			}
+			else
+				top[0] = Arithmetic::Modulus(top[0], top[1]);
+			break;
+		case OpCode::Power:
+			--top;
+			top[0] = Arithmetic::Power(top[0], top[1]);
+			break;
+		case OpCode::Call:
+			top[0] = Call(environment, *m_functions[instruction.m_index], top[0]);
+			break;
+		case OpCode::Call2:
+			--top;
+			top[0] = Call(environment, *m_binaryFunctions[instruction.m_index], top[0], top[1]);
+			break;
+		case OpCode::Argument:
+			top[1] = base[instruction.m_index];
+			++top;
+			break;
+		case OpCode::Return:
+			top[-static_cast<ptrdiff_t>(instruction.m_index)] = top[0];
+			top -= instruction.m_index;
+			break;
+		case OpCode::Pop:
+			--top;
+			break;
+		case OpCode::LoopBegin:
+			if (Arithmetic::ToDouble(top[-1]) < Arithmetic::ToDouble(top[0]))
+				environment.RecordVariable(instruction.m_index, top[-1]);
+			else
+			{
+				--top;
+				next = code + static_cast<size_t>(instruction.m_value);
+			}
+			break;
+		case OpCode::LoopEnd:
+		{
+			double previous = Arithmetic::ToDouble(top[-1]);
+			top[-1] = Arithmetic::Add(top[-1], Arithmetic::FromDouble(1));
+			double counter = Arithmetic::ToDouble(top[-1]);
+			//a counter too large to change when incremented ends the loop too
+			if (counter > previous && counter < Arithmetic::ToDouble(top[0]))
+			{
+				environment.RecordVariable(instruction.m_index, top[-1]);
+				next = code + static_cast<size_t>(instruction.m_value);
+			}
+			else
+				--top;
+			break;
+		}
+		}
+	}
+	return *top;
+}
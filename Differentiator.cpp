@@ -0,0 +1,112 @@
+#include "Differentiator.h"
+
+#include <algorithm>
+
+static bool
+ReadsNoVariable(const CompiledExpression &compiled)
+{
+	for (const Instruction &instruction : compiled.GetCode())
+		if (instruction.m_op == OpCode::Variable || instruction.m_op == OpCode::Increment || instruction.m_op == OpCode::PostIncrement)
+			return false;
+	return true;
+}
+
+Differentiator::Differentiator(Parser &parser, const std::vector<std::string> &variables)
+	: m_parser(parser)
+	, m_variables(variables)
+{
+	for (const std::string &variable : m_variables)
+		m_seeds.push_back(m_parser.GetVariableSlot(variable));
+}
+
+void
+Differentiator::EvaluateStatements(bool batched)
+{
+	if (batched)
+		Evaluate<s_batchWidth>();
+	else
+		Evaluate<1>();
+}
+
+template <size_t N>
+void
+Differentiator::Evaluate()
+{
+	std::vector<double> initialValues(m_parser.GetSlotCount());
+	for (size_t slot = 0; slot < initialValues.size(); ++slot)
+		initialValues[slot] = m_parser.LookupVariable(slot);
+
+	//the first pass reads the statements and evaluates them for the parser, the next ones
+	//evaluate the compiled statements again for the derivatives of the next variables
+	m_parser.ClearErrors();
+	m_passes = (m_variables.size() + N - 1) / N;
+	if (!m_passes)
+		m_passes = 1;
+	m_compiled.resize(m_parser.GetStatementCount());
+	m_constant.assign(m_compiled.size(), false);
+	for (size_t pass = 0; pass < m_passes; ++pass)
+	{
+		DualEnvironment<N> environment(pass ? nullptr : &m_parser, initialValues);
+		size_t first = pass * N, last = std::min(first + N, m_variables.size());
+		for (size_t variable = first; variable < last; ++variable)
+			environment.SetLane(m_seeds[variable], variable - first);
+		for (size_t slot : m_seeds)
+			environment.Seed(slot);
+
+		for (size_t statement = 0; statement < m_compiled.size(); ++statement)
+		{
+			CompiledExpression &compiled = m_compiled[statement];
+			if (!pass)
+			{
+				if (!m_parser.CompileStatement(statement, compiled))
+					continue;
+				m_constant[statement] = ReadsNoVariable(compiled);
+			}
+			environment.Evaluate(compiled);
+			if (!m_constant[statement])
+				continue;
+			for (const Instruction &instruction : compiled.GetCode())
+				if (instruction.m_op == OpCode::Assign && std::find(m_seeds.begin(), m_seeds.end(), instruction.m_index) != m_seeds.end())
+					environment.Seed(instruction.m_index);
+		}
+
+		if (!pass)
+		{
+			m_derivatives.assign(environment.GetSlotCount() * m_variables.size(), 0);
+			initialValues.resize(environment.GetSlotCount(), 0);
+		}
+		for (size_t slot = 0; slot < environment.GetSlotCount(); ++slot)
+			for (size_t variable = first; variable < last; ++variable)
+				m_derivatives[slot * m_variables.size() + variable] = environment.LookupVariable(slot).m_tangent[variable - first];
+	}
+}
+
+double
+Differentiator::GetDerivative(const std::string &var, size_t variable) const
+{
+	size_t slot = 0;
+	if (!m_parser.FindVariable(var, slot))
+		return 0;
+	size_t index = slot * m_variables.size() + variable;
+	return index < m_derivatives.size() ? m_derivatives[index] : 0;
+}
+
+void
+Differentiator::PrintDerivatives(std::ostream &out) const
+{
+	for (size_t variable = 0; variable < m_variables.size(); ++variable)
+	{
+		out << "d/d" << m_variables[variable] << " (";
+		bool first = true;
+		for (size_t slot : m_parser.GetVariableOrder())
+		{
+			if (first)
+				first = false;
+			else
+				out << ",";
+			size_t index = slot * m_variables.size() + variable;
+			out << m_parser.GetVariableName(slot) << "=" << (index < m_derivatives.size() ? m_derivatives[index] : 0);
+		}
+		out << ")" << std::endl;
+	}
+}
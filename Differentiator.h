@@ -0,0 +1,117 @@
+#pragma once
+#include "CompiledExpression.h"
+#include "Dual.h"
+#include "Parser.h"
+
+#include <cstddef>
+#include <ostream>
+#include <string>
+#include <vector>
+
+/*
+	DualEnvironment class holds the variables of a Parser as dual numbers
+	Every tangent lane is the derivative with respect to one variable, its seed.
+	With a parser every assignment is also recorded in it as a double and errors are
+	reported to it, as NumericEnvironment does
+*/
+template <size_t N>
+class DualEnvironment
+{
+public:
+	DualEnvironment(Parser *parser, const std::vector<double> &values)
+		: m_parser(parser)
+		, m_values(values.begin(), values.end())
+		, m_lanes(values.size(), N)
+	{
+	}
+
+	Dual<N> Evaluate(const CompiledExpression &compiled)
+	{
+		//slots are created by the parser while reading
+		if (m_parser && m_values.size() < m_parser->GetSlotCount())
+		{
+			m_values.resize(m_parser->GetSlotCount());
+			m_lanes.resize(m_parser->GetSlotCount(), N);
+		}
+		return compiled.Evaluate<Dual<N>>(*this, m_stack);
+	}
+
+	//Differentiate with respect to the variable of slot in lane
+	void SetLane(size_t slot, size_t lane) { m_lanes[slot] = lane; }
+	//The variable of slot becomes an input: its derivative is 1 in its lane, 0 in the others
+	void Seed(size_t slot)
+	{
+		Dual<N> &value = m_values[slot];
+		for (size_t i = 0; i < N; ++i)
+			value.m_tangent[i] = i == m_lanes[slot] ? 1 : 0;
+	}
+
+	const Dual<N>& LookupVariable(size_t slot) const { return m_values[slot]; }
+	void RecordVariable(size_t slot, const Dual<N> &value)
+	{
+		m_values[slot] = value;
+		if (m_parser)
+			m_parser->RecordVariable(slot, value.m_value);
+	}
+	void ReportError(ErrorCode code, int position)
+	{
+		if (m_parser)
+			m_parser->ReportError(code, position);
+	}
+
+	size_t GetSlotCount() const { return m_values.size(); }
+
+private:
+	Parser *m_parser;
+	std::vector<Dual<N>> m_values;
+	//Lane of every slot, N for a variable which is not differentiated
+	std::vector<size_t> m_lanes;
+	std::vector<Dual<N>> m_stack;
+};
+
+/*
+	Differentiator class evaluates the statements of a Parser with forward mode automatic
+	differentiation: every value comes with its derivatives with respect to some variables.
+
+	A differentiated variable is an input where the statements start, and again where a
+	statement reading no variable assigns it, e.g. x=3. Elsewhere it depends on the inputs
+	like the other variables, e.g. after x=y*2.
+	Each evaluation propagates s_batchWidth derivatives, or a single one when not batched,
+	so the statements are evaluated once per group of variables. They are read only once.
+*/
+class Differentiator
+{
+public:
+	static const size_t s_batchWidth = 8;
+
+	Differentiator(Parser &parser, const std::vector<std::string> &variables);
+
+	//Evaluate the statements of the parser, which receives the values and errors as from
+	//its own EvaluateStatements, and the derivatives of every variable
+	void EvaluateStatements(bool batched = true);
+
+	//Derivative of var with respect to the variable of index variable, 0 for an unknown var
+	double GetDerivative(const std::string &var, size_t variable) const;
+	const std::vector<std::string>& GetVariables() const { return m_variables; }
+	//Number of evaluations of the statements of the last run
+	size_t GetPasses() const { return m_passes; }
+
+	//Print the derivatives of the variables with respect to every differentiated variable,
+	//one line per variable in the format of Parser::PrintVariables, e.g. d/dx (x=1,y=6)
+	void PrintDerivatives(std::ostream &out) const;
+
+private:
+	template <size_t N>
+	void Evaluate();
+
+	Parser &m_parser;
+	std::vector<std::string> m_variables;
+	//Slot of every differentiated variable
+	std::vector<size_t> m_seeds;
+	std::vector<CompiledExpression> m_compiled;
+	//Whether the statement reads no variable, its assignment makes an input
+	std::vector<char> m_constant;
+	//Derivatives by slot then by variable
+	std::vector<double> m_derivatives;
+	size_t m_passes = 0;
+};
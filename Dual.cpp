@@ -0,0 +1,67 @@
+#include "Dual.h"
+
+#include <limits>
+
+typedef double (*DoubleFuncPtr)(double);
+typedef double (*BinaryDoubleFuncPtr)(double, double);
+
+//The functions of the parser maps are the functions of the standard library, found by address
+static bool
+Is(const CompiledExpression::Function &function, DoubleFuncPtr pointer)
+{
+	const DoubleFuncPtr *target = function.target<DoubleFuncPtr>();
+	return target && *target == pointer;
+}
+
+static bool
+Is(const CompiledExpression::BinaryFunction &function, BinaryDoubleFuncPtr pointer)
+{
+	const BinaryDoubleFuncPtr *target = function.target<BinaryDoubleFuncPtr>();
+	return target && *target == pointer;
+}
+
+double
+GetDerivative(const CompiledExpression::Function &function, double a)
+{
+	if (Is(function, static_cast<DoubleFuncPtr>(std::sin)))
+		return std::cos(a);
+	if (Is(function, static_cast<DoubleFuncPtr>(std::cos)))
+		return -std::sin(a);
+	if (Is(function, static_cast<DoubleFuncPtr>(std::tan)))
+		return 1 / (std::cos(a) * std::cos(a));
+	if (Is(function, static_cast<DoubleFuncPtr>(std::asin)))
+		return 1 / std::sqrt(1 - a * a);
+	if (Is(function, static_cast<DoubleFuncPtr>(std::acos)))
+		return -1 / std::sqrt(1 - a * a);
+	if (Is(function, static_cast<DoubleFuncPtr>(std::atan)))
+		return 1 / (1 + a * a);
+	if (Is(function, static_cast<DoubleFuncPtr>(std::ceil)) || Is(function, static_cast<DoubleFuncPtr>(std::floor)))
+		return 0;
+	return std::numeric_limits<double>::quiet_NaN();
+}
+
+void
+GetDerivatives(const CompiledExpression::BinaryFunction &function, double a, double b, double &da, double &db)
+{
+	if (Is(function, static_cast<BinaryDoubleFuncPtr>(std::fmin)) || Is(function, static_cast<BinaryDoubleFuncPtr>(std::fmax)))
+	{
+		//the derivative of the argument which is the result, a NaN argument is ignored
+		bool isA = function(a, b) == a && !std::isnan(a);
+		da = isA ? 1 : 0;
+		db = isA ? 0 : 1;
+	}
+	else if (Is(function, static_cast<BinaryDoubleFuncPtr>(std::atan2)))
+	{
+		//atan2(y, x)
+		double norm = a * a + b * b;
+		da = b / norm;
+		db = -a / norm;
+	}
+	else if (Is(function, static_cast<BinaryDoubleFuncPtr>(std::pow)))
+	{
+		da = b * std::pow(a, b - 1);
+		db = a > 0 ? std::pow(a, b) * std::log(a) : 0;
+	}
+	else
+		da = db = std::numeric_limits<double>::quiet_NaN();
+}
@@ -0,0 +1,112 @@
+#pragma once
+#include "CompiledExpression.h"
+#include "Numeric.h"
+
+#include <cmath>
+#include <cstddef>
+
+/*
+	Dual class template holds a value with its derivatives with respect to N variables,
+	a dual number with N tangents. Evaluating with duals computes every derivative in
+	the same pass as the value, the loops over the tangents are short and vectorizable
+*/
+template <size_t N>
+struct Dual
+{
+	Dual(double value = 0)
+		: m_value(value)
+	{
+	}
+
+	bool operator==(const Dual &other) const { return m_value == other.m_value; }
+
+	double m_value;
+	double m_tangent[N] = {};
+};
+
+//Derivative of a built-in function at a, NaN for a function without a derivative rule
+double GetDerivative(const CompiledExpression::Function &function, double a);
+//Partial derivatives of a built-in binary function at a and b, NaN without a rule
+void GetDerivatives(const CompiledExpression::BinaryFunction &function, double a, double b, double &da, double &db);
+
+/*
+	Arithmetic of dual numbers: every operation applies its derivative rule on the tangents
+	ceil, floor and % are differentiated as constant between their discontinuities
+*/
+template <size_t N>
+struct Numeric<Dual<N>>
+{
+	using T = Dual<N>;
+
+	static T FromDouble(double value) { return T(value); }
+	static double ToDouble(const T &value) { return value.m_value; }
+	static bool IsZero(const T &value) { return value.m_value == 0; }
+
+	static T Add(const T &a, const T &b)
+	{
+		T res(a.m_value + b.m_value);
+		for (size_t i = 0; i < N; ++i)
+			res.m_tangent[i] = a.m_tangent[i] + b.m_tangent[i];
+		return res;
+	}
+	static T Substract(const T &a, const T &b)
+	{
+		T res(a.m_value - b.m_value);
+		for (size_t i = 0; i < N; ++i)
+			res.m_tangent[i] = a.m_tangent[i] - b.m_tangent[i];
+		return res;
+	}
+	static T Multiply(const T &a, const T &b)
+	{
+		T res(a.m_value * b.m_value);
+		for (size_t i = 0; i < N; ++i)
+			res.m_tangent[i] = a.m_tangent[i] * b.m_value + a.m_value * b.m_tangent[i];
+		return res;
+	}
+	static T Divide(const T &a, const T &b)
+	{
+		T res(a.m_value / b.m_value);
+		for (size_t i = 0; i < N; ++i)
+			res.m_tangent[i] = (a.m_tangent[i] - res.m_value * b.m_tangent[i]) / b.m_value;
+		return res;
+	}
+	static T Modulus(const T &a, const T &b)
+	{
+		//a % b = a - trunc(a / b) * b
+		T res(std::fmod(a.m_value, b.m_value));
+		double quotient = std::trunc(a.m_value / b.m_value);
+		for (size_t i = 0; i < N; ++i)
+			res.m_tangent[i] = a.m_tangent[i] - quotient * b.m_tangent[i];
+		return res;
+	}
+	static T Power(const T &a, const T &b)
+	{
+		T res(std::pow(a.m_value, b.m_value));
+		return Chain(res, a, b, b.m_value * std::pow(a.m_value, b.m_value - 1), a.m_value > 0 ? res.m_value * std::log(a.m_value) : 0);
+	}
+
+	static T Call(const CompiledExpression::Function &function, const T &a)
+	{
+		T res(function(a.m_value));
+		double da = GetDerivative(function, a.m_value);
+		for (size_t i = 0; i < N; ++i)
+			res.m_tangent[i] = a.m_tangent[i] ? da * a.m_tangent[i] : 0;
+		return res;
+	}
+	static T Call(const CompiledExpression::BinaryFunction &function, const T &a, const T &b)
+	{
+		double da = 0, db = 0;
+		GetDerivatives(function, a.m_value, b.m_value, da, db);
+		return Chain(T(function(a.m_value, b.m_value)), a, b, da, db);
+	}
+
+private:
+	//res with the tangents of a function of a and b of partial derivatives da and db.
+	//A variable a or b does not depend on keeps a null tangent where da or db is infinite
+	static T Chain(T res, const T &a, const T &b, double da, double db)
+	{
+		for (size_t i = 0; i < N; ++i)
+			res.m_tangent[i] = (a.m_tangent[i] ? da * a.m_tangent[i] : 0) + (b.m_tangent[i] ? db * b.m_tangent[i] : 0);
+		return res;
+	}
+};
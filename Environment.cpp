@@ -0,0 +1,76 @@
+#include "Environment.h"
+#include "Program.h"
+
+#include <iostream>
+
+Environment::Environment(const Program &program)
+	: m_program(program)
+{
+	Reset();
+}
+
+void
+Environment::Reset()
+{
+	m_values = m_program.m_initialValues;
+	m_defined.assign(m_values.size(), false);
+	m_order = m_program.m_initialOrder;
+	for (size_t slot : m_order)
+		m_defined[slot] = true;
+	m_errors.clear();
+}
+
+double
+Environment::LookupVariable(const std::string& var) const
+{
+	size_t slot(0);
+	return m_program.FindVariable(var, slot) ? m_values[slot] : 0;
+}
+
+bool
+Environment::HasVariable(const std::string& var) const
+{
+	size_t slot(0);
+	return m_program.FindVariable(var, slot) && m_defined[slot];
+}
+
+bool
+Environment::RecordVariable(const std::string& var, double value)
+{
+	size_t slot(0);
+	if (!m_program.FindVariable(var, slot))
+		return false;
+	RecordVariable(slot, value);
+	return true;
+}
+
+void
+Environment::ReportError(ErrorCode code, int position)
+{
+	//only the first error of a statement is kept
+	if (!m_errors.empty() && m_errors.back().m_statement == m_currentStatement)
+		return;
+	m_errors.push_back(Parser::StatementError(code, m_currentStatement, position));
+}
+
+void
+Environment::PrintVariables() const
+{
+	PrintVariables(std::cout);
+}
+
+void
+Environment::PrintVariables(std::ostream &out) const
+{
+	out << "(";
+	bool first = true;
+	for (size_t slot : m_order)
+	{
+		if (first)
+			first = false;
+		else
+			out << ",";
+		out << m_program.GetVariableName(slot) << "=" << m_values[slot];
+	}
+	out << ")" << std::endl;
+}
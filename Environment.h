@@ -0,0 +1,58 @@
+#pragma once
+#include "ErrorCode.h"
+#include "Parser.h"
+
+#include <ostream>
+#include <string>
+#include <vector>
+
+class Program;
+
+/*
+	Environment class holds the variables of one run of a Program by slot, with the
+	errors the run reported. An environment belongs to a single thread at a time
+*/
+class Environment
+{
+public:
+	explicit Environment(const Program &program);
+
+	//Back to the initial values of the program
+	void Reset();
+
+	double LookupVariable(const std::string& var) const;
+	bool HasVariable(const std::string& var) const;
+	//Set an input of the program, false if the program does not know the variable
+	bool RecordVariable(const std::string& var, double value);
+
+	//Print variables to stdout in the format of Parser::PrintVariables
+	void PrintVariables() const;
+	void PrintVariables(std::ostream &out) const;
+
+	//Errors of the last run, at most one per statement, by statement order
+	const std::vector<Parser::StatementError>& GetErrors() const { return m_errors; }
+
+	double LookupVariable(size_t slot) const { return m_values[slot]; }
+	void RecordVariable(size_t slot, double value)
+	{
+		m_values[slot] = value;
+		if (!m_defined[slot])
+		{
+			m_defined[slot] = true;
+			m_order.push_back(slot);
+		}
+	}
+	void ReportError(ErrorCode code, int position);
+
+private:
+	friend class Program;
+
+	const Program &m_program;
+	std::vector<double> m_values;
+	std::vector<char> m_defined;
+	//Slots of the defined variables by the order of creation
+	std::vector<size_t> m_order;
+	std::vector<double> m_stack;
+	std::vector<Parser::StatementError> m_errors;
+	size_t m_currentStatement = 0;
+};
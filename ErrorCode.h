@@ -0,0 +1,15 @@
+#pragma once
+
+/*
+	ErrorCode enumerates the failures a statement can report
+	Errors are recorded in the owning Parser rather than printed, see Parser::GetErrors
+*/
+enum class ErrorCode
+{
+	None,
+	SyntaxError,
+	InvalidExpression,
+	DivisionByZero,
+	ModulusByZero,
+	Overflow
+};
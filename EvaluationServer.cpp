@@ -0,0 +1,335 @@
+#include "EvaluationServer.h"
+
+#include <cstdint>
+#include <sstream>
+
+#ifdef __linux__
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#endif
+
+//Larger requests close the connection
+static const size_t s_maxFrame = 64 * 1024 * 1024;
+//Past this many bytes of responses the client does not read, its requests are not read either
+static const size_t s_maxOutput = 16 * 1024 * 1024;
+
+EvaluationServer::EvaluationServer(const std::string &socketPath, size_t sessions)
+	: m_socketPath(socketPath)
+	, m_poolSize(sessions)
+{
+	//sessions are warm before the first client connects
+	for (size_t i = 0; i < m_poolSize; ++i)
+	{
+		m_pool.emplace_back(new Parser());
+		++m_sessionsCreated;
+	}
+}
+
+void
+EvaluationServer::AppendFrame(std::string &buffer, const std::string &payload)
+{
+	uint32_t length = static_cast<uint32_t>(payload.size());
+	for (int i = 0; i < 4; ++i)
+		buffer += static_cast<char>((length >> (8 * i)) & 0xff);
+	buffer += payload;
+}
+
+bool
+EvaluationServer::ReadFrame(const std::string &buffer, size_t &offset, std::string &payload)
+{
+	if (buffer.size() < offset + 4)
+		return false;
+	uint32_t length = 0;
+	for (int i = 0; i < 4; ++i)
+		length |= static_cast<uint32_t>(static_cast<unsigned char>(buffer[offset + i])) << (8 * i);
+	if (buffer.size() < offset + 4 + length)
+		return false;
+	payload.assign(buffer, offset + 4, length);
+	offset += 4 + length;
+	return true;
+}
+
+std::unique_ptr<Parser>
+EvaluationServer::AcquireSession()
+{
+	if (m_pool.empty())
+	{
+		++m_sessionsCreated;
+		return std::unique_ptr<Parser>(new Parser());
+	}
+	std::unique_ptr<Parser> session = std::move(m_pool.back());
+	m_pool.pop_back();
+	return session;
+}
+
+void
+EvaluationServer::ReleaseSession(std::unique_ptr<Parser> session)
+{
+	if (m_pool.size() >= m_poolSize)
+		return;
+	session->Reset();
+	m_pool.push_back(std::move(session));
+}
+
+std::string
+EvaluationServer::Execute(Parser &session, const std::string &request)
+{
+	if (request.empty())
+	{
+		session.Reset();
+		return std::string();
+	}
+
+	session.ClearStatements();
+	std::istringstream statements(request);
+	std::string line;
+	while (std::getline(statements, line))
+		if (!line.empty())
+			session.AddStatement(line);
+	session.EvaluateStatements();
+
+	std::ostringstream response;
+	session.PrintErrors(response);
+	session.PrintVariables(response);
+	return response.str();
+}
+
+#ifdef __linux__
+
+bool
+EvaluationServer::IsSupported()
+{
+	return true;
+}
+
+EvaluationServer::~EvaluationServer()
+{
+	for (auto &connection : m_connections)
+		::close(connection.first);
+	if (m_epollFd >= 0)
+		::close(m_epollFd);
+	if (m_listenFd >= 0)
+	{
+		::close(m_listenFd);
+		::unlink(m_socketPath.c_str());
+	}
+}
+
+static bool
+SetNonBlocking(int fd)
+{
+	int flags = ::fcntl(fd, F_GETFL, 0);
+	return flags >= 0 && ::fcntl(fd, F_SETFL, flags | O_NONBLOCK) == 0;
+}
+
+bool
+EvaluationServer::Listen()
+{
+	sockaddr_un address{};
+	address.sun_family = AF_UNIX;
+	if (m_socketPath.size() >= sizeof(address.sun_path))
+		return false;
+	std::strncpy(address.sun_path, m_socketPath.c_str(), sizeof(address.sun_path) - 1);
+
+	m_listenFd = ::socket(AF_UNIX, SOCK_STREAM, 0);
+	if (m_listenFd < 0)
+		return false;
+	::unlink(m_socketPath.c_str());
+	if (::bind(m_listenFd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0 ||
+		::listen(m_listenFd, SOMAXCONN) != 0 || !SetNonBlocking(m_listenFd))
+		return false;
+
+	m_epollFd = ::epoll_create1(0);
+	epoll_event event{};
+	event.events = EPOLLIN;
+	event.data.fd = m_listenFd;
+	return m_epollFd >= 0 && ::epoll_ctl(m_epollFd, EPOLL_CTL_ADD, m_listenFd, &event) == 0;
+}
+
+void
+EvaluationServer::Run()
+{
+	const int maxEvents = 64;
+	epoll_event events[maxEvents];
+	while (!m_stopping)
+	{
+		int count = ::epoll_wait(m_epollFd, events, maxEvents, 100);
+		for (int i = 0; i < count; ++i)
+		{
+			int fd = events[i].data.fd;
+			if (fd == m_listenFd)
+			{
+				Accept();
+				continue;
+			}
+
+			auto find = m_connections.find(fd);
+			if (find == m_connections.end())
+				continue;
+			if (events[i].events & (EPOLLERR | EPOLLHUP))
+			{
+				Close(fd);
+				continue;
+			}
+			if (events[i].events & EPOLLOUT && !Flush(fd, find->second))
+			{
+				Close(fd);
+				continue;
+			}
+			//requests left waiting for the output are answered once it was written
+			if (events[i].events & (EPOLLIN | EPOLLOUT))
+				Read(fd, find->second);
+		}
+	}
+}
+
+void
+EvaluationServer::Accept()
+{
+	for (;;)
+	{
+		int fd = ::accept(m_listenFd, nullptr, nullptr);
+		if (fd < 0)
+			return;
+		epoll_event event{};
+		event.events = EPOLLIN;
+		event.data.fd = fd;
+		if (!SetNonBlocking(fd) || ::epoll_ctl(m_epollFd, EPOLL_CTL_ADD, fd, &event) != 0)
+		{
+			::close(fd);
+			continue;
+		}
+		Connection &connection = m_connections[fd];
+		connection.m_session = AcquireSession();
+		connection.m_events = EPOLLIN;
+	}
+}
+
+void
+EvaluationServer::Read(int fd, Connection &connection)
+{
+	char buffer[64 * 1024];
+	Answer(connection);
+	while (!connection.m_readClosed && !IsOutputFull(connection))
+	{
+		ssize_t received = ::read(fd, buffer, sizeof(buffer));
+		if (received > 0)
+		{
+			connection.m_input.append(buffer, received);
+			Answer(connection);
+			continue;
+		}
+		if (received < 0 && errno == EINTR)
+			continue;
+		if (received < 0 && errno != EAGAIN && errno != EWOULDBLOCK)
+		{
+			Close(fd);
+			return;
+		}
+		//the client sent its last request, the connection stays open until it is answered
+		connection.m_readClosed = received == 0;
+		break;
+	}
+
+	if (connection.m_input.size() > s_maxFrame + 4 || !Flush(fd, connection) || (connection.m_readClosed && connection.m_output.empty()))
+		Close(fd);
+}
+
+void
+EvaluationServer::Answer(Connection &connection)
+{
+	//every complete request is answered, the rest waits for more bytes
+	size_t offset = 0;
+	std::string request;
+	while (!IsOutputFull(connection) && ReadFrame(connection.m_input, offset, request))
+		AppendFrame(connection.m_output, Execute(*connection.m_session, request));
+	connection.m_input.erase(0, offset);
+}
+
+bool
+EvaluationServer::IsOutputFull(const Connection &connection)
+{
+	return connection.m_output.size() - connection.m_written > s_maxOutput;
+}
+
+bool
+EvaluationServer::Flush(int fd, Connection &connection)
+{
+	while (connection.m_written < connection.m_output.size())
+	{
+		ssize_t sent = ::send(fd, connection.m_output.data() + connection.m_written,
+			connection.m_output.size() - connection.m_written, MSG_NOSIGNAL);
+		if (sent > 0)
+		{
+			connection.m_written += sent;
+			continue;
+		}
+		if (sent < 0 && errno == EINTR)
+			continue;
+		if (sent < 0 && (errno == EAGAIN || errno == EWOULDBLOCK))
+			break;
+		return false;
+	}
+
+	bool pending = connection.m_written < connection.m_output.size();
+	if (!pending)
+	{
+		connection.m_output.clear();
+		connection.m_written = 0;
+	}
+
+	//wait for the socket to accept more only while there is something left to write, and for
+	//requests while the client may send more and reads its responses
+	uint32_t events = (pending ? static_cast<uint32_t>(EPOLLOUT) : 0u) |
+		(connection.m_readClosed || IsOutputFull(connection) ? 0u : static_cast<uint32_t>(EPOLLIN));
+	if (events == connection.m_events)
+		return true;
+	connection.m_events = events;
+	epoll_event event{};
+	event.events = events;
+	event.data.fd = fd;
+	return ::epoll_ctl(m_epollFd, EPOLL_CTL_MOD, fd, &event) == 0;
+}
+
+void
+EvaluationServer::Close(int fd)
+{
+	auto find = m_connections.find(fd);
+	if (find != m_connections.end())
+	{
+		ReleaseSession(std::move(find->second.m_session));
+		m_connections.erase(find);
+	}
+	::epoll_ctl(m_epollFd, EPOLL_CTL_DEL, fd, nullptr);
+	::close(fd);
+}
+
+#else
+
+bool
+EvaluationServer::IsSupported()
+{
+	return false;
+}
+
+EvaluationServer::~EvaluationServer()
+{
+}
+
+bool
+EvaluationServer::Listen()
+{
+	return false;
+}
+
+void
+EvaluationServer::Run()
+{
+}
+
+#endif
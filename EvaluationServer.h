@@ -0,0 +1,87 @@
+#pragma once
+#include "Parser.h"
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+/*
+	EvaluationServer class evaluates statements for local clients over a Unix domain socket
+
+	Every message is a frame: its length as 4 bytes little endian, then the payload.
+	A request holds statements separated by new lines, the response holds the errors and the
+	variables as main prints them. A client may send many requests without waiting, they are
+	answered in order. An empty request resets the variables.
+
+	Every connection gets a session, a Parser holding its variables, from a pool of warm
+	sessions and gives it back reset when it closes. One thread serves every connection
+	with epoll, which is only available on Linux. A client which closes its side still gets
+	the responses to its requests, and one which does not read its responses is not read
+	from until they are written.
+*/
+class EvaluationServer
+{
+public:
+	EvaluationServer(const std::string &socketPath, size_t sessions = 16);
+	~EvaluationServer();
+
+	//Whether the platform has Unix domain sockets and epoll
+	static bool IsSupported();
+
+	//Create the socket, replacing a stale socket file. False on failure
+	bool Listen();
+	//Serve the connections until Stop is called
+	void Run();
+	//May be called from any thread, Run returns within 100ms
+	void Stop() { m_stopping = true; }
+
+	size_t GetSessionsCreated() const { return m_sessionsCreated; }
+
+	static void AppendFrame(std::string &buffer, const std::string &payload);
+	//Read the frame at offset of buffer and move offset after it, false if it is not complete yet
+	static bool ReadFrame(const std::string &buffer, size_t &offset, std::string &payload);
+
+private:
+	/*
+		Connection utility class to hold a client and the bytes in transit
+	*/
+	struct Connection
+	{
+		std::unique_ptr<Parser> m_session;
+		std::string m_input;
+		std::string m_output;
+		size_t m_written = 0;
+		//Events epoll waits for on the socket
+		uint32_t m_events = 0;
+		//Whether the client closed its side, it is still answered
+		bool m_readClosed = false;
+	};
+
+	std::unique_ptr<Parser> AcquireSession();
+	void ReleaseSession(std::unique_ptr<Parser> session);
+	std::string Execute(Parser &session, const std::string &request);
+
+	void Accept();
+	//Read the requests of the client and answer them, until its responses pile up
+	void Read(int fd, Connection &connection);
+	//Answer the complete requests read, until the responses pile up
+	void Answer(Connection &connection);
+	//Whether the responses the client did not read yet are past s_maxOutput
+	static bool IsOutputFull(const Connection &connection);
+	//Write what the socket accepts, false if the connection failed
+	bool Flush(int fd, Connection &connection);
+	void Close(int fd);
+
+	std::string m_socketPath;
+	size_t m_poolSize;
+	int m_listenFd = -1;
+	int m_epollFd = -1;
+	std::atomic<bool> m_stopping{false};
+	std::vector<std::unique_ptr<Parser>> m_pool;
+	size_t m_sessionsCreated = 0;
+	std::unordered_map<int, Connection> m_connections;
+};
@@ -1,10 +1,25 @@
 #include "Expression.h"
 #include "Parser.h"
 #include <cmath>
-#include <iostream>
+
+static thread_local size_t s_createdExpressions = 0;
 
 Expression::Expression()
 {
+	++s_createdExpressions;
+}
+
+size_t
+Expression::GetCreatedCount()
+{
+	return s_createdExpressions;
+}
+
+void
+Expression::ReportError(ErrorCode code) const
+{
+	if (m_parser)
+		m_parser->ReportError(code, m_position);
 }
 
 NumberExpression::NumberExpression(double val) 
@@ -17,23 +32,38 @@ double NumberExpression::Evaluate()
 	return value;
 }
 
+void
+NumberExpression::Compile(CompiledExpression &compiled) const
+{
+	compiled.AddNumber(value);
+}
+
 VariableExpression::VariableExpression(Parser *parser, const std::string& var) 
 	: variable(var)
 {
 	SetParser(parser);
+	if (m_parser)
+		m_slot = m_parser->GetVariableSlot(variable);
 }
 
 double VariableExpression::Evaluate() 
 {
 	double res(0);
 	if (m_parser)
-		res = m_parser->LookupVariable(variable);
+		res = m_parser->LookupVariable(m_slot);
 	return res;
 }
 
-ArithmeticExpression::ArithmeticExpression(const ExpressionPtr &l, const ExpressionPtr &r)
+void
+VariableExpression::Compile(CompiledExpression &compiled) const
+{
+	compiled.AddVariable(m_slot);
+}
+
+ArithmeticExpression::ArithmeticExpression(Parser *parser, const ExpressionPtr &l, const ExpressionPtr &r)
 	: m_left(l), m_right(r)
 {
+	SetParser(parser);
 }
 
 bool 
@@ -42,29 +72,44 @@ ArithmeticExpression::Validate() const
 	return m_left != nullptr && m_right != nullptr;
 }
 
-AdditionExpression::AdditionExpression(const ExpressionPtr &left, const ExpressionPtr &right)
-	: ArithmeticExpression(left, right)
+AdditionExpression::AdditionExpression(Parser *parser, const ExpressionPtr &left, const ExpressionPtr &right)
+	: ArithmeticExpression(parser, left, right)
 {
 }
 
+void
+AdditionExpression::Compile(CompiledExpression &compiled) const
+{
+	m_left->Compile(compiled);
+	m_right->Compile(compiled);
+	compiled.AddOperation(OpCode::Add, m_position);
+}
+
 double 
 AdditionExpression::Evaluate()
 {
 	if (!Validate())
 	{
-		std::cout << "AdditionExpression: Could not evaluate expression" << std::endl;
+		ReportError(ErrorCode::InvalidExpression);
 		return 0;
 	}
-		
 
 	double a = m_left->Evaluate();
 	double b = m_right->Evaluate();
 	return a+b;
 }
 
-SubstractionExpression::SubstractionExpression(const ExpressionPtr &left, const ExpressionPtr &right)
-	: ArithmeticExpression(left, right)
+SubstractionExpression::SubstractionExpression(Parser *parser, const ExpressionPtr &left, const ExpressionPtr &right)
+	: ArithmeticExpression(parser, left, right)
+{
+}
+
+void
+SubstractionExpression::Compile(CompiledExpression &compiled) const
 {
+	m_left->Compile(compiled);
+	m_right->Compile(compiled);
+	compiled.AddOperation(OpCode::Substract, m_position);
 }
 
 double 
@@ -72,7 +117,7 @@ SubstractionExpression::Evaluate()
 {
 	if (!Validate())
 	{
-		std::cout << "SubstractionExpression: Could not evaluate expression" << std::endl;
+		ReportError(ErrorCode::InvalidExpression);
 		return 0;
 	}
 
@@ -81,9 +126,17 @@ SubstractionExpression::Evaluate()
 	return a-b;
 }
 
-MultiplicationExpression::MultiplicationExpression(const ExpressionPtr &left, const ExpressionPtr &right)
-	: ArithmeticExpression(left, right)
+MultiplicationExpression::MultiplicationExpression(Parser *parser, const ExpressionPtr &left, const ExpressionPtr &right)
+	: ArithmeticExpression(parser, left, right)
+{
+}
+
+void
+MultiplicationExpression::Compile(CompiledExpression &compiled) const
 {
+	m_left->Compile(compiled);
+	m_right->Compile(compiled);
+	compiled.AddOperation(OpCode::Multiply, m_position);
 }
 
 double 
@@ -91,7 +144,7 @@ MultiplicationExpression::Evaluate()
 {
 	if (!Validate())
 	{
-		std::cout << "MultiplicationExpression: Could not evaluate expression" << std::endl;
+		ReportError(ErrorCode::InvalidExpression);
 		return 0;
 	}
 
@@ -100,17 +153,25 @@ MultiplicationExpression::Evaluate()
 	return a*b;
 }
 
-DivisionExpression::DivisionExpression(const ExpressionPtr &left, const ExpressionPtr &right)
-	: ArithmeticExpression(left, right)
+DivisionExpression::DivisionExpression(Parser *parser, const ExpressionPtr &left, const ExpressionPtr &right)
+	: ArithmeticExpression(parser, left, right)
 {
 }
 
+void
+DivisionExpression::Compile(CompiledExpression &compiled) const
+{
+	m_left->Compile(compiled);
+	m_right->Compile(compiled);
+	compiled.AddOperation(OpCode::Divide, m_position);
+}
+
 double 
 DivisionExpression::Evaluate()
 {
 	if (!Validate())
 	{
-		std::cout << "DivisionExpression: Could not evaluate expression" << std::endl;
+		ReportError(ErrorCode::InvalidExpression);
 		return 0;
 	}
 
@@ -118,26 +179,32 @@ DivisionExpression::Evaluate()
 	double b = m_right->Evaluate();
 	double res = 0;
 	if (b == 0.0)
-	{
-		std::cout << "DivisionExpression: Attempt to divide by zero: " << std::endl;
-	}
+		ReportError(ErrorCode::DivisionByZero);
 	else 
 		res = a/b;
 
 	return res;
 }
 
-ModulusExpression::ModulusExpression(const ExpressionPtr &left, const ExpressionPtr &right)
-	: ArithmeticExpression(left, right)
+ModulusExpression::ModulusExpression(Parser *parser, const ExpressionPtr &left, const ExpressionPtr &right)
+	: ArithmeticExpression(parser, left, right)
 {
 }
 
+void
+ModulusExpression::Compile(CompiledExpression &compiled) const
+{
+	m_left->Compile(compiled);
+	m_right->Compile(compiled);
+	compiled.AddOperation(OpCode::Modulus, m_position);
+}
+
 double 
 ModulusExpression::Evaluate()
 {
 	if (!Validate())
 	{
-		std::cout << "ModulusExpression: Could not evaluate expression" << std::endl;
+		ReportError(ErrorCode::InvalidExpression);
 		return 0;
 	}
 
@@ -145,25 +212,34 @@ ModulusExpression::Evaluate()
 	double b = m_right->Evaluate();
 	double res = 0;
 	if (b == 0.0)
-	{
-		std::cout << "ModulusExpression: Attempt to apply modulu by zero: " << std::endl;
-	}
+		ReportError(ErrorCode::ModulusByZero);
 	else 
 		res = std::fmod(a, b);
 
 	return res;
 }
 
-ExponentiationExpression::ExponentiationExpression(const ExpressionPtr &left, const ExpressionPtr &right)
-	: ArithmeticExpression(left, right)
+ExponentiationExpression::ExponentiationExpression(Parser *parser, const ExpressionPtr &left, const ExpressionPtr &right)
+	: ArithmeticExpression(parser, left, right)
 {
 }
 
+void
+ExponentiationExpression::Compile(CompiledExpression &compiled) const
+{
+	m_left->Compile(compiled);
+	m_right->Compile(compiled);
+	compiled.AddOperation(OpCode::Power, m_position);
+}
+
 double 
 ExponentiationExpression::Evaluate()
 {
-	if (m_left == nullptr || m_right == nullptr)
+	if (!Validate())
+	{
+		ReportError(ErrorCode::InvalidExpression);
 		return 0;
+	}
 
 	double a = m_left->Evaluate();
 	double b = m_right->Evaluate();
@@ -177,16 +253,86 @@ AssignmentExpression::AssignmentExpression(Parser *parser, const VariableExpress
 }
 
 
+void
+AssignmentExpression::Compile(CompiledExpression &compiled) const
+{
+	if (m_value)
+		m_value->Compile(compiled);
+	else
+		compiled.AddNumber(0);
+	compiled.AddAssign(m_var->GetSlot());
+}
+
 double AssignmentExpression::Evaluate() 
 {
 	double x = 0;
 	if (m_value)
 		x = m_value->Evaluate();
 	if (m_var) 
-		m_parser->RecordVariable(m_var->GetVariable(), x);
+		m_parser->RecordVariable(m_var->GetSlot(), x);
 	return x;
 }
 
+IncrementExpression::IncrementExpression(Parser *parser, const std::string &var, double step, bool prefix)
+	: m_step(step), m_prefix(prefix)
+{
+	SetParser(parser);
+	if (m_parser)
+		m_slot = m_parser->GetVariableSlot(var);
+}
+
+void
+IncrementExpression::Compile(CompiledExpression &compiled) const
+{
+	compiled.AddIncrement(m_slot, m_step, m_prefix);
+}
+
+double IncrementExpression::Evaluate()
+{
+	double value = m_parser->LookupVariable(m_slot);
+	m_parser->RecordVariable(m_slot, value + m_step);
+	return m_prefix ? value + m_step : value;
+}
+
+LoopExpression::LoopExpression(Parser *parser, const VariableExpressionPtr &var, const ExpressionPtr &from, const ExpressionPtr &to,
+	const std::vector<ExpressionPtr> &body)
+	: m_var(var), m_from(from), m_to(to), m_body(body)
+{
+	SetParser(parser);
+}
+
+void
+LoopExpression::Compile(CompiledExpression &compiled) const
+{
+	m_from->Compile(compiled);
+	m_to->Compile(compiled);
+	size_t begin = compiled.AddLoopBegin(m_var->GetSlot());
+	for (const ExpressionPtr &statement : m_body)
+	{
+		statement->Compile(compiled);
+		compiled.AddPop();
+	}
+	compiled.AddLoopEnd(m_var->GetSlot(), begin);
+}
+
+double LoopExpression::Evaluate()
+{
+	double counter = m_from->Evaluate();
+	double end = m_to->Evaluate();
+	while (counter < end)
+	{
+		m_parser->RecordVariable(m_var->GetSlot(), counter);
+		for (const ExpressionPtr &statement : m_body)
+			statement->Evaluate();
+		//a counter too large to change when incremented ends the loop too
+		double previous = counter;
+		counter += 1;
+		if (counter == previous)
+			break;
+	}
+	return counter;
+}
+
 FunctionCallExpression::FunctionCallExpression(Parser *parser, const std::string &func, const ExpressionPtr &val)
 	: m_function_name(func), m_value(val)
 {
@@ -202,3 +348,184 @@ FunctionCallExpression::Evaluate()
 	x = m_parser->EvaluateFunction(m_function_name, x);
 	return x;
 }
+
+void
+FunctionCallExpression::Compile(CompiledExpression &compiled) const
+{
+	if (m_value)
+		m_value->Compile(compiled);
+	else
+		compiled.AddNumber(0);
+	compiled.AddCall(m_parser->GetFunction(m_function_name));
+}
+
+BinaryFunctionCallExpression::BinaryFunctionCallExpression(Parser *parser, const std::string &func, const ExpressionPtr &left, const ExpressionPtr &right)
+	: ArithmeticExpression(parser, left, right), m_function_name(func)
+{
+}
+
+double 
+BinaryFunctionCallExpression::Evaluate()
+{
+	if (!Validate())
+	{
+		ReportError(ErrorCode::InvalidExpression);
+		return 0;
+	}
+
+	double a = m_left->Evaluate();
+	double b = m_right->Evaluate();
+	const CompiledExpression::BinaryFunction *function = m_parser->GetBinaryFunction(m_function_name);
+	return function ? m_parser->CallFunction(*function, a, b) : 0;
+}
+
+void
+BinaryFunctionCallExpression::Compile(CompiledExpression &compiled) const
+{
+	m_left->Compile(compiled);
+	m_right->Compile(compiled);
+	compiled.AddCall(m_parser->GetBinaryFunction(m_function_name));
+}
+
+ParameterExpression::ParameterExpression(size_t index)
+	: m_index(index)
+{
+}
+
+double 
+ParameterExpression::Evaluate()
+{
+	return 0;
+}
+
+void
+ParameterExpression::Compile(CompiledExpression &compiled) const
+{
+	compiled.AddArgument(m_index);
+}
+
+UserFunctionCallExpression::UserFunctionCallExpression(Parser *parser, const UserFunctionPtr &func, const std::vector<ExpressionPtr> &arguments)
+	: m_function(func), m_arguments(arguments)
+{
+	SetParser(parser);
+}
+
+double 
+UserFunctionCallExpression::Evaluate()
+{
+	std::vector<double> stack;
+	stack.reserve(m_arguments.size());
+	for (const ExpressionPtr &argument : m_arguments)
+		stack.push_back(argument->Evaluate());
+	return m_function->m_compiled.Evaluate(m_parser, stack, m_arguments.size());
+}
+
+void
+UserFunctionCallExpression::Compile(CompiledExpression &compiled) const
+{
+	for (const ExpressionPtr &argument : m_arguments)
+		argument->Compile(compiled);
+	compiled.Inline(m_function->m_compiled, m_arguments.size());
+}
+
+FunctionDefinitionExpression::FunctionDefinitionExpression(const UserFunctionPtr &func)
+	: m_function(func)
+{
+}
+
+double 
+FunctionDefinitionExpression::Evaluate()
+{
+	return 0;
+}
+
+void
+FunctionDefinitionExpression::Compile(CompiledExpression &) const
+{
+}
+
+SumExpression::SumExpression(Parser *parser, const ExpressionPtr &first)
+	: m_operands{first}, m_signs{1.0}, m_values(1)
+{
+	SetParser(parser);
+}
+
+void
+SumExpression::AddOperand(const ExpressionPtr &operand, bool substract)
+{
+	m_operands.push_back(operand);
+	m_signs.push_back(substract ? -1.0 : 1.0);
+	m_values.push_back(0);
+}
+
+double 
+SumExpression::Evaluate()
+{
+	//gather the operands first, the reduction is then a plain loop over contiguous arrays
+	for (size_t i = 0; i < m_operands.size(); ++i)
+		m_values[i] = m_operands[i]->Evaluate();
+
+	double res = m_values[0];
+	for (size_t i = 1; i < m_values.size(); ++i)
+		res += m_signs[i] * m_values[i];
+	return res;
+}
+
+void
+SumExpression::Compile(CompiledExpression &compiled) const
+{
+	m_operands[0]->Compile(compiled);
+	for (size_t i = 1; i < m_operands.size(); ++i)
+	{
+		m_operands[i]->Compile(compiled);
+		compiled.AddOperation(m_signs[i] < 0 ? OpCode::Substract : OpCode::Add);
+	}
+}
+
+ProductExpression::ProductExpression(Parser *parser, const ExpressionPtr &first)
+	: m_operands{first}, m_ops{OpCode::Multiply}, m_positions{-1}
+{
+	SetParser(parser);
+}
+
+void
+ProductExpression::AddOperand(const ExpressionPtr &operand, OpCode op, int position)
+{
+	m_operands.push_back(operand);
+	m_ops.push_back(op);
+	m_positions.push_back(position);
+}
+
+double 
+ProductExpression::Evaluate()
+{
+	double res = m_operands[0]->Evaluate();
+	for (size_t i = 1; i < m_operands.size(); ++i)
+	{
+		double b = m_operands[i]->Evaluate();
+		if (m_ops[i] == OpCode::Multiply)
+			res = res * b;
+		else if (b == 0.0)
+		{
+			if (m_parser)
+				m_parser->ReportError(m_ops[i] == OpCode::Divide ? ErrorCode::DivisionByZero : ErrorCode::ModulusByZero, m_positions[i]);
+			res = 0;
+		}
+		else if (m_ops[i] == OpCode::Divide)
+			res = res / b;
+		else
+			res = std::fmod(res, b);
+	}
+	return res;
+}
+
+void
+ProductExpression::Compile(CompiledExpression &compiled) const
+{
+	m_operands[0]->Compile(compiled);
+	for (size_t i = 1; i < m_operands.size(); ++i)
+	{
+		m_operands[i]->Compile(compiled);
+		compiled.AddOperation(m_ops[i], m_positions[i]);
+	}
+}
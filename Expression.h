@@ -1,6 +1,9 @@
 #pragma once
+#include "CompiledExpression.h"
+#include "ErrorCode.h"
 #include <string>
 #include <memory>
+#include <vector>
 
 class Parser;
 
@@ -13,12 +16,26 @@ public:
 	Expression();
 	virtual ~Expression() = default;
 
+	//Number of Expression nodes created by the calling thread since it started
+	static size_t GetCreatedCount();
+
 	void SetParser(Parser* parser) { m_parser = parser;}
 
+	//Offset in the statement the expression was read from, -1 if unknown
+	void SetPosition(int position) { m_position = position; }
+	int GetPosition() const { return m_position; }
+
 	virtual double Evaluate() = 0;
+
+	//Append the instructions evaluating this expression, in postfix order
+	virtual void Compile(CompiledExpression &compiled) const = 0;
 protected:
+	//Record an error for the statement being evaluated, no I/O is done here
+	void ReportError(ErrorCode code) const;
+
 	Parser* m_parser = nullptr;
-	
+	int m_position = -1;
+
 };
 
 using ExpressionPtr = std::shared_ptr<Expression>;
@@ -31,6 +48,7 @@ class NumberExpression : public Expression
 public:
 	NumberExpression(double val);
 	virtual double Evaluate() override;
+	virtual void Compile(CompiledExpression &compiled) const override;
 private:
 	double value;
 };
@@ -45,9 +63,12 @@ class VariableExpression : public Expression
 public:
 	VariableExpression(Parser *parser, const std::string& var);
 	virtual double Evaluate() override;
+	virtual void Compile(CompiledExpression &compiled) const override;
 	std::string GetVariable() const { return variable; }
+	size_t GetSlot() const { return m_slot; }
 private:
 	std::string variable;
+	size_t m_slot = 0;
 };
 
 using VariableExpressionPtr = std::shared_ptr<VariableExpression>;
@@ -59,7 +80,7 @@ using VariableExpressionPtr = std::shared_ptr<VariableExpression>;
 class ArithmeticExpression : public Expression
 {
 public:
-	ArithmeticExpression(const ExpressionPtr &left, const ExpressionPtr &right);
+	ArithmeticExpression(Parser *parser, const ExpressionPtr &left, const ExpressionPtr &right);
 protected:
 	virtual bool Validate() const;
 	ExpressionPtr m_left;
@@ -75,8 +96,9 @@ using ArithmeticExpressionPtr = std::shared_ptr<ArithmeticExpression>;
 class AdditionExpression : public ArithmeticExpression
 {
 public:
-	AdditionExpression(const ExpressionPtr &left, const ExpressionPtr &right);
+	AdditionExpression(Parser *parser, const ExpressionPtr &left, const ExpressionPtr &right);
 	virtual double Evaluate() override;
+	virtual void Compile(CompiledExpression &compiled) const override;
 };
 
 using AdditionExpressionPtr = std::shared_ptr<AdditionExpression>;
@@ -89,8 +111,9 @@ using AdditionExpressionPtr = std::shared_ptr<AdditionExpression>;
 class SubstractionExpression : public ArithmeticExpression
 {
 public:
-	SubstractionExpression(const ExpressionPtr &left, const ExpressionPtr &right);
+	SubstractionExpression(Parser *parser, const ExpressionPtr &left, const ExpressionPtr &right);
 	virtual double Evaluate() override;
+	virtual void Compile(CompiledExpression &compiled) const override;
 };
 
 using SubstractionExpressionPtr = std::shared_ptr<SubstractionExpression>;
@@ -102,8 +125,9 @@ using SubstractionExpressionPtr = std::shared_ptr<SubstractionExpression>;
 class MultiplicationExpression : public ArithmeticExpression
 {
 public:
-	MultiplicationExpression(const ExpressionPtr &left, const ExpressionPtr &right);
+	MultiplicationExpression(Parser *parser, const ExpressionPtr &left, const ExpressionPtr &right);
 	virtual double Evaluate() override;	
+	virtual void Compile(CompiledExpression &compiled) const override;
 };
 
 using MultiplicationExpressionPtr = std::shared_ptr<MultiplicationExpression>;
@@ -115,8 +139,9 @@ using MultiplicationExpressionPtr = std::shared_ptr<MultiplicationExpression>;
 class DivisionExpression : public ArithmeticExpression
 {
 public:
-	DivisionExpression(const ExpressionPtr &left, const ExpressionPtr &right);
+	DivisionExpression(Parser *parser, const ExpressionPtr &left, const ExpressionPtr &right);
 	virtual double Evaluate() override;
+	virtual void Compile(CompiledExpression &compiled) const override;
 };
 
 using DivisionExpressionPtr = std::shared_ptr<DivisionExpression>;
@@ -128,8 +153,9 @@ using DivisionExpressionPtr = std::shared_ptr<DivisionExpression>;
 class ModulusExpression : public ArithmeticExpression
 {
 public:
-	ModulusExpression(const ExpressionPtr &left, const ExpressionPtr &right);
+	ModulusExpression(Parser *parser, const ExpressionPtr &left, const ExpressionPtr &right);
 	virtual double Evaluate() override;
+	virtual void Compile(CompiledExpression &compiled) const override;
 };
 
 using ModulusExpressionPtr = std::shared_ptr<ModulusExpression>;
@@ -141,12 +167,56 @@ using ModulusExpressionPtr = std::shared_ptr<ModulusExpression>;
 class ExponentiationExpression : public ArithmeticExpression
 {
 public:
-	ExponentiationExpression(const ExpressionPtr &left, const ExpressionPtr &right);
+	ExponentiationExpression(Parser *parser, const ExpressionPtr &left, const ExpressionPtr &right);
 	virtual double Evaluate() override;
+	virtual void Compile(CompiledExpression &compiled) const override;
 };
 
 using ExponentiationExpressionPtr = std::shared_ptr<ExponentiationExpression>;
 
+/*
+	SumExpression class represents a chain of additions and substractions
+	e.g. a + b - c + d
+	The operands are held in one array and added from left to right, 
+	so the result is the same as the left-deep tree of binary expressions
+*/
+class SumExpression : public Expression
+{
+public:
+	SumExpression(Parser *parser, const ExpressionPtr &first);
+	void AddOperand(const ExpressionPtr &operand, bool substract);
+	virtual double Evaluate() override;
+	virtual void Compile(CompiledExpression &compiled) const override;
+private:
+	std::vector<ExpressionPtr> m_operands;
+	//1 or -1 per operand, a - b is evaluated as a + (-b) which is exact
+	std::vector<double> m_signs;
+	std::vector<double> m_values;
+};
+
+using SumExpressionPtr = std::shared_ptr<SumExpression>;
+
+/*
+	ProductExpression class represents a chain of multiplications, divisions and modulos
+	e.g. a * b / c % d
+	The operands are held in one array and applied from left to right
+*/
+class ProductExpression : public Expression
+{
+public:
+	ProductExpression(Parser *parser, const ExpressionPtr &first);
+	//op is one of OpCode::Multiply, OpCode::Divide or OpCode::Modulus
+	void AddOperand(const ExpressionPtr &operand, OpCode op, int position);
+	virtual double Evaluate() override;
+	virtual void Compile(CompiledExpression &compiled) const override;
+private:
+	std::vector<ExpressionPtr> m_operands;
+	std::vector<OpCode> m_ops;
+	std::vector<int> m_positions;
+};
+
+using ProductExpressionPtr = std::shared_ptr<ProductExpression>;
+
 /*
 	ArithmeticExpressionPtr class represents assigning an expression to a variable
 	e.g. lhs = rhs
@@ -157,6 +227,7 @@ class AssignmentExpression : public Expression
 public:
 	AssignmentExpression(Parser *parser, const VariableExpressionPtr &var, const ExpressionPtr &value);
 	virtual double Evaluate() override;	
+	virtual void Compile(CompiledExpression &compiled) const override;
 private:
 	VariableExpressionPtr m_var;
 	ExpressionPtr m_value;
@@ -164,6 +235,43 @@ private:
 
 using AssignmentExpressionPtr = std::shared_ptr<AssignmentExpression>;
 
+/*
+	IncrementExpression class represents adding a step to a variable when evaluated
+	e.g. ++i evaluates to the new value, i-- to the previous one
+*/
+class IncrementExpression : public Expression
+{
+public:
+	IncrementExpression(Parser *parser, const std::string &var, double step, bool prefix);
+	virtual double Evaluate() override;
+	virtual void Compile(CompiledExpression &compiled) const override;
+private:
+	size_t m_slot = 0;
+	double m_step;
+	bool m_prefix;
+};
+
+/*
+	LoopExpression class represents running statements for every integer step of a range
+	e.g. for i in 0..n: s += i^2
+	The range excludes its end, the value of the loop is the counter once it ended
+*/
+class LoopExpression : public Expression
+{
+public:
+	LoopExpression(Parser *parser, const VariableExpressionPtr &var, const ExpressionPtr &from, const ExpressionPtr &to,
+		const std::vector<ExpressionPtr> &body);
+	virtual double Evaluate() override;
+	virtual void Compile(CompiledExpression &compiled) const override;
+private:
+	VariableExpressionPtr m_var;
+	ExpressionPtr m_from;
+	ExpressionPtr m_to;
+	std::vector<ExpressionPtr> m_body;
+};
+
+using LoopExpressionPtr = std::shared_ptr<LoopExpression>;
+
 /*
 	ArithmeticExpressionPtr class represents applying an expression on a function
 	e.g. f(value)
@@ -173,9 +281,91 @@ class FunctionCallExpression : public Expression
 public:
 	FunctionCallExpression(Parser *parser, const std::string &func, const ExpressionPtr &value);
 	virtual double Evaluate() override;	
+	virtual void Compile(CompiledExpression &compiled) const override;
 private:
 	std::string m_function_name;
 	ExpressionPtr m_value;
 };
 
 using FunctionCallExpressionPtr = std::shared_ptr<FunctionCallExpression>;
+
+/*
+	BinaryFunctionCallExpression class represents applying two expressions on a function
+	e.g. atan2(lhs, rhs)
+*/
+class BinaryFunctionCallExpression : public ArithmeticExpression
+{
+public:
+	BinaryFunctionCallExpression(Parser *parser, const std::string &func, const ExpressionPtr &left, const ExpressionPtr &right);
+	virtual double Evaluate() override;
+	virtual void Compile(CompiledExpression &compiled) const override;
+private:
+	std::string m_function_name;
+};
+
+using BinaryFunctionCallExpressionPtr = std::shared_ptr<BinaryFunctionCallExpression>;
+
+/*
+	ParameterExpression class represents a parameter inside the body of a user function
+	e.g. x in f(x)=x*2
+	Parameters only have a value in the compiled body, when it is called
+*/
+class ParameterExpression : public Expression
+{
+public:
+	ParameterExpression(size_t index);
+	virtual double Evaluate() override;
+	virtual void Compile(CompiledExpression &compiled) const override;
+private:
+	size_t m_index;
+};
+
+using ParameterExpressionPtr = std::shared_ptr<ParameterExpression>;
+
+/*
+	UserFunction utility class to hold a function defined by a statement
+	e.g. f(x,y)=x*x+y
+	The body is parsed and compiled once, every call inlines the compiled body
+*/
+struct UserFunction
+{
+	std::vector<std::string> m_parameters;
+	ExpressionPtr m_body;
+	CompiledExpression m_compiled;
+};
+
+using UserFunctionPtr = std::shared_ptr<const UserFunction>;
+
+/*
+	UserFunctionCallExpression class represents calling a user function
+	e.g. f(a, b+1)
+*/
+class UserFunctionCallExpression : public Expression
+{
+public:
+	UserFunctionCallExpression(Parser *parser, const UserFunctionPtr &func, const std::vector<ExpressionPtr> &arguments);
+	virtual double Evaluate() override;
+	virtual void Compile(CompiledExpression &compiled) const override;
+private:
+	UserFunctionPtr m_function;
+	std::vector<ExpressionPtr> m_arguments;
+};
+
+using UserFunctionCallExpressionPtr = std::shared_ptr<UserFunctionCallExpression>;
+
+/*
+	FunctionDefinitionExpression class represents the statement defining a user function
+	e.g. f(x,y)=x*x+y
+	The function is registered when the statement is parsed, evaluating it does nothing
+*/
+class FunctionDefinitionExpression : public Expression
+{
+public:
+	FunctionDefinitionExpression(const UserFunctionPtr &func);
+	virtual double Evaluate() override;
+	virtual void Compile(CompiledExpression &compiled) const override;
+private:
+	UserFunctionPtr m_function;
+};
+
+using FunctionDefinitionExpressionPtr = std::shared_ptr<FunctionDefinitionExpression>;
@@ -0,0 +1,159 @@
+#include "FunctionCache.h"
+
+#include <cstring>
+
+static uint64_t
+GetBits(double value)
+{
+	uint64_t bits;
+	std::memcpy(&bits, &value, sizeof(bits));
+	return bits;
+}
+
+//Index of the arguments in a table of mask + 1 entries
+static size_t
+GetIndex(uint64_t a, uint64_t b, size_t mask)
+{
+	//the finalizer of splitmix64, every bit of the arguments changes the low bits: small
+	//integers only differ in their exponent and high mantissa bits
+	uint64_t hash = a ^ (b * 0x9E3779B97F4A7C15ull);
+	hash = (hash ^ (hash >> 30)) * 0xBF58476D1CE4E5B9ull;
+	hash = (hash ^ (hash >> 27)) * 0x94D049BB133111EBull;
+	hash ^= hash >> 31;
+	return static_cast<size_t>(hash) & mask;
+}
+
+FunctionCache::FunctionCache(size_t entries)
+	: m_entries(1)
+{
+	while (m_entries < entries)
+		m_entries *= 2;
+}
+
+void
+FunctionCache::AddPureFunction(const std::string &name, const CompiledExpression::Function *function)
+{
+	Add(name, function);
+}
+
+void
+FunctionCache::AddPureFunction(const std::string &name, const CompiledExpression::BinaryFunction *function)
+{
+	Add(name, function);
+}
+
+void
+FunctionCache::Add(const std::string &name, const void *function)
+{
+	if (!function || Find(function))
+		return;
+	Table table;
+	table.m_function = function;
+	table.m_statistics.m_name = name;
+	table.m_entries.assign(m_entries, Entry{0, 0, 0, false});
+	m_tables.push_back(std::move(table));
+	m_last = nullptr;
+}
+
+FunctionCache::Table*
+FunctionCache::Find(const void *function)
+{
+	if (m_last && m_last->m_function == function)
+		return m_last;
+	for (Table &table : m_tables)
+		if (table.m_function == function)
+			return m_last = &table;
+	return nullptr;
+}
+
+double
+FunctionCache::Call(const CompiledExpression::Function &function, double a)
+{
+	Table *table = Find(&function);
+	if (!table)
+		return function(a);
+
+	uint64_t bitsA = GetBits(a);
+	Entry &entry = table->m_entries[GetIndex(bitsA, 0, m_entries - 1)];
+	if (entry.m_used && entry.m_a == bitsA)
+	{
+		++table->m_statistics.m_hits;
+		return entry.m_result;
+	}
+	++table->m_statistics.m_misses;
+	entry = Entry{bitsA, 0, function(a), true};
+	return entry.m_result;
+}
+
+double
+FunctionCache::Call(const CompiledExpression::BinaryFunction &function, double a, double b)
+{
+	Table *table = Find(&function);
+	if (!table)
+		return function(a, b);
+
+	uint64_t bitsA = GetBits(a), bitsB = GetBits(b);
+	Entry &entry = table->m_entries[GetIndex(bitsA, bitsB, m_entries - 1)];
+	if (entry.m_used && entry.m_a == bitsA && entry.m_b == bitsB)
+	{
+		++table->m_statistics.m_hits;
+		return entry.m_result;
+	}
+	++table->m_statistics.m_misses;
+	entry = Entry{bitsA, bitsB, function(a, b), true};
+	return entry.m_result;
+}
+
+void
+FunctionCache::Clear()
+{
+	for (Table &table : m_tables)
+	{
+		table.m_statistics.m_hits = table.m_statistics.m_misses = 0;
+		table.m_entries.assign(m_entries, Entry{0, 0, 0, false});
+	}
+}
+
+size_t
+FunctionCache::GetHits() const
+{
+	size_t hits = 0;
+	for (const Table &table : m_tables)
+		hits += table.m_statistics.m_hits;
+	return hits;
+}
+
+size_t
+FunctionCache::GetMisses() const
+{
+	size_t misses = 0;
+	for (const Table &table : m_tables)
+		misses += table.m_statistics.m_misses;
+	return misses;
+}
+
+double
+FunctionCache::GetHitRate() const
+{
+	size_t hits = GetHits(), calls = hits + GetMisses();
+	return calls ? static_cast<double>(hits) / calls : 0;
+}
+
+std::vector<FunctionCache::FunctionStatistics>
+FunctionCache::GetStatistics() const
+{
+	std::vector<FunctionStatistics> statistics;
+	for (const Table &table : m_tables)
+		statistics.push_back(table.m_statistics);
+	return statistics;
+}
+
+void
+FunctionCache::PrintStatistics(std::ostream &out) const
+{
+	out << "Function cache: " << GetHits() << " hits, " << GetMisses() << " misses" << std::endl;
+	for (const Table &table : m_tables)
+		if (table.m_statistics.m_hits + table.m_statistics.m_misses)
+			out << "  " << table.m_statistics.m_name << ": " << table.m_statistics.m_hits << " hits, "
+				<< table.m_statistics.m_misses << " misses" << std::endl;
+}
@@ -0,0 +1,85 @@
+#pragma once
+#include "CompiledExpression.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <vector>
+
+/*
+	FunctionCache class keeps the last results of pure functions, those always giving the same
+	result for the same arguments, so a call repeated with the same arguments, e.g. sin(60) in
+	many statements, is not computed again, see Parser::SetFunctionCache.
+
+	Each function registered as pure has a table of a bounded number of entries, found by a hash
+	of the bits of the arguments, a new result replacing the one of its entry. Arguments are
+	compared by their bits, so -0 and 0 are different arguments and a NaN matches itself.
+	A function which was not registered is always called. Not thread safe, one cache per thread
+*/
+class FunctionCache
+{
+public:
+	/*
+		FunctionStatistics utility class to hold the calls of a registered function
+	*/
+	struct FunctionStatistics
+	{
+		std::string m_name;
+		size_t m_hits = 0;
+		size_t m_misses = 0;
+	};
+
+	//entries by function, rounded up to a power of 2
+	explicit FunctionCache(size_t entries = 256);
+
+	//Cache the results of function, which must be pure
+	void AddPureFunction(const std::string &name, const CompiledExpression::Function *function);
+	void AddPureFunction(const std::string &name, const CompiledExpression::BinaryFunction *function);
+
+	double Call(const CompiledExpression::Function &function, double a);
+	double Call(const CompiledExpression::BinaryFunction &function, double a, double b);
+
+	//Forget the results and the statistics, the functions stay registered
+	void Clear();
+
+	size_t GetEntries() const { return m_entries; }
+	size_t GetHits() const;
+	size_t GetMisses() const;
+	double GetHitRate() const;
+	//Calls of every registered function by the order of registration
+	std::vector<FunctionStatistics> GetStatistics() const;
+	//Print the hits and misses of every called function
+	void PrintStatistics(std::ostream &out) const;
+
+private:
+	/*
+		Entry utility class to hold the result of a call by the bits of its arguments
+	*/
+	struct Entry
+	{
+		uint64_t m_a;
+		uint64_t m_b;
+		double m_result;
+		bool m_used;
+	};
+
+	/*
+		Table utility class to hold the entries and the statistics of a function
+	*/
+	struct Table
+	{
+		const void *m_function;
+		FunctionStatistics m_statistics;
+		std::vector<Entry> m_entries;
+	};
+
+	//Table of function, null if it was not registered
+	Table* Find(const void *function);
+	void Add(const std::string &name, const void *function);
+
+	size_t m_entries;
+	std::vector<Table> m_tables;
+	//Last table found, calls of the same function often follow each other
+	Table *m_last = nullptr;
+};
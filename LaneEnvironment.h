@@ -0,0 +1,277 @@
+#pragma once
+#include "CompiledExpression.h"
+#include "ErrorCode.h"
+#include "Lanes.h"
+#include "Parser.h"
+#include "Program.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <ostream>
+#include <string>
+#include <vector>
+
+/*
+	LaneEnvironment class template runs a Program for K sets of inputs at once: every variable
+	holds K values of type V, see Lanes, so each instruction is dispatched once for the K runs.
+
+	A lane gives the same variables and errors as its own run with an Environment. Statements
+	with a loop are evaluated lane by lane, as the number of steps may differ between lanes.
+	A statement failing in any lane is evaluated again lane by lane from its previous values,
+	so the other lanes keep their results and each lane reports its own errors.
+	In another type than double a lane gives the results of a NumericEngine in that type
+*/
+template <size_t K, typename V = double>
+class LaneEnvironment
+{
+public:
+	explicit LaneEnvironment(const Program &program);
+
+	//Back to the initial values of the program in every lane
+	void Reset();
+	//Evaluate every statement of the program in every lane
+	void Run();
+
+	//Set an input of the program in a lane, false if the program does not know the variable
+	bool RecordVariable(size_t lane, const std::string &var, double value);
+	double LookupVariable(size_t lane, const std::string &var) const;
+	bool HasVariable(size_t lane, const std::string &var) const;
+
+	//Print the variables of a lane in the format of Parser::PrintVariables
+	void PrintVariables(size_t lane, std::ostream &out) const;
+
+	//Errors of the last run of a lane, at most one per statement, by statement order
+	const std::vector<Parser::StatementError>& GetErrors(size_t lane) const { return m_errors[lane]; }
+	//Statements of the last run evaluated lane by lane
+	size_t GetSplitStatements() const { return m_split; }
+
+	const Lanes<K, V>& LookupVariable(size_t slot) const { return m_values[slot]; }
+	void RecordVariable(size_t slot, const Lanes<K, V> &value)
+	{
+		m_values[slot] = value;
+		if (m_allDefined[slot])
+			return;
+		for (size_t lane = 0; lane < K; ++lane)
+			if (!m_defined[slot * K + lane])
+			{
+				m_defined[slot * K + lane] = true;
+				m_order[lane].push_back(slot);
+			}
+		m_allDefined[slot] = true;
+	}
+	void ReportError(ErrorCode, int) { m_failed = true; }
+
+private:
+	/*
+		Lane utility class to evaluate a statement in a single lane, in V
+	*/
+	class Lane
+	{
+	public:
+		Lane(LaneEnvironment &environment, size_t lane)
+			: m_environment(environment)
+			, m_lane(lane)
+		{
+		}
+
+		V LookupVariable(size_t slot) const { return m_environment.m_values[slot].m_lane[m_lane]; }
+		void RecordVariable(size_t slot, V value)
+		{
+			m_environment.m_values[slot].m_lane[m_lane] = value;
+			m_environment.Define(slot, m_lane);
+		}
+		void ReportError(ErrorCode code, int position)
+		{
+			std::vector<Parser::StatementError> &errors = m_environment.m_errors[m_lane];
+			//only the first error of a statement is kept
+			if (errors.empty() || errors.back().m_statement != m_environment.m_currentStatement)
+				errors.push_back(Parser::StatementError(code, m_environment.m_currentStatement, position));
+		}
+
+	private:
+		LaneEnvironment &m_environment;
+		size_t m_lane;
+	};
+
+	void Define(size_t slot, size_t lane)
+	{
+		char &defined = m_defined[slot * K + lane];
+		if (defined)
+			return;
+		defined = true;
+		m_order[lane].push_back(slot);
+		bool all = true;
+		for (size_t i = 0; i < K; ++i)
+			all = all && m_defined[slot * K + i];
+		m_allDefined[slot] = all;
+	}
+
+	//Evaluate the statement in every lane one after the other
+	void RunLanes(const CompiledExpression &compiled);
+
+	const Program &m_program;
+	std::vector<Lanes<K, V>> m_values;
+	//Whether the variable is defined by slot then by lane, and in every lane by slot
+	std::vector<char> m_defined;
+	std::vector<char> m_allDefined;
+	//Slots of the defined variables by the order of creation, by lane
+	std::vector<std::vector<size_t>> m_order;
+	std::vector<std::vector<Parser::StatementError>> m_errors;
+	//Whether the statement has a loop, or may fail, and the slots it assigns, by statement
+	std::vector<char> m_loops;
+	std::vector<char> m_fallible;
+	std::vector<std::vector<size_t>> m_assigned;
+	std::vector<Lanes<K, V>> m_stack;
+	std::vector<V> m_laneStack;
+	size_t m_currentStatement = 0;
+	size_t m_split = 0;
+	bool m_failed = false;
+};
+
+template <size_t K, typename V>
+LaneEnvironment<K, V>::LaneEnvironment(const Program &program)
+	: m_program(program)
+	, m_order(K)
+	, m_errors(K)
+{
+	for (const CompiledExpression &compiled : program.m_compiled)
+	{
+		m_loops.push_back(false);
+		m_fallible.push_back(false);
+		m_assigned.emplace_back();
+		for (const Instruction &instruction : compiled.GetCode())
+		{
+			m_loops.back() |= instruction.m_op == OpCode::LoopBegin;
+			m_fallible.back() |= instruction.m_op == OpCode::Divide || instruction.m_op == OpCode::Modulus;
+			if (instruction.m_op == OpCode::Assign || instruction.m_op == OpCode::Increment || instruction.m_op == OpCode::PostIncrement)
+				m_assigned.back().push_back(instruction.m_index);
+		}
+	}
+	Reset();
+}
+
+template <size_t K, typename V>
+void
+LaneEnvironment<K, V>::Reset()
+{
+	m_values.assign(m_program.m_initialValues.begin(), m_program.m_initialValues.end());
+	m_defined.assign(m_values.size() * K, false);
+	m_allDefined.assign(m_values.size(), false);
+	for (size_t lane = 0; lane < K; ++lane)
+	{
+		m_order[lane].clear();
+		m_errors[lane].clear();
+		for (size_t slot : m_program.m_initialOrder)
+			Define(slot, lane);
+	}
+}
+
+template <size_t K, typename V>
+void
+LaneEnvironment<K, V>::Run()
+{
+	for (std::vector<Parser::StatementError> &errors : m_errors)
+		errors.clear();
+	m_split = 0;
+	//values of the slots a fallible statement assigns before it, with whether they were defined
+	std::vector<Lanes<K, V>> savedValues;
+	std::vector<char> savedDefined;
+	std::vector<size_t> orders(K);
+
+	for (m_currentStatement = 0; m_currentStatement < m_program.m_compiled.size(); ++m_currentStatement)
+	{
+		const CompiledExpression &compiled = m_program.m_compiled[m_currentStatement];
+		if (m_loops[m_currentStatement])
+		{
+			RunLanes(compiled);
+			continue;
+		}
+
+		const std::vector<size_t> &assigned = m_assigned[m_currentStatement];
+		if (m_fallible[m_currentStatement])
+		{
+			savedValues.clear();
+			savedDefined.clear();
+			for (size_t slot : assigned)
+			{
+				savedValues.push_back(m_values[slot]);
+				savedDefined.insert(savedDefined.end(), m_defined.begin() + slot * K, m_defined.begin() + (slot + 1) * K);
+			}
+			for (size_t lane = 0; lane < K; ++lane)
+				orders[lane] = m_order[lane].size();
+		}
+		m_failed = false;
+		compiled.template Evaluate<Lanes<K, V>>(*this, m_stack);
+		if (!m_failed)
+			continue;
+
+		//back to the values before the statement, restored in reverse for a slot assigned twice
+		for (size_t i = assigned.size(); i-- > 0;)
+		{
+			size_t slot = assigned[i];
+			std::vector<char>::const_iterator defined = savedDefined.begin() + i * K;
+			m_values[slot] = savedValues[i];
+			std::copy(defined, defined + K, m_defined.begin() + slot * K);
+			m_allDefined[slot] = std::find(defined, defined + K, false) == defined + K;
+		}
+		for (size_t lane = 0; lane < K; ++lane)
+			m_order[lane].resize(orders[lane]);
+		RunLanes(compiled);
+	}
+}
+
+template <size_t K, typename V>
+void
+LaneEnvironment<K, V>::RunLanes(const CompiledExpression &compiled)
+{
+	++m_split;
+	for (size_t lane = 0; lane < K; ++lane)
+	{
+		Lane environment(*this, lane);
+		compiled.template Evaluate<V>(environment, m_laneStack);
+	}
+}
+
+template <size_t K, typename V>
+bool
+LaneEnvironment<K, V>::RecordVariable(size_t lane, const std::string &var, double value)
+{
+	size_t slot(0);
+	if (!m_program.FindVariable(var, slot))
+		return false;
+	Lane(*this, lane).RecordVariable(slot, Numeric<V>::FromDouble(value));
+	return true;
+}
+
+template <size_t K, typename V>
+double
+LaneEnvironment<K, V>::LookupVariable(size_t lane, const std::string &var) const
+{
+	size_t slot(0);
+	return m_program.FindVariable(var, slot) ? static_cast<double>(m_values[slot].m_lane[lane]) : 0;
+}
+
+template <size_t K, typename V>
+bool
+LaneEnvironment<K, V>::HasVariable(size_t lane, const std::string &var) const
+{
+	size_t slot(0);
+	return m_program.FindVariable(var, slot) && m_defined[slot * K + lane];
+}
+
+template <size_t K, typename V>
+void
+LaneEnvironment<K, V>::PrintVariables(size_t lane, std::ostream &out) const
+{
+	out << "(";
+	bool first = true;
+	for (size_t slot : m_order[lane])
+	{
+		if (first)
+			first = false;
+		else
+			out << ",";
+		out << m_program.GetVariableName(slot) << "=" << m_values[slot].m_lane[lane];
+	}
+	out << ")" << std::endl;
+}
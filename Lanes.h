@@ -0,0 +1,103 @@
+#pragma once
+#include "Numeric.h"
+
+#include <cmath>
+#include <cstddef>
+
+/*
+	Lanes class template holds the values of a variable in K independent evaluations of the
+	same statements, one per lane, in the value type V. Every instruction applies to all the
+	lanes at once, in short loops the compiler vectorizes
+*/
+template <size_t K, typename V = double>
+struct Lanes
+{
+	Lanes(double value = 0)
+	{
+		for (size_t i = 0; i < K; ++i)
+			m_lane[i] = static_cast<V>(value);
+	}
+
+	V m_lane[K];
+};
+
+/*
+	Lane-wise arithmetic. ToDouble is the first lane, a loop has to be evaluated lane by lane.
+	Built-in functions are computed in double and their result converted back, as Numeric<V>
+*/
+template <size_t K, typename V>
+struct Numeric<Lanes<K, V>>
+{
+	using T = Lanes<K, V>;
+
+	static T FromDouble(double value) { return T(value); }
+	static double ToDouble(const T &value) { return static_cast<double>(value.m_lane[0]); }
+	//True if any lane is 0, so a division by zero in a single lane is reported
+	static bool IsZero(const T &value)
+	{
+		bool zero = false;
+		for (size_t i = 0; i < K; ++i)
+			zero |= value.m_lane[i] == 0;
+		return zero;
+	}
+
+	static T Add(const T &a, const T &b)
+	{
+		T res;
+		for (size_t i = 0; i < K; ++i)
+			res.m_lane[i] = a.m_lane[i] + b.m_lane[i];
+		return res;
+	}
+	static T Substract(const T &a, const T &b)
+	{
+		T res;
+		for (size_t i = 0; i < K; ++i)
+			res.m_lane[i] = a.m_lane[i] - b.m_lane[i];
+		return res;
+	}
+	static T Multiply(const T &a, const T &b)
+	{
+		T res;
+		for (size_t i = 0; i < K; ++i)
+			res.m_lane[i] = a.m_lane[i] * b.m_lane[i];
+		return res;
+	}
+	static T Divide(const T &a, const T &b)
+	{
+		T res;
+		for (size_t i = 0; i < K; ++i)
+			res.m_lane[i] = a.m_lane[i] / b.m_lane[i];
+		return res;
+	}
+	static T Modulus(const T &a, const T &b)
+	{
+		T res;
+		for (size_t i = 0; i < K; ++i)
+			res.m_lane[i] = std::fmod(a.m_lane[i], b.m_lane[i]);
+		return res;
+	}
+	static T Power(const T &a, const T &b)
+	{
+		T res;
+		for (size_t i = 0; i < K; ++i)
+			res.m_lane[i] = std::pow(a.m_lane[i], b.m_lane[i]);
+		return res;
+	}
+
+	template <typename Function>
+	static T Call(const Function &function, const T &a)
+	{
+		T res;
+		for (size_t i = 0; i < K; ++i)
+			res.m_lane[i] = static_cast<V>(function(a.m_lane[i]));
+		return res;
+	}
+	template <typename Function>
+	static T Call(const Function &function, const T &a, const T &b)
+	{
+		T res;
+		for (size_t i = 0; i < K; ++i)
+			res.m_lane[i] = static_cast<V>(function(a.m_lane[i], b.m_lane[i]));
+		return res;
+	}
+};
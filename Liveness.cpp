@@ -0,0 +1,108 @@
+#include "Liveness.h"
+
+#include <algorithm>
+
+std::vector<char>
+FindLiveStatements(const std::vector<CompiledExpression> &statements, const std::vector<size_t> &observed, size_t slots)
+{
+	std::vector<char> live(statements.size(), false);
+	//variables whose value may still be needed, from the end backwards
+	std::vector<char> needed(slots, false);
+	for (size_t slot : observed)
+		needed[slot] = true;
+
+	//assigned, killed and read slots of a statement, killed being assigned for sure and read
+	//only counting reads before any assignment of the statement
+	std::vector<size_t> assigned, killed, read;
+	//assignments so far by loop nesting, those of a loop body are forgotten at its end
+	std::vector<std::vector<size_t>> scopes;
+	auto isAssigned = [&scopes](size_t slot) {
+		for (const std::vector<size_t> &scope : scopes)
+			if (std::find(scope.begin(), scope.end(), slot) != scope.end())
+				return true;
+		return false;
+	};
+	auto assign = [&](size_t slot) {
+		assigned.push_back(slot);
+		scopes.back().push_back(slot);
+		if (scopes.size() == 1)
+			killed.push_back(slot);
+	};
+
+	for (size_t statement = statements.size(); statement-- > 0;)
+	{
+		assigned.clear();
+		killed.clear();
+		read.clear();
+		scopes.assign(1, std::vector<size_t>());
+		for (const Instruction &instruction : statements[statement].GetCode())
+		{
+			switch (instruction.m_op)
+			{
+			case OpCode::Variable:
+				if (!isAssigned(instruction.m_index))
+					read.push_back(instruction.m_index);
+				break;
+			case OpCode::Increment:
+			case OpCode::PostIncrement:
+				if (!isAssigned(instruction.m_index))
+					read.push_back(instruction.m_index);
+				assign(instruction.m_index);
+				break;
+			case OpCode::Assign:
+				assign(instruction.m_index);
+				break;
+			case OpCode::LoopBegin:
+				//the variable of the loop is assigned whenever its body runs
+				scopes.emplace_back();
+				assign(instruction.m_index);
+				break;
+			case OpCode::LoopEnd:
+				scopes.pop_back();
+				break;
+			default:
+				break;
+			}
+		}
+
+		for (size_t slot : assigned)
+			live[statement] = live[statement] || needed[slot];
+		if (!live[statement])
+			continue;
+		for (size_t slot : killed)
+			needed[slot] = false;
+		for (size_t slot : read)
+			needed[slot] = true;
+	}
+	return live;
+}
+
+std::vector<size_t>
+FindConditionalAssignments(const CompiledExpression &compiled)
+{
+	const std::vector<Instruction> &code = compiled.GetCode();
+	std::vector<size_t> certain, conditional;
+	//whether the loops being read surely run, by nesting
+	std::vector<char> runs(1, true);
+	for (size_t i = 0; i < code.size(); ++i)
+	{
+		const Instruction &instruction = code[i];
+		if (instruction.m_op == OpCode::LoopBegin)
+		{
+			//a range of two numbers is the only one known before running, e.g. 0..10
+			bool nonEmpty = i >= 2 && code[i - 2].m_op == OpCode::Number && code[i - 1].m_op == OpCode::Number &&
+				code[i - 2].m_value < code[i - 1].m_value;
+			runs.push_back(runs.back() && nonEmpty);
+		}
+		else if (instruction.m_op == OpCode::LoopEnd)
+			runs.pop_back();
+		if (instruction.m_op == OpCode::Assign || instruction.m_op == OpCode::LoopBegin)
+			(runs.back() ? certain : conditional).push_back(instruction.m_index);
+	}
+
+	std::vector<size_t> slots;
+	for (size_t slot : conditional)
+		if (std::find(certain.begin(), certain.end(), slot) == certain.end() && std::find(slots.begin(), slots.end(), slot) == slots.end())
+			slots.push_back(slot);
+	return slots;
+}
@@ -0,0 +1,23 @@
+#pragma once
+#include "CompiledExpression.h"
+
+#include <cstddef>
+#include <vector>
+
+/*
+	Liveness analysis of statements evaluated in order, only some variables being observed
+	once they all ran. A statement is live when a variable it assigns is observed or read by
+	a later live statement before being assigned again. ++ and -- read and assign, so do the
+	compound assignments, e.g. s += 1. A loop may run zero times so its assignments do not
+	hide the previous ones, but its body reads its own variable and what it assigned before,
+	e.g. i in for i in 0..n: {t = i; t *= 2}. A statement assigning nothing, e.g. 1+2, is never live.
+*/
+
+//Whether every statement is live, by statement order. observed and slots count the slots
+//of the variables, every slot the statements refer to must be below slots
+std::vector<char> FindLiveStatements(const std::vector<CompiledExpression> &statements, const std::vector<size_t> &observed, size_t slots);
+
+//Slots compiled only assigns in a loop which may run zero times, its range not being two
+//increasing numbers: whether they are defined once it ran is only known by running it,
+//e.g. x in for i in 0..n: x = i
+std::vector<size_t> FindConditionalAssignments(const CompiledExpression &compiled);
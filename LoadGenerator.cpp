@@ -0,0 +1,165 @@
+#include "LoadGenerator.h"
+#include "EvaluationServer.h"
+
+#include <chrono>
+#include <deque>
+#include <thread>
+#include <vector>
+
+#ifdef __linux__
+#include <cerrno>
+#include <cstring>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#endif
+
+using Clock = std::chrono::steady_clock;
+
+#ifdef __linux__
+
+static int
+Connect(const std::string &socketPath)
+{
+	sockaddr_un address{};
+	address.sun_family = AF_UNIX;
+	if (socketPath.size() >= sizeof(address.sun_path))
+		return -1;
+	std::strncpy(address.sun_path, socketPath.c_str(), sizeof(address.sun_path) - 1);
+
+	int fd = ::socket(AF_UNIX, SOCK_STREAM, 0);
+	if (fd >= 0 && ::connect(fd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0)
+	{
+		::close(fd);
+		fd = -1;
+	}
+	return fd;
+}
+
+static bool
+SendAll(int fd, const std::string &buffer)
+{
+	size_t written = 0;
+	while (written < buffer.size())
+	{
+		ssize_t sent = ::send(fd, buffer.data() + written, buffer.size() - written, MSG_NOSIGNAL);
+		if (sent < 0 && errno == EINTR)
+			continue;
+		if (sent <= 0)
+			return false;
+		written += sent;
+	}
+	return true;
+}
+
+//Send requests keeping pipeline of them in flight, false if the connection failed
+static bool
+RunClient(const std::string &socketPath, const LoadGenerator::Options &options, size_t requests,
+	LogHistogram &latency, std::string &lastResponse)
+{
+	int fd = Connect(socketPath);
+	if (fd < 0)
+		return false;
+
+	std::string frame;
+	EvaluationServer::AppendFrame(frame, options.m_request);
+	std::deque<Clock::time_point> inFlight;
+	std::string input, response;
+	size_t sent = 0, answered = 0;
+	char buffer[64 * 1024];
+	while (answered < requests)
+	{
+		//fill the pipeline with one write
+		std::string batch;
+		for (; sent < requests && inFlight.size() < options.m_pipeline; ++sent)
+		{
+			batch += frame;
+			inFlight.push_back(Clock::now());
+		}
+		if (!batch.empty() && !SendAll(fd, batch))
+			break;
+
+		ssize_t received = ::read(fd, buffer, sizeof(buffer));
+		if (received < 0 && errno == EINTR)
+			continue;
+		if (received <= 0)
+			break;
+		input.append(buffer, received);
+
+		size_t offset = 0;
+		while (EvaluationServer::ReadFrame(input, offset, response))
+		{
+			Clock::time_point now = Clock::now();
+			latency.Record(std::chrono::duration_cast<std::chrono::nanoseconds>(now - inFlight.front()).count());
+			inFlight.pop_front();
+			++answered;
+		}
+		input.erase(0, offset);
+	}
+	lastResponse = response;
+	::close(fd);
+	return answered == requests;
+}
+
+LoadGenerator::Result
+LoadGenerator::Run(const std::string &socketPath, const Options &options)
+{
+	Result result;
+	size_t clients = options.m_clients ? options.m_clients : 1;
+	std::vector<LogHistogram> latencies(clients);
+	std::vector<std::string> responses(clients);
+	std::vector<char> succeeded(clients, false);
+	std::vector<std::thread> threads;
+
+	Clock::time_point start = Clock::now();
+	for (size_t client = 0; client < clients; ++client)
+	{
+		//the first clients send the remainder
+		size_t requests = options.m_requests / clients + (client < options.m_requests % clients ? 1 : 0);
+		threads.emplace_back([&, client, requests]() {
+			succeeded[client] = RunClient(socketPath, options, requests, latencies[client], responses[client]);
+		});
+	}
+	for (std::thread &thread : threads)
+		thread.join();
+	result.m_seconds = std::chrono::duration<double>(Clock::now() - start).count();
+
+	for (size_t client = 0; client < clients; ++client)
+	{
+		result.m_latency.Add(latencies[client]);
+		if (!succeeded[client])
+			++result.m_failedClients;
+	}
+	result.m_requests = result.m_latency.GetCount();
+	result.m_lastResponse = responses[0];
+	return result;
+}
+
+#else
+
+LoadGenerator::Result
+LoadGenerator::Run(const std::string &, const Options &options)
+{
+	Result result;
+	result.m_failedClients = options.m_clients;
+	return result;
+}
+
+#endif
+
+void
+LoadGenerator::WriteJson(std::ostream &out, const Options &options, const Result &result)
+{
+	const LogHistogram &latency = result.m_latency;
+	out << "{\"clients\": " << options.m_clients
+		<< ", \"pipeline\": " << options.m_pipeline
+		<< ", \"requests\": " << result.m_requests
+		<< ", \"failed_clients\": " << result.m_failedClients
+		<< ", \"seconds\": " << result.m_seconds
+		<< ", \"requests_per_second\": " << (result.m_seconds > 0 ? result.m_requests / result.m_seconds : 0)
+		<< ", \"latency_ns\": {\"mean\": " << latency.GetMean()
+		<< ", \"p50\": " << latency.GetPercentile(50)
+		<< ", \"p99\": " << latency.GetPercentile(99)
+		<< ", \"p999\": " << latency.GetPercentile(99.9)
+		<< ", \"max\": " << latency.GetMax() << "}}" << std::endl;
+}
@@ -0,0 +1,37 @@
+#pragma once
+#include "StatementProfiler.h"
+
+#include <cstddef>
+#include <ostream>
+#include <string>
+
+/*
+	LoadGenerator class measures an EvaluationServer: every client connects on its own thread
+	and keeps a number of requests in flight until it has sent its share
+*/
+class LoadGenerator
+{
+public:
+	struct Options
+	{
+		size_t m_clients = 8;
+		size_t m_requests = 10000;
+		//Requests a client sends before waiting for the first answer
+		size_t m_pipeline = 16;
+		std::string m_request = "a=1+2*3\nb=a^2-sin(a)\nc=max(a,b)%7";
+	};
+
+	struct Result
+	{
+		size_t m_requests = 0;
+		size_t m_failedClients = 0;
+		double m_seconds = 0;
+		//Nanoseconds from sending a request to reading its answer
+		LogHistogram m_latency;
+		//Answer to the last request of the first client
+		std::string m_lastResponse;
+	};
+
+	static Result Run(const std::string &socketPath, const Options &options);
+	static void WriteJson(std::ostream &out, const Options &options, const Result &result);
+};
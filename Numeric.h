@@ -0,0 +1,105 @@
+#pragma once
+#include <cmath>
+#include <cstdint>
+#include <limits>
+
+/*
+	Numeric class template holds the arithmetic CompiledExpression applies on its value type
+	Built-in functions are computed in double by Call and their result converted back
+*/
+template <typename T>
+struct Numeric
+{
+	static T FromDouble(double value) { return static_cast<T>(value); }
+	static double ToDouble(T value) { return static_cast<double>(value); }
+	//Whether a divisor makes / and % report an error
+	static bool IsZero(T value) { return value == T(0); }
+
+	static T Add(T a, T b) { return a + b; }
+	static T Substract(T a, T b) { return a - b; }
+	static T Multiply(T a, T b) { return a * b; }
+	static T Divide(T a, T b) { return a / b; }
+	static T Modulus(T a, T b) { return std::fmod(a, b); }
+	static T Power(T a, T b) { return std::pow(a, b); }
+
+	template <typename Function>
+	static T Call(const Function &function, T a) { return FromDouble(function(ToDouble(a))); }
+	template <typename Function>
+	static T Call(const Function &function, T a, T b) { return FromDouble(function(ToDouble(a), ToDouble(b))); }
+};
+
+/*
+	Exact integer arithmetic: % is the remainder of the truncating division, ^ multiplies
+	and an overflow wraps around instead of being undefined, setting s_overflow. A value
+	out of range, e.g. a literal or a function result, saturates and sets s_overflow too
+*/
+template <>
+struct Numeric<int64_t>
+{
+	//Set by an operation which wrapped around, cleared by the caller checking it, see NumericEngine
+	static inline thread_local bool s_overflow = false;
+
+	static int64_t FromDouble(double value)
+	{
+		//out of range and NaN have no integer value, 2^63 is the first double above the range
+		const double limit = 9223372036854775807.0;
+		if (value >= -limit && value < limit)
+			return static_cast<int64_t>(value);
+		s_overflow = true;
+		if (std::isnan(value))
+			return 0;
+		return value < 0 ? std::numeric_limits<int64_t>::min() : std::numeric_limits<int64_t>::max();
+	}
+	static double ToDouble(int64_t value) { return static_cast<double>(value); }
+	static bool IsZero(int64_t value) { return value == 0; }
+
+#if defined(__GNUC__)
+	static int64_t Add(int64_t a, int64_t b) { int64_t r; s_overflow |= __builtin_add_overflow(a, b, &r); return r; }
+	static int64_t Substract(int64_t a, int64_t b) { int64_t r; s_overflow |= __builtin_sub_overflow(a, b, &r); return r; }
+	static int64_t Multiply(int64_t a, int64_t b) { int64_t r; s_overflow |= __builtin_mul_overflow(a, b, &r); return r; }
+#else
+	static int64_t Add(int64_t a, int64_t b)
+	{
+		int64_t r = static_cast<int64_t>(static_cast<uint64_t>(a) + static_cast<uint64_t>(b));
+		s_overflow |= (a < 0) == (b < 0) && (r < 0) != (a < 0);
+		return r;
+	}
+	static int64_t Substract(int64_t a, int64_t b)
+	{
+		int64_t r = static_cast<int64_t>(static_cast<uint64_t>(a) - static_cast<uint64_t>(b));
+		s_overflow |= (a < 0) != (b < 0) && (r < 0) != (a < 0);
+		return r;
+	}
+	static int64_t Multiply(int64_t a, int64_t b)
+	{
+		int64_t r = static_cast<int64_t>(static_cast<uint64_t>(a) * static_cast<uint64_t>(b));
+		s_overflow |= a && ((a == -1 && b == std::numeric_limits<int64_t>::min()) || (b == -1 && a == std::numeric_limits<int64_t>::min()) || r / a != b);
+		return r;
+	}
+#endif
+	static int64_t Divide(int64_t a, int64_t b) { return b == -1 ? Substract(0, a) : a / b; }
+	static int64_t Modulus(int64_t a, int64_t b) { return b == -1 ? 0 : a % b; }
+
+	template <typename Function>
+	static int64_t Call(const Function &function, int64_t a) { return FromDouble(function(ToDouble(a))); }
+	template <typename Function>
+	static int64_t Call(const Function &function, int64_t a, int64_t b) { return FromDouble(function(ToDouble(a), ToDouble(b))); }
+
+	static int64_t Power(int64_t base, int64_t exponent)
+	{
+		//the integer part of base^exponent for a negative exponent
+		if (exponent < 0)
+			return base == 1 ? 1 : base == -1 ? (exponent % 2 ? -1 : 1) : 0;
+
+		//the base is not squared past the last bit, it could overflow without changing the result
+		int64_t result = 1;
+		for (; exponent; exponent >>= 1)
+		{
+			if (exponent & 1)
+				result = Multiply(result, base);
+			if (exponent > 1)
+				base = Multiply(base, base);
+		}
+		return result;
+	}
+};
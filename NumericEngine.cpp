@@ -0,0 +1,177 @@
+#include "NumericEngine.h"
+
+#include <cmath>
+
+bool
+ParseNumericType(const std::string &name, NumericType &type)
+{
+	for (NumericType candidate : {NumericType::Float, NumericType::Double, NumericType::LongDouble, NumericType::Int64, NumericType::Auto})
+	{
+		if (name == GetNumericTypeName(candidate))
+		{
+			type = candidate;
+			return true;
+		}
+	}
+	return false;
+}
+
+const char*
+GetNumericTypeName(NumericType type)
+{
+	switch (type)
+	{
+	case NumericType::Float:		return "float";
+	case NumericType::Double:		return "double";
+	case NumericType::LongDouble:	return "long-double";
+	case NumericType::Int64:		return "int64";
+	case NumericType::Auto:			return "auto";
+	}
+	return "unknown";
+}
+
+static bool
+IsExactInteger(double value, double min)
+{
+	//beyond 2^53 a double literal may already be rounded
+	return std::floor(value) == value && value >= min && value <= 9007199254740992.0;
+}
+
+bool
+IsIntegerPreserving(const CompiledExpression &compiled)
+{
+	const std::vector<Instruction> &code = compiled.GetCode();
+	for (size_t i = 0; i < code.size(); ++i)
+	{
+		switch (code[i].m_op)
+		{
+		case OpCode::Number:
+			if (!IsExactInteger(code[i].m_value, -9007199254740992.0))
+				return false;
+			break;
+		case OpCode::Power:
+			//the exponent must be the number just before
+			if (i == 0 || code[i - 1].m_op != OpCode::Number || !IsExactInteger(code[i - 1].m_value, 0))
+				return false;
+			break;
+		case OpCode::Divide:
+		case OpCode::Call:
+		case OpCode::Call2:
+			return false;
+		default:
+			break;
+		}
+	}
+	return true;
+}
+
+static bool
+HasOnlyIntegers(const Parser &parser)
+{
+	for (size_t slot : parser.GetVariableOrder())
+		if (!IsExactInteger(parser.LookupVariable(slot), -9007199254740992.0))
+			return false;
+	return true;
+}
+
+NumericEngine::NumericEngine(Parser &parser, NumericType type)
+	: m_parser(parser)
+	, m_type(type)
+	, m_selected(type)
+	, m_float(parser)
+	, m_longDouble(parser)
+	, m_int64(parser)
+{
+}
+
+void
+NumericEngine::EvaluateStatements()
+{
+	m_parser.ClearErrors();
+	if (m_type != NumericType::Auto)
+	{
+		EvaluateStatements(m_type);
+		return;
+	}
+	if (HasOnlyIntegers(m_parser))
+	{
+		//an overflow wraps around in int64, the variables are restored to run again in double
+		std::vector<std::pair<size_t, double>> initial;
+		for (size_t slot : m_parser.GetVariableOrder())
+			initial.emplace_back(slot, m_parser.LookupVariable(slot));
+		if (EvaluateStatements(NumericType::Int64))
+			return;
+		m_parser.UndefineVariables(initial.size());
+		for (const std::pair<size_t, double> &variable : initial)
+			m_parser.RecordVariable(variable.first, variable.second);
+		m_parser.ClearErrors();
+	}
+	EvaluateStatements(NumericType::Double);
+}
+
+bool
+NumericEngine::EvaluateStatements(NumericType selected)
+{
+	m_selected = selected;
+	if (m_selected == NumericType::Float)
+		m_float.LoadVariables();
+	else if (m_selected == NumericType::LongDouble)
+		m_longDouble.LoadVariables();
+	else if (m_selected == NumericType::Int64)
+		m_int64.LoadVariables();
+
+	for (size_t statement = 0; statement < m_parser.GetStatementCount(); ++statement)
+	{
+		if (!m_parser.CompileStatement(statement, m_compiled))
+			continue;
+
+		//the parser holds a double copy of every value, the evaluation continues from it
+		if (m_type == NumericType::Auto && m_selected == NumericType::Int64 && !IsIntegerPreserving(m_compiled))
+			m_selected = NumericType::Double;
+
+		switch (m_selected)
+		{
+		case NumericType::Float:
+			m_float.Evaluate(m_compiled);
+			break;
+		case NumericType::LongDouble:
+			m_longDouble.Evaluate(m_compiled);
+			break;
+		case NumericType::Int64:
+			Numeric<int64_t>::s_overflow = false;
+			m_int64.Evaluate(m_compiled);
+			if (Numeric<int64_t>::s_overflow)
+			{
+				if (m_type == NumericType::Auto)
+					return false;
+				//the value of the statement is not the exact one asked for
+				m_parser.ReportError(ErrorCode::Overflow, -1);
+			}
+			break;
+		default:
+			m_compiled.Evaluate<double>(m_parser, m_stack);
+			break;
+		}
+	}
+	return true;
+}
+
+void
+NumericEngine::PrintVariables() const
+{
+	switch (m_selected)
+	{
+	case NumericType::Float:
+		m_float.PrintVariables();
+		break;
+	case NumericType::LongDouble:
+		m_longDouble.PrintVariables();
+		break;
+	case NumericType::Int64:
+		m_int64.PrintVariables();
+		break;
+	default:
+		m_parser.PrintVariables();
+		break;
+	}
+}
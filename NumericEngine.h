@@ -0,0 +1,122 @@
+#pragma once
+#include "CompiledExpression.h"
+#include "Parser.h"
+
+#include <cstdint>
+#include <iostream>
+#include <string>
+#include <vector>
+
+/*
+	NumericType enumerates the value types a NumericEngine evaluates statements in
+	Auto runs in Int64 while the statements keep integers exact, then in Double. A script
+	overflowing in Int64 is run again from its start in Double, in Int64 the statement
+	reports ErrorCode::Overflow
+*/
+enum class NumericType
+{
+	Float,
+	Double,
+	LongDouble,
+	Int64,
+	Auto
+};
+
+//Type by its name: float, double, long-double, int64 or auto. False for an unknown name
+bool ParseNumericType(const std::string &name, NumericType &type);
+const char* GetNumericTypeName(NumericType type);
+
+//Whether the compiled code has the same result in Int64 as in Double: integer numbers,
+//+ - * % and ^ by a non negative integer number, and no function call
+bool IsIntegerPreserving(const CompiledExpression &compiled);
+
+/*
+	NumericEnvironment class holds the variables of a Parser in the value type T
+	Every assignment is also recorded in the parser as a double, so the parser keeps
+	defining variables, reading postfix functions and printing in the same order
+*/
+template <typename T>
+class NumericEnvironment
+{
+public:
+	explicit NumericEnvironment(Parser &parser)
+		: m_parser(parser)
+	{
+	}
+
+	T Evaluate(const CompiledExpression &compiled)
+	{
+		//slots are created by the parser while reading
+		if (m_values.size() < m_parser.GetSlotCount())
+			m_values.resize(m_parser.GetSlotCount(), T(0));
+		return compiled.Evaluate<T>(*this, m_stack);
+	}
+
+	//Take the values the parser holds, e.g. after statements were evaluated in double
+	void LoadVariables()
+	{
+		m_values.resize(m_parser.GetSlotCount());
+		for (size_t slot = 0; slot < m_values.size(); ++slot)
+			m_values[slot] = Numeric<T>::FromDouble(m_parser.LookupVariable(slot));
+	}
+
+	T LookupVariable(size_t slot) const { return m_values[slot]; }
+	void RecordVariable(size_t slot, T value)
+	{
+		m_values[slot] = value;
+		m_parser.RecordVariable(slot, Numeric<T>::ToDouble(value));
+	}
+	void ReportError(ErrorCode code, int position) { m_parser.ReportError(code, position); }
+
+	//Print variables to stdout in the format of Parser::PrintVariables
+	void PrintVariables() const
+	{
+		std::cout << "(";
+		bool first = true;
+		for (size_t slot : m_parser.GetVariableOrder())
+		{
+			if (first)
+				first = false;
+			else
+				std::cout << ",";
+			std::cout << m_parser.GetVariableName(slot) << "=" << m_values[slot];
+		}
+		std::cout << ")" << std::endl;
+	}
+
+private:
+	Parser &m_parser;
+	std::vector<T> m_values;
+	std::vector<T> m_stack;
+};
+
+/*
+	NumericEngine class evaluates the statements of a Parser in a NumericType
+	instead of the parser's own double evaluation
+*/
+class NumericEngine
+{
+public:
+	NumericEngine(Parser &parser, NumericType type);
+
+	void EvaluateStatements();
+
+	//Type the last statement was evaluated in, Int64 or Double for Auto
+	NumericType GetSelectedType() const { return m_selected; }
+
+	//Print variables to stdout in the selected type
+	void PrintVariables() const;
+
+private:
+	//Evaluate the statements from selected, false when Auto stopped on an Int64 overflow
+	bool EvaluateStatements(NumericType selected);
+
+	Parser &m_parser;
+	NumericType m_type;
+	NumericType m_selected;
+	CompiledExpression m_compiled;
+	std::vector<double> m_stack;
+	NumericEnvironment<float> m_float;
+	NumericEnvironment<long double> m_longDouble;
+	NumericEnvironment<int64_t> m_int64;
+};
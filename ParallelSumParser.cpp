@@ -0,0 +1,223 @@
+#include "ParallelSumParser.h"
+#include "CharacterScanner.h"
+#include "Parser.h"
+
+#include <algorithm>
+#include <atomic>
+#include <functional>
+#include <thread>
+
+//More chunks than threads, so a thread reading short operands takes over the others
+static const size_t s_chunksPerThread = 4;
+static const size_t s_noSlot = static_cast<size_t>(-1);
+
+//Call work with every index from 0 to threads, each on its own thread
+static void
+RunThreads(size_t threads, const std::function<void(size_t)> &work)
+{
+	if (threads == 1)
+	{
+		work(0);
+		return;
+	}
+	std::vector<std::thread> workers;
+	for (size_t t = 0; t < threads; ++t)
+		workers.emplace_back(work, t);
+	for (std::thread &worker : workers)
+		worker.join();
+}
+
+//Whether the '+' or '-' at position separates two operands of a Sum
+static bool
+IsSumOperator(const std::string &statement, size_t position)
+{
+	char previous = position ? statement[position - 1] : ' ';
+	char next = position + 1 < statement.size() ? statement[position + 1] : ' ';
+	if (previous == '+' || previous == '-' || next == '+' || next == '-' || next == '=')
+		return false;
+	if (previous != 'e' && previous != 'E')
+		return true;
+
+	//the sign of an exponent follows a number, which starts with a digit unlike a name
+	size_t start = position - 1;
+	while (start > 0 && (CharacterScanner::IsAlphanumeric(statement[start - 1]) || statement[start - 1] == '.'))
+		--start;
+	return !CharacterScanner::IsDigit(statement[start]) && statement[start] != '.';
+}
+
+ParallelSumParser::ParallelSumParser(size_t threads)
+	: m_threads(std::max<size_t>(1, threads))
+{
+}
+
+ParallelSumParser::~ParallelSumParser() = default;
+
+bool
+ParallelSumParser::FindOperators(const std::string &statement, size_t begin, size_t threads, std::vector<size_t> &operators)
+{
+	operators.clear();
+	threads = std::max<size_t>(1, std::min(threads, (statement.size() - std::min(begin, statement.size())) / 4096 + 1));
+	auto blockBegin = [&](size_t block) { return begin + (statement.size() - begin) * block / threads; };
+
+	//depth change of every block and its lowest depth relative to its start
+	std::vector<long> change(threads), lowest(threads);
+	RunThreads(threads, [&](size_t block) {
+		long depth = 0, low = 0;
+		for (size_t i = blockBegin(block), end = blockBegin(block + 1); i < end; ++i)
+		{
+			depth += statement[i] == '(' ? 1 : statement[i] == ')' ? -1 : 0;
+			low = std::min(low, depth);
+		}
+		change[block] = depth;
+		lowest[block] = low;
+	});
+
+	//depth at the start of every block
+	std::vector<long> start(threads);
+	long depth = 0;
+	for (size_t block = 0; block < threads; ++block)
+	{
+		start[block] = depth;
+		if (depth + lowest[block] < 0)
+			return false;
+		depth += change[block];
+	}
+	if (depth)
+		return false;
+
+	std::vector<std::vector<size_t>> found(threads);
+	RunThreads(threads, [&](size_t block) {
+		long depth = start[block];
+		for (size_t i = blockBegin(block), end = blockBegin(block + 1); i < end; ++i)
+		{
+			char c = statement[i];
+			if (c == '(')
+				++depth;
+			else if (c == ')')
+				--depth;
+			else if ((c == '+' || c == '-') && !depth && IsSumOperator(statement, i))
+				found[block].push_back(i);
+		}
+	});
+	for (const std::vector<size_t> &block : found)
+		operators.insert(operators.end(), block.begin(), block.end());
+	return true;
+}
+
+bool
+ParallelSumParser::Compile(const std::string &statement, Parser &parser, CompiledExpression &compiled)
+{
+	//Assignment -> Variable '=' Sum, Calculation -> Sum
+	const char *text = statement.data();
+	size_t length = statement.size();
+	size_t begin = CharacterScanner::SkipSpaces(text, 0, length);
+	std::string target;
+	if (begin < length && CharacterScanner::IsAlpha(text[begin]))
+	{
+		size_t nameEnd = CharacterScanner::SkipAlphanumerics(text, begin, length);
+		size_t equal = CharacterScanner::SkipSpaces(text, nameEnd, length);
+		if (equal < length && text[equal] == '=' && (equal + 1 == length || text[equal + 1] != '='))
+		{
+			target.assign(text + begin, nameEnd - begin);
+			begin = equal + 1;
+		}
+	}
+	if (!FindOperators(statement, begin, m_threads, m_operators) || m_operators.empty())
+		return false;
+
+	m_operands.assign(1, begin);
+	for (size_t position : m_operators)
+		m_operands.push_back(position + 1);
+	size_t chunks = std::min(m_operands.size(), m_threads * s_chunksPerThread);
+	m_chunks.resize(chunks);
+	for (size_t c = 0; c < chunks; ++c)
+	{
+		m_chunks[c].m_first = m_operands.size() * c / chunks;
+		m_chunks[c].m_end = m_operands.size() * (c + 1) / chunks;
+	}
+
+	while (m_workers.size() < m_threads)
+		m_workers.emplace_back(new Parser());
+	std::atomic<size_t> next(0);
+	std::atomic<bool> failed(false);
+	RunThreads(m_threads, [&](size_t thread) {
+		Parser &worker = *m_workers[thread];
+		worker.ShareDefinitions(parser);
+		worker.m_tokenizer.SetStatement(statement);
+		for (size_t chunk = next++; chunk < chunks && !failed; chunk = next++)
+		{
+			m_chunks[chunk].m_worker = thread;
+			if (!ReadChunk(statement, worker, m_chunks[chunk]))
+				failed = true;
+		}
+		//the statement is not kept by the worker until the next one
+		worker.m_tokenizer.SetStatement(std::string());
+	});
+	if (failed)
+		return false;
+
+	//slots of the workers by statement order of the variables, as the parser reads them
+	size_t shared = parser.GetSlotCount();
+	size_t targetSlot = target.empty() ? 0 : parser.GetVariableSlot(target);
+	std::vector<std::vector<size_t>> slots(m_threads);
+	for (size_t thread = 0; thread < m_threads; ++thread)
+	{
+		Parser &worker = *m_workers[thread];
+		slots[thread].assign(worker.GetSlotCount(), s_noSlot);
+		for (size_t slot = 0; slot < std::min(shared, worker.GetSlotCount()); ++slot)
+			slots[thread][slot] = slot;
+		parser.m_requiredVariables.insert(parser.m_requiredVariables.end(), worker.m_requiredVariables.begin(), worker.m_requiredVariables.end());
+		parser.m_undefinedVariables.insert(parser.m_undefinedVariables.end(), worker.m_undefinedVariables.begin(), worker.m_undefinedVariables.end());
+	}
+
+	compiled.Clear();
+	for (size_t c = 0; c < chunks; ++c)
+	{
+		Chunk &chunk = m_chunks[c];
+		Parser &worker = *m_workers[chunk.m_worker];
+		std::vector<size_t> &workerSlots = slots[chunk.m_worker];
+		for (const CompiledExpression *code : {&chunk.m_head, &chunk.m_tail})
+			for (const Instruction &instruction : code->GetCode())
+			{
+				bool slotted = instruction.m_op == OpCode::Variable || instruction.m_op == OpCode::Assign ||
+					instruction.m_op == OpCode::Increment || instruction.m_op == OpCode::PostIncrement ||
+					instruction.m_op == OpCode::LoopBegin || instruction.m_op == OpCode::LoopEnd;
+				if (slotted && workerSlots[instruction.m_index] == s_noSlot)
+					workerSlots[instruction.m_index] = parser.GetVariableSlot(worker.GetVariableName(instruction.m_index));
+			}
+
+		compiled.Append(chunk.m_head, workerSlots);
+		if (c)
+			compiled.AddOperation(text[m_operators[chunk.m_first - 1]] == '-' ? OpCode::Substract : OpCode::Add);
+		compiled.Append(chunk.m_tail, workerSlots);
+	}
+	if (!target.empty())
+		compiled.AddAssign(targetSlot);
+	return true;
+}
+
+bool
+ParallelSumParser::ReadChunk(const std::string &statement, Parser &worker, Chunk &chunk) const
+{
+	chunk.m_head.Clear();
+	chunk.m_tail.Clear();
+	Tokenizer &tokenizer = worker.m_tokenizer;
+	for (size_t operand = chunk.m_first; operand < chunk.m_end; ++operand)
+	{
+		//the operand must end right before the next operator, as when the Sum is read at once
+		tokenizer.SetCurrenPosition(static_cast<int>(m_operands[operand]));
+		ExpressionPtr product = worker.EvaluateProduct();
+		bool last = operand + 1 == m_operands.size();
+		if (!product || (last ? !tokenizer.ReachedEnd() : tokenizer.GetCurrentPosition() != static_cast<int>(m_operators[operand])))
+			return false;
+
+		if (operand == chunk.m_first)
+			product->Compile(chunk.m_head);
+		else
+		{
+			product->Compile(chunk.m_tail);
+			chunk.m_tail.AddOperation(statement[m_operators[operand - 1]] == '-' ? OpCode::Substract : OpCode::Add);
+		}
+	}
+	return true;
+}
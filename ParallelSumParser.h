@@ -0,0 +1,61 @@
+#pragma once
+#include "CompiledExpression.h"
+
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <vector>
+
+class Parser;
+
+/*
+	ParallelSumParser class reads a very long statement on several threads, e.g. a generated sum
+	of thousands of products. It only reads an Assignment or a Calculation, whose Sum is split
+	at its top-level '+' and '-': the depth of parentheses of every character is found with a
+	prefix scan over blocks of the statement, one per thread.
+
+	The operands are then read in chunks by worker parsers, each holding the variables and user
+	functions of the parser, and the chunks appended by statement order. The compiled code is
+	the one the parser compiles on its own, so the sum stays left-associative and gives the
+	same value. A statement the split cannot read, e.g. one with a syntax error, a loop or a
+	definition, is left to the parser
+*/
+class ParallelSumParser
+{
+public:
+	explicit ParallelSumParser(size_t threads);
+	~ParallelSumParser();
+
+	//Compile statement for parser, false if it is not a sum the split can read
+	bool Compile(const std::string &statement, Parser &parser, CompiledExpression &compiled);
+
+	//Positions of the '+' and '-' of statement from begin outside of any parentheses, leaving out
+	//those of ++, --, += and of the exponent of a number. False if the parentheses are unbalanced
+	static bool FindOperators(const std::string &statement, size_t begin, size_t threads, std::vector<size_t> &operators);
+
+	size_t GetThreads() const { return m_threads; }
+
+private:
+	/*
+		Chunk utility class to hold consecutive operands compiled by a worker:
+		the first one, then every next one followed by its operator
+	*/
+	struct Chunk
+	{
+		size_t m_first = 0;
+		size_t m_end = 0;
+		size_t m_worker = 0;
+		CompiledExpression m_head;
+		CompiledExpression m_tail;
+	};
+
+	//Read the operands of chunk with the worker, false on a syntax error
+	bool ReadChunk(const std::string &statement, Parser &worker, Chunk &chunk) const;
+
+	size_t m_threads;
+	std::vector<std::unique_ptr<Parser>> m_workers;
+	//Operators of the statement being read, then the start of every operand
+	std::vector<size_t> m_operators;
+	std::vector<size_t> m_operands;
+	std::vector<Chunk> m_chunks;
+};
@@ -0,0 +1,91 @@
+#include "ParseCache.h"
+#include "Parser.h"
+
+ParseCache::ParseCache(size_t maxEntries, size_t maxBytes)
+	: m_maxEntries(maxEntries)
+	, m_maxBytes(maxBytes)
+{
+
+}
+
+bool
+ParseCache::Lookup(const std::string &statement, const Parser &parser, CompiledExpression &compiled)
+{
+	if (!m_maxEntries)
+		return false;
+	auto find = m_index.find(statement);
+	bool found = find != m_index.end();
+	for (size_t i = 0; found && i < find->second->m_required.size(); ++i)
+		found = parser.IsVariableDefined(find->second->m_required[i]);
+	for (size_t i = 0; found && i < find->second->m_undefined.size(); ++i)
+		found = !parser.HasVariable(find->second->m_undefined[i]);
+	if (!found)
+	{
+		++m_misses;
+		return false;
+	}
+
+	m_entries.splice(m_entries.begin(), m_entries, find->second);
+	//the assignment reuses the capacity of compiled
+	compiled = find->second->m_compiled;
+	++m_hits;
+	return true;
+}
+
+void
+ParseCache::Store(const std::string &statement, const std::vector<size_t> &required, const std::vector<std::string> &undefined,
+	const CompiledExpression &compiled)
+{
+	//a definition compiles to nothing, it must be read to define its function
+	if (!m_maxEntries || compiled.Empty())
+		return;
+
+	size_t bytes = sizeof(Entry) + statement.size() + required.size() * sizeof(size_t) +
+		undefined.size() * sizeof(std::string) +
+		compiled.GetCode().size() * sizeof(Instruction) +
+		(compiled.GetFunctions().size() + compiled.GetBinaryFunctions().size()) * sizeof(void*);
+	if (bytes > m_maxBytes)
+		return;
+
+	auto find = m_index.find(statement);
+	if (find != m_index.end())
+	{
+		//read again while a variable it required was undefined, or one it needed undefined was defined
+		m_bytes -= find->second->m_bytes;
+		m_entries.erase(find->second);
+		m_index.erase(find);
+	}
+
+	m_entries.push_front(Entry{statement, compiled, required, undefined, bytes});
+	m_index.emplace(m_entries.front().m_statement, m_entries.begin());
+	m_bytes += bytes;
+	Evict();
+}
+
+void
+ParseCache::SetLimits(size_t maxEntries, size_t maxBytes)
+{
+	m_maxEntries = maxEntries;
+	m_maxBytes = maxBytes;
+	Evict();
+}
+
+void
+ParseCache::Clear()
+{
+	m_index.clear();
+	m_entries.clear();
+	m_bytes = 0;
+}
+
+void
+ParseCache::Evict()
+{
+	while (!m_entries.empty() && (m_entries.size() > m_maxEntries || m_bytes > m_maxBytes))
+	{
+		m_index.erase(m_entries.back().m_statement);
+		m_bytes -= m_entries.back().m_bytes;
+		m_entries.pop_back();
+		++m_evictions;
+	}
+}
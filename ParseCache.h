@@ -0,0 +1,72 @@
+#pragma once
+#include "CompiledExpression.h"
+
+#include <cstddef>
+#include <list>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+class Parser;
+
+/*
+	ParseCache class keeps the compiled form of the statements a Parser read by their text,
+	so a statement repeated in a script is tokenized and parsed only once.
+	The least recently used entries are evicted past a number of entries or of bytes.
+
+	Entries hold slots and function pointers of their parser and are only valid for it:
+	the parser clears its cache when it is reset or a user function is defined.
+	A statement which was only valid with some variables defined, e.g. i++, is found only
+	while they are defined, and one read while some were undefined, e.g. x+++y read as
+	x + ++y, only while they are still undefined.
+*/
+class ParseCache
+{
+public:
+	ParseCache(size_t maxEntries = 1024, size_t maxBytes = 1024 * 1024);
+
+	//Fill compiled with the entry of statement, false on a miss
+	bool Lookup(const std::string &statement, const Parser &parser, CompiledExpression &compiled);
+	//Store what was compiled for statement, required being the slots it needs defined and
+	//undefined the names it needs undefined
+	void Store(const std::string &statement, const std::vector<size_t> &required, const std::vector<std::string> &undefined,
+		const CompiledExpression &compiled);
+
+	//0 entries disables the cache, the entries past the new limits are evicted
+	void SetLimits(size_t maxEntries, size_t maxBytes);
+	void Clear();
+
+	size_t GetEntries() const { return m_entries.size(); }
+	size_t GetBytes() const { return m_bytes; }
+	size_t GetHits() const { return m_hits; }
+	size_t GetMisses() const { return m_misses; }
+	size_t GetEvictions() const { return m_evictions; }
+	double GetHitRate() const { return m_hits + m_misses ? static_cast<double>(m_hits) / (m_hits + m_misses) : 0; }
+
+private:
+	/*
+		Entry utility class to hold a compiled statement with the size it is accounted for
+	*/
+	struct Entry
+	{
+		std::string m_statement;
+		CompiledExpression m_compiled;
+		std::vector<size_t> m_required;
+		std::vector<std::string> m_undefined;
+		size_t m_bytes;
+	};
+
+	void Evict();
+
+	size_t m_maxEntries;
+	size_t m_maxBytes;
+	//Most recently used first
+	std::list<Entry> m_entries;
+	//Entries by their text, the views point to m_statement of the entries
+	std::unordered_map<std::string_view, std::list<Entry>::iterator> m_index;
+	size_t m_bytes = 0;
+	size_t m_hits = 0;
+	size_t m_misses = 0;
+	size_t m_evictions = 0;
+};
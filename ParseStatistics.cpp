@@ -0,0 +1,111 @@
+#include "ParseStatistics.h"
+
+#include <iomanip>
+
+void
+ParseStatistics::Add(const ParseStatistics &other)
+{
+	for (size_t i = 0; i < static_cast<size_t>(GrammarRule::Count); ++i)
+	{
+		m_rules[i].m_calls += other.m_rules[i].m_calls;
+		m_rules[i].m_rewinds += other.m_rules[i].m_rewinds;
+		m_rules[i].m_rescannedCharacters += other.m_rules[i].m_rescannedCharacters;
+		m_rules[i].m_nanoseconds += other.m_rules[i].m_nanoseconds;
+	}
+}
+
+size_t
+ParseStatistics::GetTotalRewinds() const
+{
+	size_t rewinds(0);
+	for (const RuleCounters &rule : m_rules)
+		rewinds += rule.m_rewinds;
+	return rewinds;
+}
+
+size_t
+ParseStatistics::GetTotalRescannedCharacters() const
+{
+	size_t characters(0);
+	for (const RuleCounters &rule : m_rules)
+		characters += rule.m_rescannedCharacters;
+	return characters;
+}
+
+void
+ParseStatistics::CountRewind(int from, int to)
+{
+	if (from <= to || m_current == GrammarRule::Count)
+		return;
+	RuleCounters &rule = m_rules[static_cast<size_t>(m_current)];
+	++rule.m_rewinds;
+	rule.m_rescannedCharacters += from - to;
+}
+
+void
+ParseStatistics::Print(std::ostream &out) const
+{
+	std::streamsize precision = out.precision();
+	out << std::left << std::setw(16) << "rule" << std::right 
+		<< std::setw(12) << "calls" << std::setw(12) << "rewinds" 
+		<< std::setw(12) << "rescanned" << std::setw(14) << "time(us)" << std::endl;
+	for (size_t i = 0; i < static_cast<size_t>(GrammarRule::Count); ++i)
+	{
+		const RuleCounters &rule = m_rules[i];
+		if (rule.m_calls == 0)
+			continue;
+		out << std::left << std::setw(16) << GetRuleName(static_cast<GrammarRule>(i)) << std::right
+			<< std::setw(12) << rule.m_calls << std::setw(12) << rule.m_rewinds 
+			<< std::setw(12) << rule.m_rescannedCharacters 
+			<< std::setw(14) << std::fixed << std::setprecision(1) << rule.m_nanoseconds / 1000.0 << std::endl;
+	}
+	out << std::defaultfloat << std::setprecision(precision);
+}
+
+const char*
+ParseStatistics::GetRuleName(GrammarRule rule)
+{
+	switch (rule)
+	{
+	case GrammarRule::Definition:		return "Definition";
+	case GrammarRule::Loop:				return "Loop";
+	case GrammarRule::Assignment:		return "Assignment";
+	case GrammarRule::Calculation:		return "Calculation";
+	case GrammarRule::Sum:				return "Sum";
+	case GrammarRule::Product:			return "Product";
+	case GrammarRule::Power:			return "Power";
+	case GrammarRule::Term:				return "Term";
+	case GrammarRule::Group:			return "Group";
+	case GrammarRule::Function:			return "Function";
+	case GrammarRule::Number:			return "Number";
+	case GrammarRule::Variable:			return "Variable";
+	case GrammarRule::PrefixFunction:	return "PrefixFunction";
+	case GrammarRule::PostfixFunction:	return "PostfixFunction";
+	case GrammarRule::Character:		return "Character";
+	case GrammarRule::Characters:		return "Characters";
+	case GrammarRule::Count:			break;
+	}
+	return "Unknown";
+}
+
+RuleScope::RuleScope(ParseStatistics *statistics, GrammarRule rule)
+	: m_statistics(statistics)
+	, m_rule(rule)
+	, m_parent(GrammarRule::Count)
+{
+	if (!m_statistics)
+		return;
+	m_parent = m_statistics->m_current;
+	m_statistics->m_current = rule;
+	++m_statistics->m_rules[static_cast<size_t>(rule)].m_calls;
+	m_start = std::chrono::steady_clock::now();
+}
+
+RuleScope::~RuleScope()
+{
+	if (!m_statistics)
+		return;
+	m_statistics->m_rules[static_cast<size_t>(m_rule)].m_nanoseconds += 
+		std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - m_start).count();
+	m_statistics->m_current = m_parent;
+}
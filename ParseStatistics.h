@@ -0,0 +1,98 @@
+#pragma once
+#include <chrono>
+#include <cstddef>
+#include <ostream>
+
+/*
+	Grammar rules and tokenizer primitives counted by ParseStatistics
+*/
+enum class GrammarRule
+{
+	Definition,
+	Loop,
+	Assignment,
+	Calculation,
+	Sum,
+	Product,
+	Power,
+	Term,
+	Group,
+	Function,
+	Number,
+	Variable,
+	PrefixFunction,
+	PostfixFunction,
+	Character,
+	Characters,
+	Count
+};
+
+/*
+	ParseStatistics class holds per-rule counters of the parser:
+	calls, rewinds of the tokenizer done while the rule was the innermost active one,
+	characters that will be read again because of those rewinds and the time spent in the rule
+	(including nested rules).
+
+	Counting is only compiled in when PARSER_INSTRUMENTATION is defined,
+	otherwise the counters stay zero and the hooks cost nothing.
+*/
+class ParseStatistics
+{
+public:
+	struct RuleCounters
+	{
+		size_t m_calls = 0;
+		size_t m_rewinds = 0;
+		size_t m_rescannedCharacters = 0;
+		double m_nanoseconds = 0;
+	};
+
+#ifdef PARSER_INSTRUMENTATION
+	static constexpr bool Enabled = true;
+#else
+	static constexpr bool Enabled = false;
+#endif
+
+	void Reset() { *this = ParseStatistics(); }
+	void Add(const ParseStatistics &other);
+
+	const RuleCounters& GetRule(GrammarRule rule) const { return m_rules[static_cast<size_t>(rule)]; }
+	size_t GetTotalRewinds() const;
+	size_t GetTotalRescannedCharacters() const;
+
+	//Called by the tokenizer when the read position is set back
+	void CountRewind(int from, int to);
+
+	//Print a table of the rules with at least one call
+	void Print(std::ostream &out) const;
+
+	static const char* GetRuleName(GrammarRule rule);
+
+private:
+	friend class RuleScope;
+	RuleCounters m_rules[static_cast<size_t>(GrammarRule::Count)];
+	GrammarRule m_current = GrammarRule::Count;
+};
+
+/*
+	RuleScope class counts a call of a rule and its time for the lifetime of the scope
+*/
+class RuleScope
+{
+public:
+	RuleScope(ParseStatistics *statistics, GrammarRule rule);
+	~RuleScope();
+private:
+	ParseStatistics *m_statistics;
+	GrammarRule m_rule;
+	GrammarRule m_parent;
+	std::chrono::steady_clock::time_point m_start;
+};
+
+#ifdef PARSER_INSTRUMENTATION
+#define PARSER_RULE_SCOPE(statistics, rule) RuleScope ruleScope(statistics, rule)
+#define PARSER_COUNT_REWIND(statistics, from, to) if (statistics) (statistics)->CountRewind(from, to)
+#else
+#define PARSER_RULE_SCOPE(statistics, rule)
+#define PARSER_COUNT_REWIND(statistics, from, to)
+#endif
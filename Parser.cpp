@@ -1,79 +1,434 @@
 #include "Parser.h"
 #include "Expression.h"
 #include "Tokenizer.h"
-
+#include "AllocationCounter.h"
+#include "CompiledCache.h"
+#include "FunctionCache.h"
+#include "Liveness.h"
+#include "ParallelSumParser.h"
+#include "VersionedEnvironment.h"
+
+#include <algorithm>
+#include <chrono>
 #include <cmath>
 #include <iostream>
 
 Parser::Parser()
+	: m_funcs(GetFunctionsMap())
+	, m_binaryFuncs(GetBinaryFunctionsMap())
 {
 	m_tokenizer.SetParser(this);
-	BuildFunctionsMap();
+	m_tokenizer.SetStatistics(&m_parseStatistics);
+	m_syntaxChecker.SetParser(this);
 }
 
+Parser::~Parser() = default;
+
 void
 Parser::AddStatement(std::string statement)
 {
 	m_statements.emplace_back(std::move(statement));
 }
 
+void
+Parser::Reset()
+{
+	m_statements.clear();
+	m_vars.clear();
+	m_varIndex.clear();
+	m_varOrder.clear();
+	m_varsByLength.clear();
+	m_userFuncs.clear();
+	m_parseCache.Clear();
+	m_errors.clear();
+	m_profiler.Clear();
+	m_statementStatistics.clear();
+}
+
 void
 Parser::EvaluateStatements()
 {
-	for (const std::string &statement : m_statements)
+	m_errors.clear();
+	m_profiler.Clear();
+	m_statementStatistics.clear();
+	m_eliminated = 0;
+	if (!m_observed.empty())
 	{
-		m_tokenizer.SetStatement(statement); 
-		ExpressionPtr exp = this->EvaluateStatement();
-		if (exp)
+		EvaluateObservedStatements();
+		return;
+	}
+	if (ParseStatistics::Enabled)
+		m_statementStatistics.resize(m_statements.size());
+
+	for (m_currentStatement = 0; m_currentStatement < m_statements.size(); ++m_currentStatement)
+	{
+		if (ParseStatistics::Enabled)
+			m_tokenizer.SetStatistics(&m_statementStatistics[m_currentStatement]);
+
+		if (m_profiling)
 		{
-			exp->Evaluate();
+			EvaluateProfiledStatement();
 		}
 		else
 		{
-			std::cout << "Parser: Could not evaluate the statement: " << statement << std::endl;
+			if (CompileStatement(m_currentStatement, m_compiled))
+				m_compiled.Evaluate(this, m_stack);
 		}
+
+		if (ParseStatistics::Enabled)
+			m_parseStatistics.Add(m_statementStatistics[m_currentStatement]);
 	}
+	m_tokenizer.SetStatistics(&m_parseStatistics);
 }
 
 void
-Parser::BuildFunctionsMap()
+Parser::EvaluateObservedStatements()
+{
+	//the statements are read before any runs, a variable is defined as the reading gets to it.
+	//Whether a loop which may run zero times defines one is only known by running up to it,
+	//which is done aside
+	std::vector<CompiledExpression> compiled(m_statements.size());
+	VersionedEnvironment reading(*this);
+	size_t read = 0;
+	for (size_t statement = 0; statement < m_statements.size(); ++statement)
+		if (CompileStatement(statement, compiled[statement]))
+			DefineReachedVariables(compiled, statement, reading, read);
+
+	std::vector<size_t> observed;
+	for (const std::string &var : m_observed)
+		observed.push_back(GetVariableSlot(var));
+	std::vector<char> live = FindLiveStatements(compiled, observed, m_vars.size());
+
+	for (m_currentStatement = 0; m_currentStatement < m_statements.size(); ++m_currentStatement)
+	{
+		if (live[m_currentStatement])
+			compiled[m_currentStatement].Evaluate(this, m_stack);
+		else if (!compiled[m_currentStatement].Empty())
+			++m_eliminated;
+	}
+}
+
+void
+Parser::EvaluateProfiledStatement()
+{
+	using Clock = std::chrono::steady_clock;
+	StatementProfiler::StatementProfile profile;
+	size_t allocations = AllocationCounter::GetAllocations();
+	size_t expressions = Expression::GetCreatedCount();
+
+	Clock::time_point begin = Clock::now();
+	bool compiled = CompileStatement(m_currentStatement, m_compiled);
+	Clock::time_point parsed = Clock::now();
+	if (compiled)
+		m_compiled.Evaluate(this, m_stack);
+	Clock::time_point evaluated = Clock::now();
+
+	profile.m_parseNanoseconds = std::chrono::duration_cast<std::chrono::nanoseconds>(parsed - begin).count();
+	profile.m_evaluateNanoseconds = std::chrono::duration_cast<std::chrono::nanoseconds>(evaluated - parsed).count();
+	profile.m_allocations = AllocationCounter::GetAllocations() - allocations;
+	profile.m_expressions = Expression::GetCreatedCount() - expressions;
+	m_profiler.Record(profile);
+}
+
+bool
+Parser::CompileStatement(size_t statement, CompiledExpression &compiled)
+{
+	m_currentStatement = statement;
+	const std::string &text = m_statements[statement];
+	if (m_parseCache.Lookup(text, *this, compiled))
+		return true;
+	if (m_compiledCache && m_compiledCache->Lookup(text, *this, compiled))
+		return true;
+
+	m_requiredVariables.clear();
+	m_undefinedVariables.clear();
+	if (m_syntaxCheck && !m_syntaxChecker.Check(text))
+	{
+		compiled.Clear();
+		ReportError(ErrorCode::SyntaxError, static_cast<int>(m_syntaxChecker.GetPosition()), m_syntaxChecker.GetExpected());
+		return false;
+	}
+	//a statement the split cannot read is read again from its start, reporting its error
+	if (!m_parallelSum || text.size() < m_parallelBytes || !m_parallelSum->Compile(text, *this, compiled))
+	{
+		m_tokenizer.SetStatement(text);
+		ExpressionPtr exp = this->EvaluateStatement();
+		compiled.Clear();
+		if (!exp)
+		{
+			ReportError(ErrorCode::SyntaxError, m_tokenizer.GetCurrentPosition());
+			return false;
+		}
+		exp->Compile(compiled);
+	}
+	m_parseCache.Store(text, m_requiredVariables, m_undefinedVariables, compiled);
+	if (m_compiledCache)
+		m_compiledCache->Store(text, *this, compiled);
+	return true;
+}
+
+void
+Parser::ReportError(ErrorCode code, int position, uint32_t expected)
+{
+	//only the first error of a statement is kept
+	if (!m_errors.empty() && m_errors.back().m_statement == m_currentStatement)
+		return;
+	m_errors.push_back(StatementError(code, m_currentStatement, position, expected));
+}
+
+static const char*
+ErrorCodeToString(ErrorCode code)
+{
+	switch (code)
+	{
+	case ErrorCode::None:				return "No error";
+	case ErrorCode::SyntaxError:		return "Could not evaluate the statement";
+	case ErrorCode::InvalidExpression:	return "Could not evaluate expression";
+	case ErrorCode::DivisionByZero:		return "Attempt to divide by zero";
+	case ErrorCode::ModulusByZero:		return "Attempt to apply modulu by zero";
+	case ErrorCode::Overflow:			return "Integer overflow";
+	}
+	return "Unknown error";
+}
+
+void
+Parser::PrintErrors() const
+{
+	PrintErrors(std::cout);
+}
+
+void
+Parser::PrintErrors(std::ostream &out) const
+{
+	for (const auto &error : m_errors)
+	{
+		out << "Parser: " << ErrorCodeToString(error.m_code) << ": " << m_statements[error.m_statement];
+		if (error.m_position >= 0)
+		{
+			out << " (position " << error.m_position;
+			if (error.m_expected)
+				out << ", expected " << SyntaxChecker::DescribeExpected(error.m_expected);
+			out << ")";
+		}
+		out << std::endl;
+	}
+}
+
+const Parser::FunctionsMap&
+Parser::GetFunctionsMap()
 {
 	typedef double (*DoubleFuncPtr)(double);
-	m_funcs.insert(std::make_pair("sin", static_cast<DoubleFuncPtr>(std::sin)));
-	m_funcs.insert(std::make_pair("asin", static_cast<DoubleFuncPtr>(std::asin)));
-	m_funcs.insert(std::make_pair("cos", static_cast<DoubleFuncPtr>(std::cos)));
-	m_funcs.insert(std::make_pair("acos", static_cast<DoubleFuncPtr>(std::acos)));
-	m_funcs.insert(std::make_pair("tan", static_cast<DoubleFuncPtr>(std::tan)));
-	m_funcs.insert(std::make_pair("atan", static_cast<DoubleFuncPtr>(std::atan)));
-	m_funcs.insert(std::make_pair("ceil", static_cast<DoubleFuncPtr>(std::ceil)));
-	m_funcs.insert(std::make_pair("floor", static_cast<DoubleFuncPtr>(std::floor)));
+	static const FunctionsMap funcs {
+		{"sin", static_cast<DoubleFuncPtr>(std::sin)},
+		{"asin", static_cast<DoubleFuncPtr>(std::asin)},
+		{"cos", static_cast<DoubleFuncPtr>(std::cos)},
+		{"acos", static_cast<DoubleFuncPtr>(std::acos)},
+		{"tan", static_cast<DoubleFuncPtr>(std::tan)},
+		{"atan", static_cast<DoubleFuncPtr>(std::atan)},
+		{"ceil", static_cast<DoubleFuncPtr>(std::ceil)},
+		{"floor", static_cast<DoubleFuncPtr>(std::floor)}
+	};
+	return funcs;
+}
+
+const Parser::BinaryFunctionsMap&
+Parser::GetBinaryFunctionsMap()
+{
+	typedef double (*BinaryDoubleFuncPtr)(double, double);
+	static const BinaryFunctionsMap binaryFuncs {
+		{"min", static_cast<BinaryDoubleFuncPtr>(std::fmin)},
+		{"max", static_cast<BinaryDoubleFuncPtr>(std::fmax)},
+		{"atan2", static_cast<BinaryDoubleFuncPtr>(std::atan2)},
+		{"pow", static_cast<BinaryDoubleFuncPtr>(std::pow)}
+	};
+	return binaryFuncs;
 }
 
 double 
 Parser::LookupVariable(const std::string& var) const
 {
 	double variableValue(0);
-	for (const auto &varEntry : m_vars)
-		if (varEntry.m_name == var)
+	auto find = m_varIndex.find(var);
+	if (find != m_varIndex.end())
+		variableValue = m_vars[find->second].m_value;
+	return variableValue;
+}
+
+bool
+Parser::HasVariable(const std::string& var) const
+{
+	auto find = m_varIndex.find(var);
+	return find != m_varIndex.end() && m_vars[find->second].m_defined;
+}
+
+bool
+Parser::RequireVariable(const std::string& var)
+{
+	auto find = m_varIndex.find(var);
+	//assigned by a loop being read before this point of its body
+	if (find != m_varIndex.end() && std::find(m_loopVariables.begin(), m_loopVariables.end(), find->second) != m_loopVariables.end())
+		return true;
+	if (find == m_varIndex.end() || !m_vars[find->second].m_defined)
+	{
+		//the statement may be read another way once var is defined, e.g. x+++y
+		if (std::find(m_undefinedVariables.begin(), m_undefinedVariables.end(), var) == m_undefinedVariables.end())
+			m_undefinedVariables.push_back(var);
+		return false;
+	}
+	if (std::find(m_requiredVariables.begin(), m_requiredVariables.end(), find->second) == m_requiredVariables.end())
+		m_requiredVariables.push_back(find->second);
+	return true;
+}
+
+std::string
+Parser::GetFunctionName(const CompiledExpression::Function *function) const
+{
+	for (const auto &func : m_funcs)
+		if (&func.second == function)
+			return func.first;
+	return std::string();
+}
+
+std::string
+Parser::GetFunctionName(const CompiledExpression::BinaryFunction *function) const
+{
+	for (const auto &func : m_binaryFuncs)
+		if (&func.second == function)
+			return func.first;
+	return std::string();
+}
+
+uint64_t
+Parser::GetFunctionTableVersion()
+{
+	//FNV-1a of the built-in names, a change of the maps invalidates compiled code saved before
+	uint64_t hash = 14695981039346656037ull;
+	auto mix = [&hash](const std::string &text) {
+		for (unsigned char c : text + ";")
 		{
-			variableValue = varEntry.m_value;
-			break;
+			hash ^= c;
+			hash *= 1099511628211ull;
 		}
-	return variableValue;
+	};
+	for (const auto &func : GetFunctionsMap())
+		mix(func.first);
+	mix("/");
+	for (const auto &func : GetBinaryFunctionsMap())
+		mix(func.first);
+	return hash;
+}
+
+void
+Parser::DefineAssignedVariables(const CompiledExpression &compiled)
+{
+	for (const Instruction &instruction : compiled.GetCode())
+		if (instruction.m_op == OpCode::Assign || instruction.m_op == OpCode::LoopBegin)
+			RecordVariable(instruction.m_index, LookupVariable(instruction.m_index));
+}
+
+void
+Parser::DefineReachedVariables(const std::vector<CompiledExpression> &compiled, size_t statement,
+	VersionedEnvironment &reading, size_t &read)
+{
+	std::vector<size_t> conditional = FindConditionalAssignments(compiled[statement]);
+	if (std::all_of(conditional.begin(), conditional.end(), [this](size_t slot) { return IsVariableDefined(slot); }))
+	{
+		DefineAssignedVariables(compiled[statement]);
+		return;
+	}
+
+	reading.Reserve(m_vars.size());
+	reading.Run(std::vector<CompiledExpression>(compiled.begin() + read, compiled.begin() + statement + 1));
+	read = statement + 1;
+	for (size_t slot : reading.GetVariableOrder())
+		if (!IsVariableDefined(slot))
+			RecordVariable(slot, LookupVariable(slot));
+}
+
+void
+Parser::UndefineVariables(size_t count)
+{
+	//the last variables defined are the last of their length
+	for (size_t order = m_varOrder.size(); order > count; --order)
+	{
+		VarEntry &varEntry = m_vars[m_varOrder[order - 1]];
+		varEntry.m_defined = false;
+		m_varsByLength[varEntry.m_name.size()].pop_back();
+	}
+	if (count < m_varOrder.size())
+		m_varOrder.resize(count);
+}
+
+bool
+Parser::FindVariable(const std::string& var, size_t &slot) const
+{
+	auto find = m_varIndex.find(var);
+	if (find == m_varIndex.end())
+		return false;
+	slot = find->second;
+	return true;
+}
+
+size_t
+Parser::GetVariableSlot(const std::string& var)
+{
+	auto find = m_varIndex.find(var);
+	if (find != m_varIndex.end())
+		return find->second;
+
+	m_varIndex.emplace(var, m_vars.size());
+	m_vars.push_back(VarEntry(var, 0, false));
+	return m_vars.size() - 1;
+}
+
+void
+Parser::SetParseThreads(size_t threads, size_t minBytes)
+{
+	m_parallelBytes = minBytes;
+	if (threads <= 1)
+		m_parallelSum.reset();
+	else if (!m_parallelSum || m_parallelSum->GetThreads() != threads)
+		m_parallelSum.reset(new ParallelSumParser(threads));
+}
+
+size_t
+Parser::GetParseThreads() const
+{
+	return m_parallelSum ? m_parallelSum->GetThreads() : 1;
+}
+
+void
+Parser::ShareDefinitions(const Parser &other)
+{
+	m_vars = other.m_vars;
+	m_varIndex = other.m_varIndex;
+	m_varOrder = other.m_varOrder;
+	m_varsByLength = other.m_varsByLength;
+	m_userFuncs = other.m_userFuncs;
+	m_requiredVariables.clear();
+	m_undefinedVariables.clear();
+}
+
+void
+Parser::DefineVariable(size_t slot)
+{
+	m_vars[slot].m_defined = true;
+	m_varOrder.push_back(slot);
+	size_t length = m_vars[slot].m_name.size();
+	if (length >= m_varsByLength.size())
+		m_varsByLength.resize(length + 1);
+	m_varsByLength[length].push_back(slot);
 }
 
 std::vector<std::string>
 Parser::GetVariableNames() const
 {
+	//longest first, by the order of creation for a same length
 	std::vector<std::string> names;
-	names.reserve(m_vars.size());
-	for (const auto &varEntry : m_vars)
-		names.push_back(varEntry.m_name);
-
-	std::sort(names.begin(), names.end(), 
-		[] (const std::string& first, const std::string& second){
-        	return first.size() > second.size();
-    });
+	names.reserve(m_varOrder.size());
+	for (size_t length = m_varsByLength.size(); length-- > 0; )
+		for (size_t slot : m_varsByLength[length])
+			names.push_back(m_vars[slot].m_name);
 
 	return names;
 }
@@ -81,34 +436,54 @@ Parser::GetVariableNames() const
 void 
 Parser::PrintVariables() const
 {
-	std::cout << "(";
+	PrintVariables(std::cout);
+}
+
+void
+Parser::PrintVariables(std::ostream &out) const
+{
+	out << "(";
 	bool first = true;
-	for (const auto &varEntry: m_vars) 
+	for (size_t slot : m_varOrder) 
 	{
+		const VarEntry &varEntry = m_vars[slot];
+		if (!m_observed.empty() && std::find(m_observed.begin(), m_observed.end(), varEntry.m_name) == m_observed.end())
+			continue;
    		if (first) 
 			first = false; 
 		else 
-			std::cout << ","; 
+			out << ","; 
 			
-		std::cout << varEntry.m_name << "=" << varEntry.m_value; 
+		out << varEntry.m_name << "=" << varEntry.m_value; 
 	}
 
-	std::cout << ")" << std::endl;
+	out << ")" << std::endl;
 }
 
-void 
-Parser::RecordVariable(const std::string& var, double value)
+void
+Parser::PrintParseStatistics() const
 {
-	for (auto &varEntry: m_vars) 
+	if (!ParseStatistics::Enabled)
 	{
-		if (varEntry.m_name == var)
-		{
-			varEntry.m_value = value;
-			return;
-		}
+		std::cout << "Parser: built without PARSER_INSTRUMENTATION, no parse statistics" << std::endl;
+		return;
+	}
+
+	for (size_t i = 0; i < m_statementStatistics.size(); ++i)
+	{
+		const ParseStatistics &statistics = m_statementStatistics[i];
+		if (statistics.GetTotalRewinds() == 0)
+			continue;
+		std::cout << "Statement " << i << ": " << statistics.GetTotalRewinds() << " rewinds, " 
+			<< statistics.GetTotalRescannedCharacters() << " characters rescanned: " << m_statements[i] << std::endl;
 	}
+	m_parseStatistics.Print(std::cout);
+}
 
-	m_vars.push_back(VarEntry(var, value));
+void 
+Parser::RecordVariable(const std::string& var, double value)
+{
+	RecordVariable(GetVariableSlot(var), value);
 }
 
 double 
@@ -117,20 +492,190 @@ Parser::EvaluateFunction(const std::string &function_name, double value) const
 	double res(0);
 	auto find = m_funcs.find(function_name);
 	if (find != m_funcs.end())
-		res = find->second(value);
+		res = CallFunction(find->second, value);
 
 	return res;
 }
 
+void
+Parser::SetFunctionCache(FunctionCache *cache)
+{
+	m_functionCache = cache;
+	if (!cache)
+		return;
+	for (const auto &func : m_funcs)
+		cache->AddPureFunction(func.first, &func.second);
+	for (const auto &func : m_binaryFuncs)
+		cache->AddPureFunction(func.first, &func.second);
+}
+
+double
+Parser::CallFunction(const CompiledExpression::Function &function, double a) const
+{
+	return m_functionCache ? m_functionCache->Call(function, a) : function(a);
+}
+
+double
+Parser::CallFunction(const CompiledExpression::BinaryFunction &function, double a, double b) const
+{
+	return m_functionCache ? m_functionCache->Call(function, a, b) : function(a, b);
+}
+
+const CompiledExpression::Function*
+Parser::GetFunction(const std::string &function_name) const
+{
+	auto find = m_funcs.find(function_name);
+	return find != m_funcs.end() ? &find->second : nullptr;
+}
+
+const CompiledExpression::BinaryFunction*
+Parser::GetBinaryFunction(const std::string &function_name) const
+{
+	auto find = m_binaryFuncs.find(function_name);
+	return find != m_binaryFuncs.end() ? &find->second : nullptr;
+}
+
+UserFunctionPtr
+Parser::GetUserFunction(const std::string &function_name) const
+{
+	auto find = m_userFuncs.find(function_name);
+	return find != m_userFuncs.end() ? find->second : nullptr;
+}
+
 ExpressionPtr Parser::EvaluateStatement() {
-	ExpressionPtr exp(EvaluateAssignment());
+	ExpressionPtr exp(EvaluateDefinition());
+	if (!exp)
+		exp = EvaluateLoop();
+	if (!exp)
+		exp = EvaluateAssignment();
 	if (!exp)
 		exp = EvaluateCalculation();
 	return exp;
 }
 
+ExpressionPtr Parser::EvaluateStatement(const std::string &statement)
+{
+	m_tokenizer.SetStatement(statement);
+	return EvaluateStatement();
+}
+
+ExpressionPtr Parser::EvaluateDefinition()
+{
+	PARSER_RULE_SCOPE(m_tokenizer.GetStatistics(), GrammarRule::Definition);
+	int curPos = m_tokenizer.GetCurrentPosition();
+	ExpressionPtr exp;
+
+	std::string func_name(m_tokenizer.EvaluateName());
+	std::vector<std::string> parameters;
+	bool builtin = GetFunction(func_name) || GetBinaryFunction(func_name);
+	if (!func_name.empty() && !builtin && m_tokenizer.EvaluateCharacter('(') && EvaluateParameters(parameters) && 
+		m_tokenizer.EvaluateCharacter(')') && m_tokenizer.EvaluateCharacter('='))
+	{
+		m_parameters = &parameters;
+		ExpressionPtr body = EvaluateSum();
+		m_parameters = nullptr;
+		if (body && m_tokenizer.ReachedEnd())
+		{
+			std::shared_ptr<UserFunction> func = std::make_shared<UserFunction>();
+			func->m_parameters = std::move(parameters);
+			func->m_body = body;
+			func->m_compiled.SetArguments(func->m_parameters.size());
+			body->Compile(func->m_compiled);
+			//calls already read keep the definition they were read with
+			m_userFuncs[func_name] = func;
+			m_parseCache.Clear();
+			exp = std::make_shared<FunctionDefinitionExpression>(func);
+		}
+	}
+	if (!exp)
+		m_tokenizer.SetCurrenPosition(curPos);
+	return exp;
+}
+
+ExpressionPtr Parser::EvaluateLoop()
+{
+	PARSER_RULE_SCOPE(m_tokenizer.GetStatistics(), GrammarRule::Loop);
+	int curPos = m_tokenizer.GetCurrentPosition();
+	ExpressionPtr exp;
+
+	VariableExpressionPtr var;
+	ExpressionPtr from, to;
+	if (m_tokenizer.EvaluateName() == "for" && (var = m_tokenizer.EvalutateVariable()) && m_tokenizer.EvaluateName() == "in" &&
+		(from = EvaluateSum()) && m_tokenizer.EvaluateCharacters("..") && (to = EvaluateSum()) && m_tokenizer.EvaluateCharacter(':'))
+	{
+		size_t loopVariables = m_loopVariables.size();
+		m_loopVariables.push_back(var->GetSlot());
+		++m_loopDepth;
+		std::vector<ExpressionPtr> body;
+		bool block = m_tokenizer.EvaluateCharacter('{');
+		ExpressionPtr statement;
+		do
+		{
+			statement = EvaluateBodyStatement();
+			if (statement)
+				body.push_back(statement);
+		} while (statement && block && m_tokenizer.EvaluateCharacter(';'));
+		bool read = statement && (!block || m_tokenizer.EvaluateCharacter('}'));
+		--m_loopDepth;
+		m_loopVariables.resize(loopVariables);
+
+		if (read && ReachedStatementEnd())
+			exp = std::make_shared<LoopExpression>(this, var, from, to, body);
+	}
+	if (!exp)
+		m_tokenizer.SetCurrenPosition(curPos);
+	return exp;
+}
+
+ExpressionPtr Parser::EvaluateBodyStatement()
+{
+	ExpressionPtr exp(EvaluateLoop());
+	if (!exp)
+		exp = EvaluateAssignment();
+	if (!exp)
+		exp = EvaluateCalculation();
+	return exp;
+}
+
+bool Parser::ReachedStatementEnd()
+{
+	if (m_tokenizer.ReachedEnd())
+		return true;
+	if (!m_loopDepth)
+		return false;
+	int curPos = m_tokenizer.GetCurrentPosition();
+	bool end = m_tokenizer.EvaluateCharacter(';') || m_tokenizer.EvaluateCharacter('}');
+	m_tokenizer.SetCurrenPosition(curPos);
+	return end;
+}
+
+bool Parser::EvaluateParameters(std::vector<std::string> &parameters)
+{
+	do
+	{
+		std::string name(m_tokenizer.EvaluateName());
+		if (name.empty() || std::find(parameters.begin(), parameters.end(), name) != parameters.end())
+			return false;
+		parameters.push_back(std::move(name));
+	} while (m_tokenizer.EvaluateCharacter(','));
+	return true;
+}
+
+bool Parser::EvaluateArguments(std::vector<ExpressionPtr> &arguments)
+{
+	do
+	{
+		ExpressionPtr argument = EvaluateSum();
+		if (!argument)
+			return false;
+		arguments.push_back(argument);
+	} while (m_tokenizer.EvaluateCharacter(','));
+	return true;
+}
+
 ExpressionPtr Parser::EvaluateAssignment()
 {
+	PARSER_RULE_SCOPE(m_tokenizer.GetStatistics(), GrammarRule::Assignment);
 	int curPos = m_tokenizer.GetCurrentPosition();
 	ExpressionPtr exp;
 
@@ -138,45 +683,40 @@ ExpressionPtr Parser::EvaluateAssignment()
 	ExpressionPtr rhs;
 	if (var)
 	{
-		if (m_tokenizer.EvaluateCharacter('=') && (rhs=EvaluateSum()) && m_tokenizer.ReachedEnd()) 
+		if (m_tokenizer.EvaluateCharacter('=') && (rhs=EvaluateSum()) && ReachedStatementEnd()) 
 			exp = std::make_shared<AssignmentExpression>(this, var, rhs);
 		else
 		{
 			ExpressionPtr newRhs;
-			bool varExist(false);
-			for (const auto &varEntry : m_vars)
-				if (varEntry.m_name == var->GetVariable())
-				{
-					varExist = true;
-					break;
-				}
-
-			if (varExist)
+			if (RequireVariable(var->GetVariable()))
 			{
 				//can do such operation for defined variables only
-				if (m_tokenizer.EvaluateCharacters("+=") && (rhs=EvaluateSum()) && m_tokenizer.ReachedEnd())
+				int opPos = m_tokenizer.GetCurrentPosition();
+				if (m_tokenizer.EvaluateCharacters("+=") && (rhs=EvaluateSum()) && ReachedStatementEnd())
 				{
-					newRhs = std::make_shared<AdditionExpression>(var, rhs);
+					newRhs = std::make_shared<AdditionExpression>(this, var, rhs);
 				}
-				else if (m_tokenizer.EvaluateCharacters("-=") && (rhs=EvaluateSum()) && m_tokenizer.ReachedEnd())
+				else if (m_tokenizer.EvaluateCharacters("-=") && (rhs=EvaluateSum()) && ReachedStatementEnd())
 				{
-					newRhs = std::make_shared<SubstractionExpression>(var, rhs);
+					newRhs = std::make_shared<SubstractionExpression>(this, var, rhs);
 				}
-				else if (m_tokenizer.EvaluateCharacters("*=") && (rhs=EvaluateSum()) && m_tokenizer.ReachedEnd())
+				else if (m_tokenizer.EvaluateCharacters("*=") && (rhs=EvaluateSum()) && ReachedStatementEnd())
 				{
-					newRhs = std::make_shared<MultiplicationExpression>(var, rhs);
+					newRhs = std::make_shared<MultiplicationExpression>(this, var, rhs);
 				}
-				else if (m_tokenizer.EvaluateCharacters("/=") && (rhs=EvaluateSum()) && m_tokenizer.ReachedEnd())
+				else if (m_tokenizer.EvaluateCharacters("/=") && (rhs=EvaluateSum()) && ReachedStatementEnd())
 				{
-					newRhs = std::make_shared<DivisionExpression>(var, rhs);
+					newRhs = std::make_shared<DivisionExpression>(this, var, rhs);
+					newRhs->SetPosition(opPos);
 				}
-				else if (m_tokenizer.EvaluateCharacters("^=") && (rhs=EvaluateSum()) && m_tokenizer.ReachedEnd())
+				else if (m_tokenizer.EvaluateCharacters("^=") && (rhs=EvaluateSum()) && ReachedStatementEnd())
 				{
-					newRhs = std::make_shared<ExponentiationExpression>(var, rhs);
+					newRhs = std::make_shared<ExponentiationExpression>(this, var, rhs);
 				}
-				else if (m_tokenizer.EvaluateCharacters("%=") && (rhs=EvaluateSum()) && m_tokenizer.ReachedEnd())
+				else if (m_tokenizer.EvaluateCharacters("%=") && (rhs=EvaluateSum()) && ReachedStatementEnd())
 				{
-					newRhs = std::make_shared<ModulusExpression>(var, rhs);
+					newRhs = std::make_shared<ModulusExpression>(this, var, rhs);
+					newRhs->SetPosition(opPos);
 				}
 			}
 		
@@ -187,13 +727,16 @@ ExpressionPtr Parser::EvaluateAssignment()
 	}
 	if (!exp)
 		m_tokenizer.SetCurrenPosition(curPos);
+	else if (m_loopDepth)
+		m_loopVariables.push_back(var->GetSlot());
 	return exp;
 }
 
 ExpressionPtr Parser::EvaluateCalculation()
 {
+	PARSER_RULE_SCOPE(m_tokenizer.GetStatistics(), GrammarRule::Calculation);
 	ExpressionPtr result;
-	if ((result=EvaluateSum()) && m_tokenizer.ReachedEnd())
+	if ((result=EvaluateSum()) && ReachedStatementEnd())
 		return result;
 	if(result) 
 		result = nullptr;
@@ -202,31 +745,35 @@ ExpressionPtr Parser::EvaluateCalculation()
 
 ExpressionPtr Parser::EvaluateSum()
 {
+	PARSER_RULE_SCOPE(m_tokenizer.GetStatistics(), GrammarRule::Sum);
 	int curPos = m_tokenizer.GetCurrentPosition();
 	ExpressionPtr lhs = EvaluateProduct();
 	ExpressionPtr rhs;
+	//a chain of operators is collected in one node instead of a left-deep tree
+	std::shared_ptr<SumExpression> sum;
 
 	while (lhs) 
 	{
-		if (m_tokenizer.EvaluateCharacter('+')) {
-			rhs=EvaluateProduct();
-			if (rhs)
-				lhs = std::make_shared<AdditionExpression>(lhs, rhs);
-			else 
-				lhs = nullptr;
-		}
+		bool substract(false);
+		if (m_tokenizer.EvaluateCharacter('+'))
+			substract = false;
 		else if (m_tokenizer.EvaluateCharacter('-')) 
-		{
-			rhs=EvaluateProduct();
-			if (rhs)
-				lhs = std::make_shared<SubstractionExpression>(lhs, rhs);
-			else 
-				lhs = nullptr;
-		}
+			substract = true;
 		else
 			break;
+
+		if (rhs=EvaluateProduct())
+		{
+			if (!sum)
+				sum = std::make_shared<SumExpression>(this, lhs);
+			sum->AddOperand(rhs, substract);
+		}
+		else 
+			lhs = nullptr;
 	}
 
+	if (lhs && sum)
+		lhs = sum;
 	if (lhs == nullptr)
 		m_tokenizer.SetCurrenPosition(curPos);
 	return lhs;
@@ -234,54 +781,56 @@ ExpressionPtr Parser::EvaluateSum()
 
 ExpressionPtr Parser::EvaluateProduct()
 {
+	PARSER_RULE_SCOPE(m_tokenizer.GetStatistics(), GrammarRule::Product);
 	int curPos = m_tokenizer.GetCurrentPosition();
 	ExpressionPtr lhs = EvaluateFactor();
 	ExpressionPtr rhs;
+	std::shared_ptr<ProductExpression> product;
 	while (lhs) 
 	{
-		if (m_tokenizer.EvaluateCharacter('*')) {
-			if (rhs=EvaluateFactor())
-				lhs = std::make_shared<MultiplicationExpression>(lhs, rhs);
-			else 
-				lhs = nullptr;
-		}
-		else if (m_tokenizer.EvaluateCharacter('/')) {
-			if (rhs=EvaluateFactor())
-				lhs = std::make_shared<DivisionExpression>(lhs, rhs);
-			else 
-				lhs = nullptr;
-		}
-		else if (m_tokenizer.EvaluateCharacter('%')){
-			if (rhs=EvaluateFactor())
-				lhs = std::make_shared<ModulusExpression>(lhs, rhs);
-			else 
-				lhs = nullptr;
-		}
+		OpCode op;
+		if (m_tokenizer.EvaluateCharacter('*'))
+			op = OpCode::Multiply;
+		else if (m_tokenizer.EvaluateCharacter('/'))
+			op = OpCode::Divide;
+		else if (m_tokenizer.EvaluateCharacter('%'))
+			op = OpCode::Modulus;
 		else
 			break;
+
+		int opPos = m_tokenizer.GetCurrentPosition() - 1;
+		if (rhs=EvaluateFactor())
+		{
+			if (!product)
+				product = std::make_shared<ProductExpression>(this, lhs);
+			product->AddOperand(rhs, op, opPos);
+		}
+		else 
+			lhs = nullptr;
 	}
+	if (lhs && product)
+		lhs = product;
 	if (!lhs)
 		m_tokenizer.SetCurrenPosition(curPos); 
 	return lhs;
 }
 
 ExpressionPtr Parser::EvaluateFactor() {
-	ExpressionPtr exp = nullptr;
-	if ((exp=EvaluatePower()) || (exp=EvaluateTerm()))
-		;
-	return exp;
+	//Power and Term share their prefix, EvaluatePower falls back to the Term it read
+	//instead of reading it a second time
+	return EvaluatePower();
 }
 
 ExpressionPtr Parser::EvaluatePower()
 {
-	int curPos = m_tokenizer.GetCurrentPosition();
-	ExpressionPtr exp;
-	if (exp=EvaluateFunction())
+	PARSER_RULE_SCOPE(m_tokenizer.GetStatistics(), GrammarRule::Power);
+	ExpressionPtr exp = EvaluateTerm();
+	if (!exp)
 		return exp;
-	ExpressionPtr lhs;
+	int curPos = m_tokenizer.GetCurrentPosition();
 	ExpressionPtr rhs;
-	if ((lhs=EvaluateTerm()) && m_tokenizer.EvaluateCharacter('^') && (rhs=EvaluateFactor()))
-		exp = std::make_shared<ExponentiationExpression>(lhs, rhs);
+	if (m_tokenizer.EvaluateCharacter('^') && (rhs=EvaluateFactor()))
+		exp = std::make_shared<ExponentiationExpression>(this, exp, rhs);
 	else
 		m_tokenizer.SetCurrenPosition(curPos);
 	return exp;
@@ -289,13 +838,15 @@ ExpressionPtr Parser::EvaluatePower()
 
 ExpressionPtr Parser::EvaluateTerm()
 {
+	PARSER_RULE_SCOPE(m_tokenizer.GetStatistics(), GrammarRule::Term);
 	ExpressionPtr exp;
-	if ((exp=EvaluateGroup()) || (exp=EvaluateFunction()) || (exp=m_tokenizer.EvalutateVariable()) || (exp=m_tokenizer.EvaluateNumber()))
+	if ((exp=EvaluateGroup()) || (exp=EvaluateFunction()) || (exp=EvaluateParameter()) || (exp=m_tokenizer.EvalutateVariable()) || (exp=m_tokenizer.EvaluateNumber()))
 		;
 	return exp;
 }
 
 ExpressionPtr Parser::EvaluateGroup() {
+	PARSER_RULE_SCOPE(m_tokenizer.GetStatistics(), GrammarRule::Group);
 	int curPos = m_tokenizer.GetCurrentPosition();
 	ExpressionPtr exp;
 	if (m_tokenizer.EvaluateCharacter('(') && (exp=EvaluateSum()) && (m_tokenizer.EvaluateCharacter(')')))
@@ -311,28 +862,47 @@ ExpressionPtr Parser::EvaluateGroup() {
 
 ExpressionPtr Parser::EvaluateFunction()
 {
+	PARSER_RULE_SCOPE(m_tokenizer.GetStatistics(), GrammarRule::Function);
 	int curPos = m_tokenizer.GetCurrentPosition();
 	ExpressionPtr func_exp, exp;
-	if ((exp=m_tokenizer.EvaluatePrefixFunction()) || (exp=m_tokenizer.EvaluatePostfixFunction()))
+	//++ and -- apply when the statement is read, so they are not allowed in a function body
+	if (!m_parameters && ((exp=m_tokenizer.EvaluatePrefixFunction()) || (exp=m_tokenizer.EvaluatePostfixFunction())))
 		return exp;
-	std::string func_name;
-	for (const auto &func_pair : m_funcs)
-	{
-		if (m_tokenizer.EvaluateCharacters(func_pair.first))
-		{
-			func_name = func_pair.first;
-			break;
-		}
-	}
 
-	if (!func_name.empty() && m_tokenizer.EvaluateCharacter('(') && (exp=EvaluateSum()) && (m_tokenizer.EvaluateCharacter(')')))
+	std::string func_name(m_tokenizer.EvaluateName());
+	const CompiledExpression::Function *func = GetFunction(func_name);
+	const CompiledExpression::BinaryFunction *binaryFunc = GetBinaryFunction(func_name);
+	UserFunctionPtr userFunc = GetUserFunction(func_name);
+	std::vector<ExpressionPtr> arguments;
+
+	if ((func || binaryFunc || userFunc) && m_tokenizer.EvaluateCharacter('(') && EvaluateArguments(arguments) && (m_tokenizer.EvaluateCharacter(')')))
 	{
-		func_exp = std::make_shared<FunctionCallExpression>(this, func_name, exp);
+		if (func && arguments.size() == 1)
+			func_exp = std::make_shared<FunctionCallExpression>(this, func_name, arguments[0]);
+		else if (binaryFunc && arguments.size() == 2)
+			func_exp = std::make_shared<BinaryFunctionCallExpression>(this, func_name, arguments[0], arguments[1]);
+		else if (userFunc && arguments.size() == userFunc->m_parameters.size())
+			func_exp = std::make_shared<UserFunctionCallExpression>(this, userFunc, arguments);
 	}
-	else
-	{
+
+	if (!func_exp)
 		m_tokenizer.SetCurrenPosition(curPos);
-	}
 
 	return func_exp;
 }
+
+ExpressionPtr Parser::EvaluateParameter()
+{
+	ExpressionPtr exp;
+	if (!m_parameters)
+		return exp;
+
+	int curPos = m_tokenizer.GetCurrentPosition();
+	std::string name(m_tokenizer.EvaluateName());
+	auto find = std::find(m_parameters->begin(), m_parameters->end(), name);
+	if (!name.empty() && find != m_parameters->end())
+		exp = std::make_shared<ParameterExpression>(find - m_parameters->begin());
+	else
+		m_tokenizer.SetCurrenPosition(curPos);
+	return exp;
+}
@@ -1,65 +1,232 @@
 #pragma once
 
 #include "Expression.h"
+#include "CompiledExpression.h"
 #include "Tokenizer.h"
+#include "ParseStatistics.h"
+#include "StatementProfiler.h"
+#include "ParseCache.h"
+#include "SyntaxChecker.h"
 #include <vector>
 #include <map>
+#include <unordered_map>
+#include <cstdint>
 #include <functional>
+#include <memory>
+#include <ostream>
 
 class Expression;
+class CompiledCache;
+class FunctionCache;
+class ParallelSumParser;
+class VersionedEnvironment;
 
 /*
 	Parser class to parse, interpret and evaluate CFG statements
 
 	The grammar rules are:
-	Statement -> Assignment OR Calculation
+	Statement -> Definition OR Loop OR Assignment OR Calculation
+	Definition -> FunctionName '(' Variable (',' Variable)* ')' '=' Sum
+	Loop -> 'for' Variable 'in' Sum '..' Sum ':' Body
+	Body -> '{' BodyStatement (';' BodyStatement)* '}' OR BodyStatement
+	BodyStatement -> Loop OR Assignment OR Calculation
 	Assignment -> Variable '=' Sum
 	Calculation -> Sum
 	Sum -> Product (('+' Product)|('-' Product))*
-	Product -> Factor (('*' Factor)|('/' Factor))*
+	Product -> Factor (('*' Factor)|('/' Factor)|('%' Factor))*
 	Factor -> Power | Term
-	Power -> Function | Term '^' Factor
-	Term -> Group | Variable | Number
+	Power -> Term '^' Factor
+	Term -> Group | Function | Parameter | Variable | Number
 	Function -> PrefixFunction | PostFixFunction | FunctionCall
 	PrefixFunction -> 'Variable' + 1
 	PostFixFunction -> 'Variable'
-	FunctionCall -> FunctionName '(' Sum ')'
+	FunctionCall -> FunctionName '(' Sum (',' Sum)* ')'
 	Group -> '(' Sum ')'
+
+	A Definition registers a user function when it is read, Parameter is one of its variables
+	and is only valid in its body.
+	A Loop runs its body for every integer step from the first Sum up to the second one excluded,
+	its body is read once. In the body the variable of the loop and the variables assigned by
+	previous statements of the body count as defined, e.g. for i in 0..n: {t = i; t *= 2}
 */
 class Parser
 {
 public:
 
 	/*
-		VarEntry utility class to hold data of the stored variables by the order of creation
+		VarEntry utility class to hold data of the stored variables by slot
+		A slot is created for every name read, the variable exists once it was assigned
 	*/
 	struct VarEntry{
-		VarEntry(const std::string &varName, double varValue)
+		VarEntry(const std::string &varName, double varValue, bool defined = true)
 			: m_name(varName)
 			, m_value(varValue)
+			, m_defined(defined)
 		{
 
 		}
 
 		std::string m_name;
 		double m_value;
+		bool m_defined;
 	};
+
+	/*
+		StatementError utility class to hold the first error reported by a statement.
+		A syntax error found by the SyntaxChecker has the tokens expected at its position
+	*/
+	struct StatementError{
+		StatementError(ErrorCode code, size_t statement, int position, uint32_t expected = 0)
+			: m_code(code)
+			, m_statement(statement)
+			, m_position(position)
+			, m_expected(expected)
+		{
+
+		}
+
+		ErrorCode m_code;
+		size_t m_statement;
+		int m_position;
+		//Combination of the SyntaxChecker tokens, 0 if unknown
+		uint32_t m_expected;
+	};
+
 	Parser();
-	~Parser() = default;
+	~Parser();
 	void AddStatement(std::string statement);
 	void EvaluateStatements();
+	//Only these variables are needed once the statements ran, empty for every variable.
+	//EvaluateStatements then reads every statement first and skips those no observed variable
+	//depends on, see Liveness.h, and PrintVariables only prints the observed variables.
+	//Those statements are neither profiled nor counted in the statistics of each statement
+	void SetObservedVariables(const std::vector<std::string> &variables) { m_observed = variables; }
+	const std::vector<std::string>& GetObservedVariables() const { return m_observed; }
+	//Statements the last EvaluateStatements skipped, no observed variable depending on them
+	size_t GetEliminatedStatements() const { return m_eliminated; }
+	//Forget the statements, the variables and the user functions are kept
+	void ClearStatements() { m_statements.clear(); }
+	//Forget the statements, the variables, the user functions and the errors
+	void Reset();
 
 	ExpressionPtr EvaluateStatement();
+	//Parse a statement added by AddStatement and compile it without evaluating it,
+	//a syntax error is reported for it on failure, at its first unexpected token
+	bool CompileStatement(size_t statement, CompiledExpression &compiled);
+	size_t GetStatementCount() const { return m_statements.size(); }
+	const std::string& GetStatement(size_t statement) const { return m_statements[statement]; }
+	//Parse a single statement without evaluating it
+	ExpressionPtr EvaluateStatement(const std::string &statement);
 
 	//Print variables to stdout according to the required format
 	void PrintVariables() const;
+	void PrintVariables(std::ostream &out) const;
+
+	//Errors of the last EvaluateStatements run, at most one per statement, by statement order
+	const std::vector<StatementError>& GetErrors() const { return m_errors; }
+	bool HasErrors() const { return !m_errors.empty(); }
+	void ClearErrors() { m_errors.clear(); }
+	void ReportError(ErrorCode code, int position, uint32_t expected = 0);
+
+	//Print errors to stdout, one line per failed statement
+	void PrintErrors() const;
+	void PrintErrors(std::ostream &out) const;
+
+	//Check every statement with the SyntaxChecker before reading it, on by default: a malformed
+	//statement is reported at its first unexpected token instead of trying every rule
+	void EnableSyntaxCheck(bool enable) { m_syntaxCheck = enable; }
+
+	//Per-rule parse counters, see ParseStatistics. Only counted when built with PARSER_INSTRUMENTATION
+	const ParseStatistics& GetParseStatistics() const { return m_parseStatistics; }
+	//Counters of each statement of the last EvaluateStatements run, by statement order
+	const std::vector<ParseStatistics>& GetStatementStatistics() const { return m_statementStatistics; }
+	//Print the statements which rewound the tokenizer and the aggregated counters to stdout
+	void PrintParseStatistics() const;
+
+	//Record latency, allocations and created nodes of every statement in EvaluateStatements
+	void EnableProfiling(bool enable) { m_profiling = enable; }
+	const StatementProfiler& GetProfiler() const { return m_profiler; }
+
 	double LookupVariable(const std::string& var) const;
+	bool HasVariable(const std::string& var) const;
+	//HasVariable for the reading of a statement which is only valid while var is defined,
+	//e.g. i++, remembered in GetRequiredVariables, or in GetUndefinedVariables when it is not
+	bool RequireVariable(const std::string& var);
+	//Slots of the variables the last statement compiled required, see RequireVariable
+	const std::vector<size_t>& GetRequiredVariables() const { return m_requiredVariables; }
+	//Names the last statement compiled found undefined, it is read another way once one is
+	//defined, e.g. x+++y is x + ++y while x is undefined and x++ + y after
+	const std::vector<std::string>& GetUndefinedVariables() const { return m_undefinedVariables; }
 	void RecordVariable(const std::string& var, double value);
+	//Names of the defined variables, the longest first
 	std::vector<std::string> GetVariableNames() const;
 
+	//Define the variables compiled assigns, so the next statements are read as if it was evaluated
+	void DefineAssignedVariables(const CompiledExpression &compiled);
+	//DefineAssignedVariables for compiled[statement], the statements before it read the same way.
+	//Whether a loop which may run zero times defines a variable is known by running the
+	//statements from read to statement on reading, a version of the variables before the
+	//first statement, read then moves after statement
+	void DefineReachedVariables(const std::vector<CompiledExpression> &compiled, size_t statement,
+		VersionedEnvironment &reading, size_t &read);
+	//Undefine the variables defined after the first count ones by the order of creation,
+	//their slots and values are kept
+	void UndefineVariables(size_t count);
+	//Slot of a variable for compiled access, created undefined for a new name
+	size_t GetVariableSlot(const std::string& var);
+	//Slot of a variable by name, false if no statement read it
+	bool FindVariable(const std::string& var, size_t &slot) const;
+	size_t GetSlotCount() const { return m_vars.size(); }
+	const std::string& GetVariableName(size_t slot) const { return m_vars[slot].m_name; }
+	//Slots of the defined variables by the order of creation
+	const std::vector<size_t>& GetVariableOrder() const { return m_varOrder; }
+	double LookupVariable(size_t slot) const { return m_vars[slot].m_value; }
+	bool IsVariableDefined(size_t slot) const { return m_vars[slot].m_defined; }
+	void RecordVariable(size_t slot, double value)
+	{
+		VarEntry &varEntry = m_vars[slot];
+		varEntry.m_value = value;
+		if (!varEntry.m_defined)
+			DefineVariable(slot);
+	}
+
 	double EvaluateFunction(const std::string &function_name, double value) const;
+	//Function of the map by name, nullptr if there is no such function
+	const CompiledExpression::Function* GetFunction(const std::string &function_name) const;
+	const CompiledExpression::BinaryFunction* GetBinaryFunction(const std::string &function_name) const;
+	//Function defined by a statement, nullptr if there is no such function
+	UserFunctionPtr GetUserFunction(const std::string &function_name) const;
+	//Name of a function of the maps, empty if it is not one
+	std::string GetFunctionName(const CompiledExpression::Function *function) const;
+	std::string GetFunctionName(const CompiledExpression::BinaryFunction *function) const;
+	//Hash of the built-in functions, compiled code refers to them by name
+	static uint64_t GetFunctionTableVersion();
+
+	//Repeated statements are compiled from the text read before, see ParseCache
+	const ParseCache& GetParseCache() const { return m_parseCache; }
+	void SetParseCacheLimits(size_t maxEntries, size_t maxBytes) { m_parseCache.SetLimits(maxEntries, maxBytes); }
+
+	//Statements found in cache are not read, the others are stored in it. May be null
+	void SetCompiledCache(CompiledCache *cache) { m_compiledCache = cache; }
+
+	//Calls of the built-in functions, which are all pure, are evaluated through cache. May be null
+	void SetFunctionCache(FunctionCache *cache);
+	FunctionCache* GetFunctionCache() const { return m_functionCache; }
+	//Call a function of the maps, through the function cache if there is one
+	double CallFunction(const CompiledExpression::Function &function, double a) const;
+	double CallFunction(const CompiledExpression::BinaryFunction &function, double a, double b) const;
+
+	//Read the statements of at least minBytes with threads threads, splitting their sum at its
+	//top-level '+' and '-', see ParallelSumParser. 1 to read every statement on the calling thread
+	void SetParseThreads(size_t threads, size_t minBytes = s_parallelBytes);
+	size_t GetParseThreads() const;
+	//Size from which a statement is read by several threads by default
+	static const size_t s_parallelBytes = 64 * 1024;
 
 protected:
+	ExpressionPtr EvaluateDefinition();
+	ExpressionPtr EvaluateLoop();
+	ExpressionPtr EvaluateBodyStatement();
 	ExpressionPtr EvaluateAssignment();
 	ExpressionPtr EvaluateCalculation();
 	ExpressionPtr EvaluateSum();
@@ -69,14 +236,63 @@ protected:
 	ExpressionPtr EvaluateTerm();
 	ExpressionPtr EvaluateGroup();
 	ExpressionPtr EvaluateFunction();
+	ExpressionPtr EvaluateParameter();
+	bool EvaluateParameters(std::vector<std::string> &parameters);
+	bool EvaluateArguments(std::vector<ExpressionPtr> &arguments);
 
 private:
+	friend class ParallelSumParser;
 
-	//Prepopulate the functions map that can be interpreted
-	void BuildFunctionsMap();
+	using FunctionsMap = std::map<std::string, CompiledExpression::Function>;
+	using BinaryFunctionsMap = std::map<std::string, CompiledExpression::BinaryFunction>;
+	//The functions maps that can be interpreted, built once and shared by every parser,
+	//so compiled code may keep pointing to them after its parser is gone
+	static const FunctionsMap& GetFunctionsMap();
+	static const BinaryFunctionsMap& GetBinaryFunctionsMap();
+	//Parse and evaluate the current statement and record its profile
+	void EvaluateProfiledStatement();
+	//Read every statement, then evaluate those the observed variables depend on
+	void EvaluateObservedStatements();
+	void DefineVariable(size_t slot);
+	//Take the variables and the user functions of other, keeping their slots
+	void ShareDefinitions(const Parser &other);
+	//Whether the statement being read ends here, in a loop body also before ';' or '}'
+	bool ReachedStatementEnd();
 	Tokenizer m_tokenizer;
 	std::vector<std::string> m_statements;
 	std::vector<VarEntry> m_vars;
-	std::map<std::string, std::function<double(double)>> m_funcs;
+	//Slot of every variable in m_vars by name
+	std::unordered_map<std::string, size_t> m_varIndex;
+	//Slots of the defined variables by the order of creation
+	std::vector<size_t> m_varOrder;
+	//Slots of the defined variables by the length of their name, then by the order of creation
+	std::vector<std::vector<size_t>> m_varsByLength;
+	CompiledExpression m_compiled;
+	std::vector<double> m_stack;
+	std::vector<StatementError> m_errors;
+	size_t m_currentStatement = 0;
+	ParseStatistics m_parseStatistics;
+	std::vector<ParseStatistics> m_statementStatistics;
+	bool m_profiling = false;
+	StatementProfiler m_profiler;
+	const FunctionsMap &m_funcs;
+	const BinaryFunctionsMap &m_binaryFuncs;
+	std::map<std::string, UserFunctionPtr> m_userFuncs;
+	//Parameters of the function definition being read, nullptr outside of a definition
+	const std::vector<std::string> *m_parameters = nullptr;
+	std::vector<size_t> m_requiredVariables;
+	std::vector<std::string> m_undefinedVariables;
+	//Slots assigned by the loops being read so far, defined for the rest of their body
+	std::vector<size_t> m_loopVariables;
+	size_t m_loopDepth = 0;
+	std::vector<std::string> m_observed;
+	size_t m_eliminated = 0;
+	CompiledCache *m_compiledCache = nullptr;
+	FunctionCache *m_functionCache = nullptr;
+	ParseCache m_parseCache;
+	SyntaxChecker m_syntaxChecker;
+	bool m_syntaxCheck = true;
+	std::unique_ptr<ParallelSumParser> m_parallelSum;
+	size_t m_parallelBytes = s_parallelBytes;
 };
 
@@ -0,0 +1,57 @@
+#include "Program.h"
+#include "Environment.h"
+#include "VersionedEnvironment.h"
+
+Program::Program(Parser &parser)
+{
+	//the values before the first statement are the initial values
+	m_initialValues.resize(parser.GetSlotCount());
+	for (size_t slot = 0; slot < m_initialValues.size(); ++slot)
+		m_initialValues[slot] = parser.LookupVariable(slot);
+	m_initialOrder = parser.GetVariableOrder();
+
+	parser.ClearErrors();
+	m_compiled.resize(parser.GetStatementCount());
+	VersionedEnvironment reading(parser);
+	size_t read = 0;
+	for (size_t statement = 0; statement < m_compiled.size(); ++statement)
+	{
+		m_statements.push_back(parser.GetStatement(statement));
+		if (!parser.CompileStatement(statement, m_compiled[statement]))
+			continue;
+
+		//the next statements are read with the variables assigned here defined, e.g. for a postfix
+		//function, a loop which may run zero times only defining those it does from the initial values
+		parser.DefineReachedVariables(m_compiled, statement, reading, read);
+	}
+	m_errors = parser.GetErrors();
+
+	m_names.reserve(parser.GetSlotCount());
+	for (size_t slot = 0; slot < parser.GetSlotCount(); ++slot)
+	{
+		m_names.push_back(parser.GetVariableName(slot));
+		m_slots.emplace(m_names.back(), slot);
+	}
+	m_initialValues.resize(m_names.size(), 0);
+}
+
+void
+Program::Run(Environment &environment) const
+{
+	environment.m_errors.clear();
+	for (size_t statement = 0; statement < m_compiled.size(); ++statement)
+	{
+		environment.m_currentStatement = statement;
+		m_compiled[statement].Evaluate<double>(environment, environment.m_stack);
+	}
+}
+
+bool
+Program::FindVariable(const std::string &name, size_t &slot) const
+{
+	auto find = m_slots.find(name);
+	if (find == m_slots.end())
+		return false;
+	slot = find->second;
+	return true;
+}
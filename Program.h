@@ -0,0 +1,55 @@
+#pragma once
+#include "CompiledExpression.h"
+#include "Parser.h"
+
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+class Environment;
+
+/*
+	Program class holds the statements of a Parser compiled once and never changes after
+	Nothing of the parser is referenced, so any number of threads may run the same program
+	at the same time, each against its own Environment, without locks
+*/
+class Program
+{
+public:
+	//Read and compile the statements added to parser, the variables the parser holds are
+	//the initial values of every environment. The parser defines the variables assigned by
+	//the statements as it reads them, see Parser::DefineReachedVariables: a variable only a loop
+	//which may run zero times assigns is defined as a run from the initial values defines it
+	explicit Program(Parser &parser);
+
+	//Evaluate every statement against environment, which must have been created for this program
+	void Run(Environment &environment) const;
+
+	size_t GetStatementCount() const { return m_statements.size(); }
+	const std::string& GetStatement(size_t statement) const { return m_statements[statement]; }
+
+	size_t GetSlotCount() const { return m_names.size(); }
+	const std::string& GetVariableName(size_t slot) const { return m_names[slot]; }
+	//Slot of a variable by name, false if no statement reads or writes it
+	bool FindVariable(const std::string &name, size_t &slot) const;
+
+	//Syntax errors found while compiling, by statement order
+	const std::vector<Parser::StatementError>& GetErrors() const { return m_errors; }
+
+private:
+	friend class Environment;
+	template <size_t K, typename V>
+	friend class LaneEnvironment;
+
+	std::vector<std::string> m_statements;
+	std::vector<CompiledExpression> m_compiled;
+	std::vector<std::string> m_names;
+	std::unordered_map<std::string, size_t> m_slots;
+	std::vector<double> m_initialValues;
+	//Slots of the variables defined before the first statement by the order of creation
+	std::vector<size_t> m_initialOrder;
+	std::vector<Parser::StatementError> m_errors;
+};
+
+using ProgramPtr = std::shared_ptr<const Program>;
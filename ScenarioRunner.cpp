@@ -0,0 +1,72 @@
+#include "ScenarioRunner.h"
+
+#include <atomic>
+#include <thread>
+
+//The base variables are those of parser once its statements ran
+static const Parser&
+EvaluateBase(Parser &parser)
+{
+	parser.EvaluateStatements();
+	return parser;
+}
+
+ScenarioRunner::ScenarioRunner(Parser &parser)
+	: m_parser(parser)
+	, m_base(EvaluateBase(parser))
+{
+	m_baseErrors = m_parser.GetErrors();
+	m_baseDefined = m_parser.GetVariableOrder().size();
+	m_parser.ClearStatements();
+	m_parser.ClearErrors();
+}
+
+size_t
+ScenarioRunner::AddScenario(const std::vector<std::string> &statements)
+{
+	m_scenarios.emplace_back(m_base.Fork());
+	Scenario &scenario = m_scenarios.back();
+	for (const std::string &statement : statements)
+		m_parser.AddStatement(statement);
+
+	//a loop which may run zero times defines what running the scenario after the base defines
+	scenario.m_compiled.resize(statements.size());
+	VersionedEnvironment reading = m_base.Fork();
+	size_t read = 0;
+	for (size_t statement = 0; statement < statements.size(); ++statement)
+		if (m_parser.CompileStatement(statement, scenario.m_compiled[statement]))
+			m_parser.DefineReachedVariables(scenario.m_compiled, statement, reading, read);
+	scenario.m_syntaxErrors = m_parser.GetErrors();
+
+	//the next scenario is read right after the base again
+	m_parser.UndefineVariables(m_baseDefined);
+	m_parser.ClearStatements();
+	m_parser.ClearErrors();
+	return m_scenarios.size() - 1;
+}
+
+void
+ScenarioRunner::Run(size_t threads)
+{
+	for (Scenario &scenario : m_scenarios)
+	{
+		scenario.m_result = m_base.Fork();
+		scenario.m_result.Reserve(m_parser.GetSlotCount());
+	}
+
+	std::atomic<size_t> next(0);
+	auto work = [this, &next]() {
+		for (size_t scenario = next++; scenario < m_scenarios.size(); scenario = next++)
+			m_scenarios[scenario].m_result.Run(m_scenarios[scenario].m_compiled);
+	};
+	if (threads <= 1)
+	{
+		work();
+		return;
+	}
+	std::vector<std::thread> workers;
+	for (size_t t = 0; t < threads; ++t)
+		workers.emplace_back(work);
+	for (std::thread &worker : workers)
+		worker.join();
+}
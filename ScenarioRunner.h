@@ -0,0 +1,64 @@
+#pragma once
+#include "CompiledExpression.h"
+#include "Parser.h"
+#include "VersionedEnvironment.h"
+
+#include <cstddef>
+#include <string>
+#include <utility>
+#include <vector>
+
+/*
+	ScenarioRunner class evaluates what-if variants of a script. The statements of a Parser are
+	a base evaluated once, every scenario adds its own statements evaluated after the base on
+	a fork of its variables, see VersionedEnvironment.
+
+	Every scenario is read by the parser as if it directly followed the base: the variables
+	another scenario assigned are not defined for it. A function a scenario defines is
+	registered in the parser and known to the scenarios read after it.
+	Running does not use the parser, the scenarios may be evaluated by several threads
+*/
+class ScenarioRunner
+{
+public:
+	//Evaluate the statements of parser as the base, they are then cleared from it
+	explicit ScenarioRunner(Parser &parser);
+
+	//Read the statements of a new scenario, returns its index
+	size_t AddScenario(const std::vector<std::string> &statements);
+
+	//Evaluate every scenario on a new fork of the base, threads sharing out the scenarios
+	void Run(size_t threads = 1);
+
+	size_t GetScenarioCount() const { return m_scenarios.size(); }
+	//Variables of the base after its statements
+	const VersionedEnvironment& GetBase() const { return m_base; }
+	const std::vector<Parser::StatementError>& GetBaseErrors() const { return m_baseErrors; }
+	//Variables of the scenario after its last run, the base before it ran
+	const VersionedEnvironment& GetResult(size_t scenario) const { return m_scenarios[scenario].m_result; }
+	//Syntax errors of reading the scenario, by statement order of the scenario
+	const std::vector<Parser::StatementError>& GetSyntaxErrors(size_t scenario) const { return m_scenarios[scenario].m_syntaxErrors; }
+
+private:
+	/*
+		Scenario utility class to hold the compiled statements of a scenario with its last result
+	*/
+	struct Scenario
+	{
+		Scenario(VersionedEnvironment &&result)
+			: m_result(std::move(result))
+		{
+		}
+
+		std::vector<CompiledExpression> m_compiled;
+		std::vector<Parser::StatementError> m_syntaxErrors;
+		VersionedEnvironment m_result;
+	};
+
+	Parser &m_parser;
+	std::vector<Parser::StatementError> m_baseErrors;
+	//Number of variables the base defines
+	size_t m_baseDefined;
+	VersionedEnvironment m_base;
+	std::vector<Scenario> m_scenarios;
+};
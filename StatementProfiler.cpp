@@ -0,0 +1,154 @@
+#include "StatementProfiler.h"
+
+#include <algorithm>
+#include <cmath>
+#include <iomanip>
+
+static size_t HighestBit(uint64_t value)
+{
+#if defined(__GNUC__)
+	return 63 - __builtin_clzll(value);
+#else
+	size_t bit(0);
+	while (value >>= 1)
+		++bit;
+	return bit;
+#endif
+}
+
+size_t
+LogHistogram::GetBucket(uint64_t value)
+{
+	//values below s_subBuckets are counted exactly in the first buckets
+	if (value < s_subBuckets)
+		return static_cast<size_t>(value);
+
+	size_t exponent = HighestBit(value) - s_subBucketBits;
+	size_t subBucket = static_cast<size_t>(value >> exponent) - s_subBuckets;
+	return (exponent + 1) * s_subBuckets + subBucket;
+}
+
+uint64_t
+LogHistogram::GetBucketUpperBound(size_t bucket)
+{
+	if (bucket < s_subBuckets)
+		return bucket;
+
+	size_t exponent = bucket / s_subBuckets - 1;
+	uint64_t subBucket = bucket % s_subBuckets + s_subBuckets;
+	return ((subBucket + 1) << exponent) - 1;
+}
+
+void
+LogHistogram::Record(uint64_t value)
+{
+	++m_counts[GetBucket(value)];
+	++m_count;
+	m_sum += value;
+	m_max = std::max(m_max, value);
+}
+
+void
+LogHistogram::Add(const LogHistogram &other)
+{
+	for (size_t bucket = 0; bucket < s_buckets; ++bucket)
+		m_counts[bucket] += other.m_counts[bucket];
+	m_count += other.m_count;
+	m_sum += other.m_sum;
+	m_max = std::max(m_max, other.m_max);
+}
+
+uint64_t
+LogHistogram::GetPercentile(double percentile) const
+{
+	if (m_count == 0)
+		return 0;
+
+	uint64_t rank = static_cast<uint64_t>(std::ceil(percentile / 100.0 * m_count));
+	rank = std::max<uint64_t>(rank, 1);
+	uint64_t seen(0);
+	for (size_t bucket = 0; bucket < s_buckets; ++bucket)
+	{
+		seen += m_counts[bucket];
+		if (seen >= rank)
+			return std::min(GetBucketUpperBound(bucket), m_max);
+	}
+	return m_max;
+}
+
+void
+StatementProfiler::Clear()
+{
+	m_statements.clear();
+	m_parseLatency.Clear();
+	m_evaluateLatency.Clear();
+	m_allocations.Clear();
+	m_expressions.Clear();
+}
+
+void
+StatementProfiler::Record(const StatementProfile &profile)
+{
+	m_statements.push_back(profile);
+	m_parseLatency.Record(profile.m_parseNanoseconds);
+	m_evaluateLatency.Record(profile.m_evaluateNanoseconds);
+	m_allocations.Record(profile.m_allocations);
+	m_expressions.Record(profile.m_expressions);
+}
+
+static void WriteTextRow(std::ostream &out, const char *name, const LogHistogram &histogram)
+{
+	std::streamsize precision = out.precision();
+	out << std::left << std::setw(16) << name << std::right
+		<< std::setw(12) << std::fixed << std::setprecision(1) << histogram.GetMean() 
+		<< std::setw(12) << histogram.GetPercentile(50)
+		<< std::setw(12) << histogram.GetPercentile(99)
+		<< std::setw(12) << histogram.GetPercentile(99.9)
+		<< std::setw(12) << histogram.GetMax() << std::endl;
+	out << std::defaultfloat << std::setprecision(precision);
+}
+
+void
+StatementProfiler::WriteText(std::ostream &out) const
+{
+	out << "Profiled " << m_statements.size() << " statements" << std::endl;
+	out << std::left << std::setw(16) << "" << std::right << std::setw(12) << "mean" << std::setw(12) << "p50" 
+		<< std::setw(12) << "p99" << std::setw(12) << "p999" << std::setw(12) << "max" << std::endl;
+	WriteTextRow(out, "parse(ns)", m_parseLatency);
+	WriteTextRow(out, "evaluate(ns)", m_evaluateLatency);
+	WriteTextRow(out, "allocations", m_allocations);
+	WriteTextRow(out, "expressions", m_expressions);
+}
+
+static void WriteJsonHistogram(std::ostream &out, const char *name, const LogHistogram &histogram)
+{
+	out << "\"" << name << "\": {\"count\": " << histogram.GetCount()
+		<< ", \"mean\": " << histogram.GetMean()
+		<< ", \"p50\": " << histogram.GetPercentile(50)
+		<< ", \"p99\": " << histogram.GetPercentile(99)
+		<< ", \"p999\": " << histogram.GetPercentile(99.9)
+		<< ", \"max\": " << histogram.GetMax() << "}";
+}
+
+void
+StatementProfiler::WriteJson(std::ostream &out) const
+{
+	out << "{\n";
+	WriteJsonHistogram(out, "parse_ns", m_parseLatency);
+	out << ",\n";
+	WriteJsonHistogram(out, "evaluate_ns", m_evaluateLatency);
+	out << ",\n";
+	WriteJsonHistogram(out, "allocations", m_allocations);
+	out << ",\n";
+	WriteJsonHistogram(out, "expressions", m_expressions);
+	out << ",\n\"statements\": [";
+	for (size_t i = 0; i < m_statements.size(); ++i)
+	{
+		const StatementProfile &profile = m_statements[i];
+		out << (i ? ",\n" : "\n") << "{\"parse_ns\": " << profile.m_parseNanoseconds 
+			<< ", \"evaluate_ns\": " << profile.m_evaluateNanoseconds
+			<< ", \"allocations\": " << profile.m_allocations 
+			<< ", \"expressions\": " << profile.m_expressions << "}";
+	}
+	out << "\n]\n}" << std::endl;
+}
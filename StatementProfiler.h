@@ -0,0 +1,74 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <ostream>
+#include <vector>
+
+/*
+	LogHistogram class counts values in logarithmic buckets:
+	every power of two is split into 8 linear sub-buckets, so a recorded value is
+	known within 12.5%. Recording is a few bit operations and no allocation.
+*/
+class LogHistogram
+{
+public:
+	void Record(uint64_t value);
+	void Clear() { *this = LogHistogram(); }
+	//Count the values recorded by other too
+	void Add(const LogHistogram &other);
+
+	uint64_t GetCount() const { return m_count; }
+	uint64_t GetMax() const { return m_max; }
+	double GetMean() const { return m_count ? static_cast<double>(m_sum) / m_count : 0; }
+
+	//Upper bound of the bucket holding the given percentile, e.g. 99.9
+	uint64_t GetPercentile(double percentile) const;
+
+private:
+	static const size_t s_subBucketBits = 3;
+	static const size_t s_subBuckets = 1 << s_subBucketBits;
+	static const size_t s_buckets = (64 - s_subBucketBits + 1) * s_subBuckets;
+
+	static size_t GetBucket(uint64_t value);
+	static uint64_t GetBucketUpperBound(size_t bucket);
+
+	uint64_t m_counts[s_buckets] = {};
+	uint64_t m_count = 0;
+	uint64_t m_sum = 0;
+	uint64_t m_max = 0;
+};
+
+/*
+	StatementProfiler class collects the cost of every evaluated statement:
+	parse and evaluation latency, heap allocations and Expression nodes created
+*/
+class StatementProfiler
+{
+public:
+	struct StatementProfile
+	{
+		uint64_t m_parseNanoseconds = 0;
+		uint64_t m_evaluateNanoseconds = 0;
+		uint64_t m_allocations = 0;
+		uint64_t m_expressions = 0;
+	};
+
+	void Clear();
+	void Record(const StatementProfile &profile);
+
+	const std::vector<StatementProfile>& GetStatements() const { return m_statements; }
+	const LogHistogram& GetParseLatency() const { return m_parseLatency; }
+	const LogHistogram& GetEvaluateLatency() const { return m_evaluateLatency; }
+	const LogHistogram& GetAllocations() const { return m_allocations; }
+	const LogHistogram& GetExpressions() const { return m_expressions; }
+
+	void WriteText(std::ostream &out) const;
+	void WriteJson(std::ostream &out) const;
+
+private:
+	std::vector<StatementProfile> m_statements;
+	LogHistogram m_parseLatency;
+	LogHistogram m_evaluateLatency;
+	LogHistogram m_allocations;
+	LogHistogram m_expressions;
+};
@@ -0,0 +1,366 @@
+#include "SyntaxChecker.h"
+#include "CharacterScanner.h"
+#include "Parser.h"
+
+#include <algorithm>
+#include <charconv>
+
+SyntaxChecker::SyntaxChecker()
+{
+}
+
+bool
+SyntaxChecker::Check(const std::string &statement)
+{
+	m_text = statement.data();
+	m_length = statement.size();
+	m_position = 0;
+	m_definition = false;
+	m_loopVariables.clear();
+	m_errorPosition = 0;
+	m_expected = 0;
+	return ReadStatement(0, true);
+}
+
+std::string
+SyntaxChecker::DescribeExpected(uint32_t expected)
+{
+	struct TokenText
+	{
+		uint32_t m_token;
+		const char *m_text;
+	};
+	static const TokenText s_texts[] = {
+		{s_number, "a number"}, {s_name, "a name"}, {s_definedVariable, "a defined variable"}, {s_operator, "an operator"},
+		{s_openParenthesis, "'('"}, {s_closeParenthesis, "')'"}, {s_comma, "','"},
+		{s_in, "'in'"}, {s_range, "'..'"}, {s_colon, "':'"}, {s_semicolon, "';'"}, {s_closeBrace, "'}'"},
+		{s_increment, "'++'"}, {s_increment, "'--'"}, {s_end, "the end of the statement"}
+	};
+
+	std::vector<const char*> texts;
+	for (const TokenText &text : s_texts)
+		if (expected & text.m_token)
+			texts.push_back(text.m_text);
+
+	std::string description;
+	for (size_t i = 0; i < texts.size(); ++i)
+	{
+		if (i)
+			description += i + 1 == texts.size() ? " or " : ", ";
+		description += texts[i];
+	}
+	return description;
+}
+
+bool
+SyntaxChecker::ReadStatement(size_t depth, bool definition)
+{
+	//Definition, Loop, Assignment and compound assignment all start with a name
+	size_t begin = SkipSpaces(m_position);
+	size_t nameEnd = SkipName(begin);
+	if (nameEnd != begin)
+	{
+		std::string_view name(m_text + begin, nameEnd - begin);
+		size_t next = SkipSpaces(nameEnd), body;
+		if (definition && Peek(next) == '(' && !m_parser->GetFunction(std::string(name)) &&
+			!m_parser->GetBinaryFunction(std::string(name)) && IsDefinition(next + 1, body))
+			return ReadDefinition(body);
+		if (name == "for" && SkipName(next) != next)
+		{
+			m_position = next;
+			return ReadLoop(depth);
+		}
+
+		bool assignment = Peek(next) == '=';
+		bool compound = !assignment && Peek(next + 1) == '=' && std::string_view("+-*/^%").find(Peek(next)) != std::string_view::npos &&
+			IsRequired(name);
+		if (assignment || compound)
+		{
+			m_position = next + (assignment ? 1 : 2);
+			if (!ReadSum() || !ReadStatementEnd(depth, s_operator))
+				return false;
+			if (depth)
+				m_loopVariables.push_back(name);
+			return true;
+		}
+	}
+
+	m_position = begin;
+	return ReadSum() && ReadStatementEnd(depth, s_operator);
+}
+
+bool
+SyntaxChecker::ReadDefinition(size_t body)
+{
+	m_position = body;
+	m_definition = true;
+	bool read = ReadSum();
+	m_definition = false;
+	return read && (m_position == m_length || Fail(m_position, s_operator | s_end));
+}
+
+bool
+SyntaxChecker::ReadLoop(size_t depth)
+{
+	//Loop -> 'for' Variable 'in' Sum '..' Sum ':' Body, read from Variable
+	size_t varEnd = SkipName(m_position);
+	std::string_view var(m_text + m_position, varEnd - m_position);
+	size_t in = SkipSpaces(varEnd), inEnd = SkipName(in);
+	if (std::string_view(m_text + in, inEnd - in) != "in")
+		return Fail(in, s_in);
+
+	m_position = inEnd;
+	if (!ReadSum())
+		return false;
+	if (Peek(m_position) != '.' || Peek(m_position + 1) != '.')
+		return Fail(m_position, s_operator | s_range);
+	m_position += 2;
+	if (!ReadSum())
+		return false;
+	if (Peek(m_position) != ':')
+		return Fail(m_position, s_operator | s_colon);
+	++m_position;
+
+	size_t loopVariables = m_loopVariables.size();
+	m_loopVariables.push_back(var);
+	size_t begin = SkipSpaces(m_position);
+	bool block = Peek(begin) == '{';
+	if (block)
+		m_position = begin + 1;
+	bool read;
+	while ((read = ReadStatement(depth + 1, false)) && block)
+	{
+		size_t next = SkipSpaces(m_position);
+		m_position = next + 1;
+		if (Peek(next) == ';')
+			continue;
+		if (Peek(next) != '}')
+			read = Fail(next, s_semicolon | s_closeBrace);
+		break;
+	}
+	m_loopVariables.resize(loopVariables);
+	return read && ReadStatementEnd(depth, 0);
+}
+
+bool
+SyntaxChecker::ReadSum()
+{
+	if (!ReadProduct())
+		return false;
+	for (;;)
+	{
+		m_position = SkipSpaces(m_position);
+		char op = Peek(m_position);
+		if (op != '+' && op != '-')
+			return true;
+		++m_position;
+		if (!ReadProduct())
+			return false;
+	}
+}
+
+bool
+SyntaxChecker::ReadProduct()
+{
+	if (!ReadFactor())
+		return false;
+	for (;;)
+	{
+		m_position = SkipSpaces(m_position);
+		char op = Peek(m_position);
+		if (op != '*' && op != '/' && op != '%')
+			return true;
+		++m_position;
+		if (!ReadFactor())
+			return false;
+	}
+}
+
+bool
+SyntaxChecker::ReadFactor()
+{
+	//Power -> Term '^' Factor is committed to once '^' is read
+	if (!ReadTerm())
+		return false;
+	size_t next = SkipSpaces(m_position);
+	if (Peek(next) != '^')
+		return true;
+	m_position = next + 1;
+	return ReadFactor();
+}
+
+bool
+SyntaxChecker::ReadTerm()
+{
+	size_t begin = SkipSpaces(m_position);
+	if (Peek(begin) == '(')
+	{
+		m_position = begin + 1;
+		if (!ReadSum())
+			return false;
+		if (Peek(m_position) != ')')
+			return Fail(m_position, s_operator | s_closeParenthesis);
+		++m_position;
+		return true;
+	}
+
+	//++ and -- are not allowed in a function body
+	if (!m_definition && IsIncrement(begin))
+	{
+		size_t var = SkipSpaces(begin + 2), varEnd = SkipName(var);
+		if (varEnd == var || !IsRequired(std::string_view(m_text + var, varEnd - var)))
+			return Fail(var, s_definedVariable);
+		m_position = varEnd;
+		return true;
+	}
+
+	size_t nameEnd = SkipName(begin);
+	if (nameEnd != begin)
+	{
+		std::string_view name(m_text + begin, nameEnd - begin);
+		size_t next = SkipSpaces(nameEnd);
+		if (!m_definition && IsIncrement(next) && IsRequired(name))
+		{
+			m_position = next + 2;
+			return true;
+		}
+		//a name which is not a function or is not called is a parameter or a variable
+		size_t arity = Peek(next) == '(' ? GetArity(name) : 0;
+		if (!arity)
+		{
+			m_position = nameEnd;
+			return true;
+		}
+		m_position = next + 1;
+		return ReadCall(arity);
+	}
+
+	if (CharacterScanner::IsDigit(Peek(begin)))
+	{
+		m_position = SkipNumber(begin);
+		return true;
+	}
+	return Fail(begin, s_number | s_name | s_openParenthesis | (m_definition ? 0 : s_increment));
+}
+
+bool
+SyntaxChecker::ReadCall(size_t arguments)
+{
+	for (size_t argument = 1; ; ++argument)
+	{
+		if (!ReadSum())
+			return false;
+		char next = Peek(m_position);
+		++m_position;
+		if (next == ',' && argument < arguments)
+			continue;
+		if (next == ')' && argument == arguments)
+			return true;
+		return Fail(m_position - 1, s_operator | (argument < arguments ? s_comma : s_closeParenthesis));
+	}
+}
+
+bool
+SyntaxChecker::ReadStatementEnd(size_t depth, uint32_t expected)
+{
+	if (m_position == m_length)
+		return true;
+	if (depth)
+	{
+		char next = Peek(SkipSpaces(m_position));
+		if (next == ';' || next == '}')
+			return true;
+	}
+	return Fail(m_position, expected | s_end | (depth ? s_semicolon | s_closeBrace : 0));
+}
+
+bool
+SyntaxChecker::IsDefinition(size_t position, size_t &body) const
+{
+	//parameters are distinct names
+	std::vector<std::string_view> parameters;
+	for (;;)
+	{
+		size_t begin = SkipSpaces(position), end = SkipName(begin);
+		std::string_view parameter(m_text + begin, end - begin);
+		if (end == begin || std::find(parameters.begin(), parameters.end(), parameter) != parameters.end())
+			return false;
+		parameters.push_back(parameter);
+		position = SkipSpaces(end);
+		if (Peek(position) != ',')
+			break;
+		++position;
+	}
+	if (Peek(position) != ')')
+		return false;
+	position = SkipSpaces(position + 1);
+	if (Peek(position) != '=')
+		return false;
+	body = position + 1;
+	return true;
+}
+
+bool
+SyntaxChecker::IsRequired(std::string_view var) const
+{
+	return std::find(m_loopVariables.begin(), m_loopVariables.end(), var) != m_loopVariables.end() ||
+		m_parser->HasVariable(std::string(var));
+}
+
+size_t
+SyntaxChecker::GetArity(std::string_view name) const
+{
+	std::string function(name);
+	if (m_parser->GetFunction(function))
+		return 1;
+	if (m_parser->GetBinaryFunction(function))
+		return 2;
+	UserFunctionPtr userFunction = m_parser->GetUserFunction(function);
+	return userFunction ? userFunction->m_parameters.size() : 0;
+}
+
+bool
+SyntaxChecker::Fail(size_t position, uint32_t expected)
+{
+	m_errorPosition = position;
+	m_expected = expected;
+	return false;
+}
+
+size_t
+SyntaxChecker::SkipSpaces(size_t position) const
+{
+	return CharacterScanner::SkipSpaces(m_text, position, m_length);
+}
+
+size_t
+SyntaxChecker::SkipName(size_t position) const
+{
+	if (!CharacterScanner::IsAlpha(Peek(position)))
+		return position;
+	return CharacterScanner::SkipAlphanumerics(m_text, position + 1, m_length);
+}
+
+size_t
+SyntaxChecker::SkipNumber(size_t position) const
+{
+	//the end Tokenizer::EvaluateNumber reads to
+	size_t end = CharacterScanner::SkipDigits(m_text, position, m_length);
+	char next = Peek(end);
+	if (end - position > 15 || next == '.' || next == 'e' || next == 'E')
+	{
+		double x;
+		end = std::from_chars(m_text + position, m_text + m_length, x).ptr - m_text;
+	}
+	//the dot of a range, e.g. 0..n, does not belong to the number
+	if (m_text[end - 1] == '.' && Peek(end) == '.')
+		--end;
+	return end;
+}
+
+bool
+SyntaxChecker::IsIncrement(size_t position) const
+{
+	char c = Peek(position);
+	return (c == '+' || c == '-') && Peek(position + 1) == c;
+}
@@ -0,0 +1,92 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+class Parser;
+
+/*
+	SyntaxChecker class reads a statement once, from left to right, without building it, and stops
+	at its first unexpected token with the tokens which could have been there, e.g. for
+	"v = 1 + 2 * - 3" at position 12, expecting a number, a name, '(', '++' or '--'.
+
+	It reads the grammar of the Parser predictively: the first tokens of a statement choose its
+	rule, e.g. a name followed by '=' is an Assignment, and a rule is never read again another
+	way. The variables and the functions known to the parser decide the rules which depend on
+	them: ++ and -- need a defined variable, a compound assignment too, and the number of
+	arguments of a call is the one of its function. Parser::CompileStatement reads a statement
+	the checker accepts, so a malformed statement is reported without trying every alternative
+*/
+class SyntaxChecker
+{
+public:
+	//Tokens a statement may go on with, combined in the expected set of an error
+	static const uint32_t s_number = 1 << 0;
+	static const uint32_t s_name = 1 << 1;
+	static const uint32_t s_definedVariable = 1 << 2;
+	static const uint32_t s_openParenthesis = 1 << 3;
+	static const uint32_t s_closeParenthesis = 1 << 4;
+	static const uint32_t s_comma = 1 << 5;
+	static const uint32_t s_operator = 1 << 6;
+	static const uint32_t s_in = 1 << 7;
+	static const uint32_t s_range = 1 << 8;
+	static const uint32_t s_colon = 1 << 9;
+	static const uint32_t s_semicolon = 1 << 10;
+	static const uint32_t s_closeBrace = 1 << 11;
+	static const uint32_t s_increment = 1 << 12;
+	static const uint32_t s_end = 1 << 13;
+
+	SyntaxChecker();
+	void SetParser(const Parser *parser) { m_parser = parser; }
+
+	//Whether the parser would read statement, otherwise see GetPosition and GetExpected
+	bool Check(const std::string &statement);
+	//Position of the first unexpected token of the last statement checked
+	size_t GetPosition() const { return m_errorPosition; }
+	//Tokens expected at that position, a combination of the s_ tokens
+	uint32_t GetExpected() const { return m_expected; }
+
+	//Text of the expected tokens, e.g. "a number, a name or '('"
+	static std::string DescribeExpected(uint32_t expected);
+
+private:
+	//Read a rule from m_position, which is left after it. False at the first unexpected token
+	bool ReadStatement(size_t depth, bool definition);
+	bool ReadDefinition(size_t body);
+	bool ReadLoop(size_t depth);
+	bool ReadSum();
+	bool ReadProduct();
+	bool ReadFactor();
+	bool ReadTerm();
+	bool ReadCall(size_t arguments);
+	//Whether a statement in depth loops ends at m_position, in a loop body also before ';' or '}'.
+	//expected are the tokens which could have gone on with the statement
+	bool ReadStatementEnd(size_t depth, uint32_t expected);
+	//Whether '(' Variable (',' Variable)* ')' '=' starts at position, body is set after it
+	bool IsDefinition(size_t position, size_t &body) const;
+	//Whether var is defined or assigned before in the loops being read
+	bool IsRequired(std::string_view var) const;
+	//Number of arguments of a function by name, 0 if it is not one
+	size_t GetArity(std::string_view name) const;
+
+	bool Fail(size_t position, uint32_t expected);
+	size_t SkipSpaces(size_t position) const;
+	//End of the name starting at position, position if there is none
+	size_t SkipName(size_t position) const;
+	size_t SkipNumber(size_t position) const;
+	bool IsIncrement(size_t position) const;
+	char Peek(size_t position) const { return position < m_length ? m_text[position] : '\0'; }
+
+	const Parser *m_parser = nullptr;
+	const char *m_text = nullptr;
+	size_t m_length = 0;
+	size_t m_position = 0;
+	//Whether a function body is being read, where ++ and -- are not allowed
+	bool m_definition = false;
+	//Loop variables and variables assigned by the loops being read so far
+	std::vector<std::string_view> m_loopVariables;
+	size_t m_errorPosition = 0;
+	uint32_t m_expected = 0;
+};
@@ -1,8 +1,13 @@
 #include "Tokenizer.h"
 #include "Expression.h"
 #include "Parser.h"
+#include "CharacterScanner.h"
 
-#include <cctype>
+#include <charconv>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <limits>
 
 Tokenizer::Tokenizer() 
 {
@@ -12,6 +17,7 @@ void
 Tokenizer::SetStatement(const std::string &statement)
 {
 	m_strstrm.str(statement);
+	m_statement = statement;
 	m_length = statement.length();
 	SetCurrenPosition(0);
 }
@@ -19,13 +25,41 @@ Tokenizer::SetStatement(const std::string &statement)
 std::shared_ptr<NumberExpression> 
 Tokenizer::EvaluateNumber()
 {
+	PARSER_RULE_SCOPE(m_statistics, GrammarRule::Number);
 	SkipWhiteSpaces();
 	NumberExpressionPtr numExp;
 	char curChar = m_strstrm.peek();
-	if (std::isdigit(curChar)) 
+	if (CharacterScanner::IsDigit(curChar))
 	{
+		const char *text = m_statement.data();
+		size_t begin = GetCurrentPosition();
+		size_t end = CharacterScanner::SkipDigits(text, begin, m_length);
 		double x(0.0);
-		m_strstrm >> x;
+		if (end - begin <= 15 && (end == static_cast<size_t>(m_length) || (text[end] != '.' && text[end] != 'e' && text[end] != 'E')))
+		{
+			//an integer of up to 15 digits is exact in a double
+			int64_t integer = 0;
+			for (size_t i = begin; i < end; ++i)
+				integer = integer * 10 + (text[i] - '0');
+			x = static_cast<double>(integer);
+		}
+		else
+		{
+			std::from_chars_result result = std::from_chars(text + begin, text + m_length, x);
+			end = result.ptr - text;
+			//x is left unchanged out of range, a stream read gives the largest double above it and
+			//the nearest subnormal or 0 below it, as strtod does
+			if (result.ec == std::errc::result_out_of_range)
+			{
+				x = std::strtod(std::string(text + begin, result.ptr).c_str(), nullptr);
+				if (std::isinf(x))
+					x = std::numeric_limits<double>::max();
+			}
+		}
+		//the dot of a range, e.g. 0..n, does not belong to the number
+		if (text[end - 1] == '.' && static_cast<int>(end) < m_length && text[end] == '.')
+			--end;
+		m_strstrm.seekg(end);
 		numExp = std::make_shared<NumberExpression>(x);
 	}
 	return numExp;
@@ -34,18 +68,9 @@ Tokenizer::EvaluateNumber()
 std::shared_ptr<VariableExpression> 
 Tokenizer::EvalutateVariable() 
 {
-	SkipWhiteSpaces();
+	PARSER_RULE_SCOPE(m_statistics, GrammarRule::Variable);
 	VariableExpressionPtr valExp;
-	char curChar = m_strstrm.peek();
-	std::string s;
-	bool bFirstChar=true;
-	while (std::isalpha(curChar) || (!bFirstChar && !isspace(curChar) && isalnum(curChar)))  //todo: what about underscore?
-	{
-		bFirstChar = false;
-		curChar = m_strstrm.get();
-		s += curChar;
-		curChar = m_strstrm.peek();
-	}
+	std::string s(EvaluateName());
 	if (s.length() > 0)
 	{
 		valExp = std::make_shared<VariableExpression>(m_parser, s);	
@@ -54,9 +79,26 @@ Tokenizer::EvalutateVariable()
 	return valExp;
 }
 
+std::string
+Tokenizer::EvaluateName()
+{
+	SkipWhiteSpaces();
+	std::string s;
+	if (CharacterScanner::IsAlpha(m_strstrm.peek()))
+	{
+		size_t begin = GetCurrentPosition();
+		size_t end = CharacterScanner::SkipAlphanumerics(m_statement.data(), begin + 1, m_length);
+		s.assign(m_statement, begin, end - begin);
+		m_strstrm.seekg(end);
+	}
+
+	return s;
+}
+
 ExpressionPtr 
 Tokenizer::EvaluatePrefixFunction()
 {
+	PARSER_RULE_SCOPE(m_statistics, GrammarRule::PrefixFunction);
 	int curPos = GetCurrentPosition();
 	SkipWhiteSpaces();
 	ExpressionPtr exp;
@@ -66,10 +108,7 @@ Tokenizer::EvaluatePrefixFunction()
 		std::string var_name(GetCurrentVariableName());
 		if (!var_name.empty())
 		{
-			double addedValue = prefix == "++" ? 1 : -1;
-			double varValue = m_parser->LookupVariable(var_name);
-			m_parser->RecordVariable(var_name, varValue + addedValue);
-			exp = std::make_shared<NumberExpression>(varValue + addedValue);
+			exp = std::make_shared<IncrementExpression>(m_parser, var_name, prefix == "++" ? 1 : -1, true);
 			curPos = GetCurrentPosition();
 		}
 	}
@@ -83,6 +122,7 @@ Tokenizer::EvaluatePrefixFunction()
 ExpressionPtr 
 Tokenizer::EvaluatePostfixFunction()
 {
+	PARSER_RULE_SCOPE(m_statistics, GrammarRule::PostfixFunction);
 	int curPos = GetCurrentPosition();
 	SkipWhiteSpaces();
 	ExpressionPtr exp;
@@ -92,10 +132,7 @@ Tokenizer::EvaluatePostfixFunction()
 		std::string postfix = GetPostPreFixType();
 		if (!postfix.empty())
 		{
-			double addedValue = postfix == "++" ? 1 : -1;
-			double varValue = m_parser->LookupVariable(var_name);
-			m_parser->RecordVariable(var_name, varValue + addedValue);
-			exp = std::make_shared<NumberExpression>(varValue);
+			exp = std::make_shared<IncrementExpression>(m_parser, var_name, postfix == "++" ? 1 : -1, false);
 			curPos = GetCurrentPosition();
 		}
 	}
@@ -108,6 +145,7 @@ Tokenizer::EvaluatePostfixFunction()
 bool
 Tokenizer::EvaluateCharacter(char expected)
 {
+	PARSER_RULE_SCOPE(m_statistics, GrammarRule::Character);
 	SkipWhiteSpaces();
 	bool expectedChar = false;
 	char ch = m_strstrm.peek();
@@ -123,16 +161,17 @@ Tokenizer::EvaluateCharacter(char expected)
 bool 
 Tokenizer::EvaluateCharacters(const std::string &expected) 
 {
+	PARSER_RULE_SCOPE(m_statistics, GrammarRule::Characters);
 	int curPos = GetCurrentPosition();
 	SkipWhiteSpaces();
 	
 	bool expectedChars = false;
 	if (!ReachedEnd())
 	{
-		std::string s = m_strstrm.str().substr(GetCurrentPosition());
-		if (s.find(expected) == 0)
+		int pos = GetCurrentPosition();
+		if (m_statement.compare(pos, expected.length(), expected) == 0)
 		{
-			m_strstrm.seekg(GetCurrentPosition() + expected.length());
+			m_strstrm.seekg(pos + expected.length());
 			expectedChars = true;
 		}
 	}
@@ -145,18 +184,23 @@ Tokenizer::EvaluateCharacters(const std::string &expected)
 int 
 Tokenizer::GetCurrentPosition() 
 {
+	//tellg fails once the end of the statement was read
+	if (m_strstrm.eof())
+		return m_length;
 	return m_strstrm.tellg();
 }
 
 bool 
-Tokenizer::ReachedEnd() const
+Tokenizer::ReachedEnd()
 {
-	return m_strstrm.eof();
+	//the end flag is only set by a read past the last character
+	return m_strstrm.peek() == std::char_traits<char>::eof();
 }
 
 void 
 Tokenizer::SetCurrenPosition(int curPos) 
 {
+	PARSER_COUNT_REWIND(m_statistics, GetCurrentPosition(), curPos);
 	m_strstrm.clear();
 	m_strstrm.seekg(std::min(m_length, curPos));
 }
@@ -164,26 +208,23 @@ Tokenizer::SetCurrenPosition(int curPos)
 void 
 Tokenizer::SkipWhiteSpaces() 
 {
-	char curChar = m_strstrm.peek();
-	while (isspace(curChar)) {
-		curChar = m_strstrm.get();
-		curChar = m_strstrm.peek();
-	}
+	//most tokens follow each other without spaces
+	if (!CharacterScanner::IsSpace(m_strstrm.peek()))
+		return;
+	m_strstrm.seekg(CharacterScanner::SkipSpaces(m_statement.data(), GetCurrentPosition(), m_length));
 }
 
+
 std::string 
 Tokenizer::GetCurrentVariableName()
 {
+	int curPos = GetCurrentPosition();
 	std::string var_name;
-	std::vector<std::string> names(m_parser->GetVariableNames());
-	for (std::string &name : names)
-	{
-		if (EvaluateCharacters(name))
-		{
-			var_name = std::move(name);
-			break;
-		}
-	}
+	std::string name(EvaluateName());
+	if (!name.empty() && m_parser->RequireVariable(name))
+		var_name = std::move(name);
+	else
+		SetCurrenPosition(curPos);
 
 	return var_name;
 }
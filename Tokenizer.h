@@ -1,4 +1,5 @@
 #pragma once
+#include "ParseStatistics.h"
 #include <sstream>
 #include <memory>
 #include <vector>
@@ -16,6 +17,10 @@ public:
 	Tokenizer();
 	void SetParser(Parser *parser) { m_parser = parser;}
 
+	//Counters updated when built with PARSER_INSTRUMENTATION, may be null
+	void SetStatistics(ParseStatistics *statistics) { m_statistics = statistics; }
+	ParseStatistics* GetStatistics() const { return m_statistics; }
+
 	//Set the statement to evaluate
 	void SetStatement(const std::string &statement);
 
@@ -25,6 +30,9 @@ public:
 	//Evaluate a variable from an expression, e.g. "x123"
 	std::shared_ptr<VariableExpression> EvalutateVariable();
 
+	//Evaluate a variable or function name from an expression, empty if there is none
+	std::string EvaluateName();
+
 	//Evaluate a prefix from an expression, e.g. "++i"
 	std::shared_ptr<Expression> EvaluatePrefixFunction();
 
@@ -38,7 +46,7 @@ public:
 	bool EvaluateCharacters(const std::string &expected);
 
 	//Flag wheter we've read the whole statement
-	bool ReachedEnd() const;
+	bool ReachedEnd();
 
 	//Get the current position of what was being read from the statement
 	int GetCurrentPosition();
@@ -47,12 +55,15 @@ public:
 	void SetCurrenPosition(int mark);
 private:
 	std::stringstream m_strstrm;
+	//Copy of the statement for comparisons in place, m_strstrm.str() returns a copy
+	std::string m_statement;
 	int m_length = -1;
 	Parser* m_parser = nullptr;
+	ParseStatistics* m_statistics = nullptr;
 
 	void SkipWhiteSpaces();
 
-	//Get the variable expression (if any) is in the current position
+	//Get the name of the defined variable (if any) in the current position
 	std::string GetCurrentVariableName();
 
 	//Get the current expression is prefix or postfix is in the current position
@@ -0,0 +1,129 @@
+#include "VariableSnapshot.h"
+#include "Parser.h"
+
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <vector>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#define VARIABLE_SNAPSHOT_MMAP
+#endif
+
+static const char s_magic[8] = {'E', 'X', 'P', 'R', 'S', 'N', 'A', 'P'};
+static const size_t s_headerSize = sizeof(s_magic) + 2 * sizeof(uint32_t);
+
+bool
+VariableSnapshot::Save(const Parser &parser, const std::string &path)
+{
+	const std::vector<size_t> &order = parser.GetVariableOrder();
+	uint32_t version = s_version;
+	uint32_t count = static_cast<uint32_t>(order.size());
+
+	std::vector<double> values;
+	values.reserve(order.size());
+	for (size_t slot : order)
+		values.push_back(parser.LookupVariable(slot));
+
+	std::string buffer(s_magic, sizeof(s_magic));
+	buffer.append(reinterpret_cast<const char*>(&version), sizeof(version));
+	buffer.append(reinterpret_cast<const char*>(&count), sizeof(count));
+	buffer.append(reinterpret_cast<const char*>(values.data()), values.size() * sizeof(double));
+	for (size_t slot : order)
+	{
+		const std::string &name = parser.GetVariableName(slot);
+		uint32_t length = static_cast<uint32_t>(name.size());
+		buffer.append(reinterpret_cast<const char*>(&length), sizeof(length));
+		buffer += name;
+	}
+
+	std::ofstream file(path, std::ios::binary | std::ios::trunc);
+	file.write(buffer.data(), buffer.size());
+	return static_cast<bool>(file.flush());
+}
+
+bool
+VariableSnapshot::Restore(Parser &parser, const char *data, size_t size)
+{
+	uint32_t version = 0, count = 0;
+	if (size < s_headerSize || std::memcmp(data, s_magic, sizeof(s_magic)) != 0)
+		return false;
+	std::memcpy(&version, data + sizeof(s_magic), sizeof(version));
+	std::memcpy(&count, data + sizeof(s_magic) + sizeof(version), sizeof(count));
+	if (version != s_version || (size - s_headerSize) / sizeof(double) < count)
+		return false;
+
+	//check every name fits before changing the parser
+	const char *values = data + s_headerSize;
+	const char *names = values + count * sizeof(double);
+	const char *end = data + size;
+	const char *name = names;
+	for (uint32_t i = 0; i < count; ++i)
+	{
+		uint32_t length = 0;
+		if (static_cast<size_t>(end - name) < sizeof(length))
+			return false;
+		std::memcpy(&length, name, sizeof(length));
+		name += sizeof(length);
+		if (static_cast<size_t>(end - name) < length)
+			return false;
+		name += length;
+	}
+
+	name = names;
+	for (uint32_t i = 0; i < count; ++i)
+	{
+		uint32_t length = 0;
+		double value = 0;
+		std::memcpy(&length, name, sizeof(length));
+		std::memcpy(&value, values + i * sizeof(double), sizeof(value));
+		name += sizeof(length);
+		parser.RecordVariable(std::string(name, length), value);
+		name += length;
+	}
+	return true;
+}
+
+#ifdef VARIABLE_SNAPSHOT_MMAP
+
+bool
+VariableSnapshot::Restore(Parser &parser, const std::string &path)
+{
+	int fd = ::open(path.c_str(), O_RDONLY);
+	if (fd < 0)
+		return false;
+	struct stat status;
+	if (::fstat(fd, &status) != 0 || status.st_size == 0)
+	{
+		::close(fd);
+		return false;
+	}
+
+	size_t size = static_cast<size_t>(status.st_size);
+	void *mapped = ::mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+	::close(fd);
+	if (mapped == MAP_FAILED)
+		return false;
+	bool restored = Restore(parser, static_cast<const char*>(mapped), size);
+	::munmap(mapped, size);
+	return restored;
+}
+
+#else
+
+bool
+VariableSnapshot::Restore(Parser &parser, const std::string &path)
+{
+	std::ifstream file(path, std::ios::binary);
+	if (!file)
+		return false;
+	std::vector<char> data((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+	return !data.empty() && Restore(parser, data.data(), data.size());
+}
+
+#endif
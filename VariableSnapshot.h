@@ -0,0 +1,29 @@
+#pragma once
+#include <string>
+
+class Parser;
+
+/*
+	VariableSnapshot class saves the variables of a Parser to a binary file and restores them
+	without reading any statement
+
+	The file holds, in the byte order of the machine which wrote it:
+	"EXPRSNAP", the format version and the number of variables as 4 bytes each,
+	the values as 8 bytes doubles, then every name as its 4 bytes length and its characters.
+	Variables are stored by the order of creation, which a restore keeps.
+*/
+class VariableSnapshot
+{
+public:
+	static const unsigned int s_version = 1;
+
+	//False if the file could not be written
+	static bool Save(const Parser &parser, const std::string &path);
+
+	//Record the variables of the file in parser, which keeps its other variables.
+	//False and parser unchanged if the file could not be read or is not a snapshot
+	static bool Restore(Parser &parser, const std::string &path);
+
+	//Restore from a snapshot already in memory
+	static bool Restore(Parser &parser, const char *data, size_t size);
+};
@@ -0,0 +1,109 @@
+#include "VersionedEnvironment.h"
+
+#include <algorithm>
+
+VersionedEnvironment::VersionedEnvironment(const Parser &parser)
+	: m_parser(&parser)
+	, m_sharedOrder(std::make_shared<const std::vector<size_t>>(parser.GetVariableOrder()))
+{
+	Reserve(parser.GetSlotCount());
+	for (size_t slot = 0; slot < parser.GetSlotCount(); ++slot)
+	{
+		Page &page = GetPage(slot / s_pageSize);
+		page.m_values[slot % s_pageSize] = parser.LookupVariable(slot);
+		page.m_defined[slot % s_pageSize] = parser.IsVariableDefined(slot);
+	}
+}
+
+VersionedEnvironment
+VersionedEnvironment::Fork()
+{
+	if (!m_order.empty())
+	{
+		std::vector<size_t> order(*m_sharedOrder);
+		order.insert(order.end(), m_order.begin(), m_order.end());
+		m_sharedOrder = std::make_shared<const std::vector<size_t>>(std::move(order));
+		m_order.clear();
+	}
+	std::fill(m_owned.begin(), m_owned.end(), false);
+
+	VersionedEnvironment fork(*this);
+	fork.m_stack.clear();
+	fork.m_errors.clear();
+	return fork;
+}
+
+void
+VersionedEnvironment::Reserve(size_t slots)
+{
+	//the new pages are all the same empty page until written
+	static const std::shared_ptr<Page> s_empty = std::make_shared<Page>();
+	size_t pages = (slots + s_pageSize - 1) / s_pageSize;
+	if (pages > m_pages.size())
+	{
+		m_pages.resize(pages, s_empty);
+		m_owned.resize(pages, false);
+	}
+}
+
+void
+VersionedEnvironment::Run(const std::vector<CompiledExpression> &statements)
+{
+	m_errors.clear();
+	for (m_currentStatement = 0; m_currentStatement < statements.size(); ++m_currentStatement)
+		statements[m_currentStatement].Evaluate<double>(*this, m_stack);
+}
+
+double
+VersionedEnvironment::LookupVariable(const std::string& var) const
+{
+	size_t slot(0);
+	return m_parser->FindVariable(var, slot) && slot / s_pageSize < m_pages.size() ? LookupVariable(slot) : 0;
+}
+
+bool
+VersionedEnvironment::HasVariable(const std::string& var) const
+{
+	size_t slot(0);
+	return m_parser->FindVariable(var, slot) && slot / s_pageSize < m_pages.size()
+		&& m_pages[slot / s_pageSize]->m_defined[slot % s_pageSize];
+}
+
+std::vector<size_t>
+VersionedEnvironment::GetVariableOrder() const
+{
+	std::vector<size_t> order(*m_sharedOrder);
+	order.insert(order.end(), m_order.begin(), m_order.end());
+	return order;
+}
+
+void
+VersionedEnvironment::PrintVariables(std::ostream &out) const
+{
+	out << "(";
+	bool first = true;
+	for (size_t slot : GetVariableOrder())
+	{
+		if (first)
+			first = false;
+		else
+			out << ",";
+		out << m_parser->GetVariableName(slot) << "=" << LookupVariable(slot);
+	}
+	out << ")" << std::endl;
+}
+
+size_t
+VersionedEnvironment::GetCopiedPages() const
+{
+	return std::count(m_owned.begin(), m_owned.end(), true);
+}
+
+void
+VersionedEnvironment::ReportError(ErrorCode code, int position)
+{
+	//only the first error of a statement is kept
+	if (!m_errors.empty() && m_errors.back().m_statement == m_currentStatement)
+		return;
+	m_errors.push_back(Parser::StatementError(code, m_currentStatement, position));
+}
@@ -0,0 +1,103 @@
+#pragma once
+#include "CompiledExpression.h"
+#include "ErrorCode.h"
+#include "Parser.h"
+
+#include <cstddef>
+#include <memory>
+#include <ostream>
+#include <string>
+#include <vector>
+
+/*
+	VersionedEnvironment class holds the variables of a Parser by slot as a version which can
+	be forked. A fork shares the variables of its origin by pages of s_pageSize slots and copies
+	a page only when it first writes to it, so forking costs a pointer per page whatever the
+	values, and a version only pays for the variables it changes.
+	A shared page is never written, so versions forked from each other may be evaluated on
+	different threads. A version belongs to a single thread at a time and is forked from one
+*/
+class VersionedEnvironment
+{
+public:
+	static const size_t s_pageSize = 64;
+
+	//The variables the parser holds
+	explicit VersionedEnvironment(const Parser &parser);
+	VersionedEnvironment(VersionedEnvironment &&) = default;
+	VersionedEnvironment& operator=(VersionedEnvironment &&) = default;
+
+	//A new version with the variables of this one, their pages become shared by both
+	VersionedEnvironment Fork();
+
+	//Make room for the slots the parser created after this version, undefined and 0
+	void Reserve(size_t slots);
+
+	//Evaluate the statements in order, the errors are reported by their index
+	void Run(const std::vector<CompiledExpression> &statements);
+
+	double LookupVariable(const std::string& var) const;
+	bool HasVariable(const std::string& var) const;
+	//Slots of the defined variables by the order of creation
+	std::vector<size_t> GetVariableOrder() const;
+
+	//Print variables in the format of Parser::PrintVariables
+	void PrintVariables(std::ostream &out) const;
+
+	//Errors of the last run, at most one per statement, by statement order
+	const std::vector<Parser::StatementError>& GetErrors() const { return m_errors; }
+
+	//Pages this version copied since it was forked or last forked from
+	size_t GetCopiedPages() const;
+	size_t GetPageCount() const { return m_pages.size(); }
+
+	double LookupVariable(size_t slot) const { return m_pages[slot / s_pageSize]->m_values[slot % s_pageSize]; }
+	void RecordVariable(size_t slot, double value)
+	{
+		Page &page = GetPage(slot / s_pageSize);
+		page.m_values[slot % s_pageSize] = value;
+		if (!page.m_defined[slot % s_pageSize])
+		{
+			page.m_defined[slot % s_pageSize] = true;
+			m_order.push_back(slot);
+		}
+	}
+	void ReportError(ErrorCode code, int position);
+
+private:
+	/*
+		Page utility class to hold the variables of s_pageSize consecutive slots
+	*/
+	struct Page
+	{
+		double m_values[s_pageSize] = {};
+		bool m_defined[s_pageSize] = {};
+	};
+
+	//Only Fork copies, once the pages are marked shared
+	VersionedEnvironment(const VersionedEnvironment &) = default;
+	VersionedEnvironment& operator=(const VersionedEnvironment &) = delete;
+
+	//The page for a write, copied first if it is shared
+	Page& GetPage(size_t page)
+	{
+		if (!m_owned[page])
+		{
+			m_pages[page] = std::make_shared<Page>(*m_pages[page]);
+			m_owned[page] = true;
+		}
+		return *m_pages[page];
+	}
+
+	const Parser *m_parser;
+	std::vector<std::shared_ptr<Page>> m_pages;
+	//Whether the page is only referenced by this version
+	std::vector<char> m_owned;
+	//Order of creation of the defined variables: the shared one of the origin, then the slots
+	//this version defined
+	std::shared_ptr<const std::vector<size_t>> m_sharedOrder;
+	std::vector<size_t> m_order;
+	std::vector<double> m_stack;
+	std::vector<Parser::StatementError> m_errors;
+	size_t m_currentStatement = 0;
+};
@@ -0,0 +1,1212 @@
+#include "benchmarks.h"
+#include "AllocationCounter.h"
+#include "BatchRunner.h"
+#include "BulkEvaluator.h"
+#include "CharacterScanner.h"
+#include "ColumnFile.h"
+#include "CompiledCache.h"
+#include "Differentiator.h"
+#include "CompiledExpression.h"
+#include "Environment.h"
+#include "FunctionCache.h"
+#include "Expression.h"
+#include "LaneEnvironment.h"
+#include "ParallelSumParser.h"
+#include "Parser.h"
+#include "Program.h"
+#include "ScenarioRunner.h"
+#include "Tokenizer.h"
+#include "VariableSnapshot.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace benchmarks;
+
+using Clock = std::chrono::steady_clock;
+
+//Each phase is repeated until it ran at least that long
+static const std::chrono::milliseconds s_minDuration(200);
+static const size_t s_minRepetitions = 3;
+
+//Expressions keep a pointer to the parser which created them
+struct ParsedScript
+{
+	std::unique_ptr<Parser> m_parser;
+	std::vector<ExpressionPtr> m_expressions;
+};
+
+struct ThreadsResult
+{
+	size_t m_threads = 0;
+	size_t m_runs = 0;
+	double m_nanoseconds = 0;
+};
+
+struct PhaseResult
+{
+	size_t m_repetitions = 0;
+	size_t m_statements = 0;
+	size_t m_bytes = 0;
+	size_t m_allocations = 0;
+	double m_nanoseconds = 0;
+};
+
+static double ElapsedNanoseconds(Clock::time_point from, Clock::time_point to)
+{
+	return std::chrono::duration<double, std::nano>(to - from).count();
+}
+
+static bool KeepRunning(const PhaseResult &result, Clock::time_point start)
+{
+	return result.m_repetitions < s_minRepetitions || Clock::now() - start < s_minDuration;
+}
+
+static size_t ScriptBytes(const std::vector<std::string> &statements)
+{
+	size_t bytes(0);
+	for (const std::string &statement : statements)
+		bytes += statement.length();
+	return bytes;
+}
+
+// s=1+2+3+...
+Workload benchmarks::long_sum(size_t terms)
+{
+	std::string statement("s=1");
+	for (size_t i = 2; i <= terms; ++i)
+		statement += "+" + std::to_string(i);
+	return Workload{"long_sum", terms, {statement}};
+}
+
+// x=((((1)+1)+1)+1)
+Workload benchmarks::deep_parentheses(size_t depth)
+{
+	std::string statement("x=" + std::string(depth, '(') + "1");
+	for (size_t i = 0; i < depth; ++i)
+		statement += ")+1";
+	return Workload{"deep_parentheses", depth, {statement}};
+}
+
+// v0=1, v1=v0+1, v2=v1+1...
+Workload benchmarks::many_variables(size_t count)
+{
+	Workload workload{"many_variables", count, {"v0=1"}};
+	for (size_t i = 1; i < count; ++i)
+		workload.m_statements.push_back("v" + std::to_string(i) + "=v" + std::to_string(i - 1) + "+1");
+	return workload;
+}
+
+Workload benchmarks::function_heavy(size_t count)
+{
+	Workload workload{"function_heavy", count, {}};
+	for (size_t i = 0; i < count; ++i)
+	{
+		std::string n(std::to_string(i % 90));
+		workload.m_statements.push_back("f" + std::to_string(i) + "=sin(cos(" + n + "))+floor(" + n + ".5)*tan(atan(0.5))-ceil(asin(0.5))");
+	}
+	return workload;
+}
+
+Workload benchmarks::increments(size_t count)
+{
+	Workload workload{"increments", count, {"i=0", "j=0"}};
+	for (size_t i = 0; i < count; ++i)
+	{
+		workload.m_statements.push_back("i++");
+		workload.m_statements.push_back("++j");
+		workload.m_statements.push_back("k=i-- + --j");
+		workload.m_statements.push_back("i+=j");
+	}
+	return workload;
+}
+
+//X and Y are replaced by the arguments
+static const std::string s_formula("((X*X+2*X)/(1+X*X))^0.5+max(X,Y)*3-atan2(Y,X)");
+
+static std::string ReplaceAll(std::string text, char from, const std::string &to)
+{
+	std::string res;
+	for (char c : text)
+		res += c == from ? to : std::string(1, c);
+	return res;
+}
+
+Workload benchmarks::formula_inline(size_t count)
+{
+	Workload workload{"formula_inline", count, {}};
+	for (size_t i = 0; i < count; ++i)
+	{
+		std::string formula = ReplaceAll(ReplaceAll(s_formula, 'X', std::to_string(i % 50 + 1)), 'Y', "2.5");
+		workload.m_statements.push_back("r" + std::to_string(i) + "=" + formula);
+	}
+	return workload;
+}
+
+Workload benchmarks::formula_functions(size_t count)
+{
+	Workload workload{"formula_functions", count, {"f(x,y)=" + ReplaceAll(ReplaceAll(s_formula, 'X', "x"), 'Y', "y")}};
+	for (size_t i = 0; i < count; ++i)
+		workload.m_statements.push_back("r" + std::to_string(i) + "=f(" + std::to_string(i % 50 + 1) + ",2.5)");
+	return workload;
+}
+
+Workload benchmarks::repeated_statements(size_t count)
+{
+	Workload workload{"repeated_statements", count, {"i=0", "y=1.5", "s=0"}};
+	for (size_t i = 0; i < count; ++i)
+	{
+		workload.m_statements.push_back("i += y");
+		workload.m_statements.push_back("s = s + ((i*i+2*i)/(1+i*i))^0.5 + max(i,y)*3 - atan2(y,i)");
+		workload.m_statements.push_back("y = y * 0.999 + sin(i) * 0.001");
+	}
+	return workload;
+}
+
+//Read the statement token by token, the way the parser consumes it
+static size_t ScanTokens(Tokenizer &tokenizer, const std::string &statement)
+{
+	static const std::string operators("+-*/%^=()");
+	tokenizer.SetStatement(statement);
+	size_t tokens(0);
+	while (!tokenizer.ReachedEnd())
+	{
+		bool found = tokenizer.EvaluateNumber() || tokenizer.EvalutateVariable();
+		for (size_t i = 0; !found && i < operators.length(); ++i)
+			found = tokenizer.EvaluateCharacter(operators[i]);
+		if (!found)
+			break;
+		++tokens;
+	}
+	return tokens;
+}
+
+static PhaseResult benchmark_tokenizer(const Workload &workload)
+{
+	PhaseResult result;
+	Tokenizer tokenizer;
+	Clock::time_point start = Clock::now();
+	while (KeepRunning(result, start))
+	{
+		size_t allocations = AllocationCounter::GetAllocations();
+		Clock::time_point begin = Clock::now();
+		for (const std::string &statement : workload.m_statements)
+			ScanTokens(tokenizer, statement);
+		result.m_nanoseconds += ElapsedNanoseconds(begin, Clock::now());
+		result.m_allocations += AllocationCounter::GetAllocations() - allocations;
+		result.m_statements += workload.m_statements.size();
+		result.m_bytes += ScriptBytes(workload.m_statements);
+		++result.m_repetitions;
+	}
+	return result;
+}
+
+//Parsing depends on the variables defined by the previous statements, so every
+//statement is evaluated right after it was parsed and only the parse is timed here
+static PhaseResult benchmark_parser(const Workload &workload, ParsedScript &parsed)
+{
+	PhaseResult result;
+	Clock::time_point start = Clock::now();
+	while (KeepRunning(result, start))
+	{
+		parsed.m_expressions.clear();
+		parsed.m_parser.reset(new Parser());
+		for (const std::string &statement : workload.m_statements)
+		{
+			size_t allocations = AllocationCounter::GetAllocations();
+			Clock::time_point begin = Clock::now();
+			ExpressionPtr exp = parsed.m_parser->EvaluateStatement(statement);
+			result.m_nanoseconds += ElapsedNanoseconds(begin, Clock::now());
+			result.m_allocations += AllocationCounter::GetAllocations() - allocations;
+			if (exp)
+				exp->Evaluate();
+			parsed.m_expressions.push_back(exp);
+		}
+		result.m_statements += workload.m_statements.size();
+		result.m_bytes += ScriptBytes(workload.m_statements);
+		++result.m_repetitions;
+	}
+	return result;
+}
+
+static PhaseResult benchmark_evaluator(const Workload &workload, const ParsedScript &parsed)
+{
+	PhaseResult result;
+	Clock::time_point start = Clock::now();
+	while (KeepRunning(result, start))
+	{
+		size_t allocations = AllocationCounter::GetAllocations();
+		Clock::time_point begin = Clock::now();
+		for (const ExpressionPtr &exp : parsed.m_expressions)
+			if (exp)
+				exp->Evaluate();
+		result.m_nanoseconds += ElapsedNanoseconds(begin, Clock::now());
+		result.m_allocations += AllocationCounter::GetAllocations() - allocations;
+		result.m_statements += parsed.m_expressions.size();
+		result.m_bytes += ScriptBytes(workload.m_statements);
+		++result.m_repetitions;
+	}
+	return result;
+}
+
+static PhaseResult benchmark_compiled(const Workload &workload, const ParsedScript &parsed)
+{
+	PhaseResult result;
+	std::vector<CompiledExpression> compiled(parsed.m_expressions.size());
+	for (size_t i = 0; i < compiled.size(); ++i)
+		if (parsed.m_expressions[i])
+			parsed.m_expressions[i]->Compile(compiled[i]);
+
+	std::vector<double> stack;
+	Clock::time_point start = Clock::now();
+	while (KeepRunning(result, start))
+	{
+		size_t allocations = AllocationCounter::GetAllocations();
+		Clock::time_point begin = Clock::now();
+		for (const CompiledExpression &exp : compiled)
+			exp.Evaluate(parsed.m_parser.get(), stack);
+		result.m_nanoseconds += ElapsedNanoseconds(begin, Clock::now());
+		result.m_allocations += AllocationCounter::GetAllocations() - allocations;
+		result.m_statements += compiled.size();
+		result.m_bytes += ScriptBytes(workload.m_statements);
+		++result.m_repetitions;
+	}
+	return result;
+}
+
+//Every thread runs the shared program against its own environment for the same duration
+static ThreadsResult benchmark_threads(const Program &program, size_t threads)
+{
+	ThreadsResult result;
+	result.m_threads = threads;
+	std::atomic<size_t> runs(0);
+	std::vector<std::thread> workers;
+	Clock::time_point start = Clock::now();
+	for (size_t t = 0; t < threads; ++t)
+	{
+		workers.emplace_back([&program, &runs, start]() {
+			Environment environment(program);
+			size_t local(0);
+			while (local < s_minRepetitions || Clock::now() - start < s_minDuration)
+			{
+				environment.Reset();
+				program.Run(environment);
+				++local;
+			}
+			runs += local;
+		});
+	}
+	for (std::thread &worker : workers)
+		worker.join();
+	result.m_nanoseconds = ElapsedNanoseconds(start, Clock::now());
+	result.m_runs = runs;
+	return result;
+}
+
+static void WriteThreads(std::ostream &out, const Workload &workload)
+{
+	Parser parser;
+	for (const std::string &statement : workload.m_statements)
+		parser.AddStatement(statement);
+	const Program program(parser);
+
+	size_t maxThreads = std::max<size_t>(4, std::thread::hardware_concurrency());
+	double single(0);
+	for (size_t threads = 1; threads <= maxThreads; threads *= 2)
+	{
+		ThreadsResult result = benchmark_threads(program, threads);
+		double statementsPerSecond = result.m_runs * program.GetStatementCount() / (result.m_nanoseconds / 1e9);
+		if (threads == 1)
+			single = statementsPerSecond;
+		else
+			out << ",\n";
+		out << "{\"workload\": \"" << workload.m_name << "\", \"threads\": " << threads
+			<< ", \"runs\": " << result.m_runs
+			<< ", \"statements_per_second\": " << statementsPerSecond
+			<< ", \"speedup\": " << statementsPerSecond / single << "}";
+	}
+}
+
+//Nanoseconds to get the variables of the workload into a new parser, by running it or from a snapshot
+static void WriteSnapshot(std::ostream &out, const Workload &workload)
+{
+	const std::string path("benchmarks.snapshot");
+	PhaseResult replay, restore;
+	Clock::time_point start = Clock::now();
+	while (KeepRunning(replay, start))
+	{
+		Clock::time_point begin = Clock::now();
+		Parser parser;
+		for (const std::string &statement : workload.m_statements)
+			parser.AddStatement(statement);
+		parser.EvaluateStatements();
+		replay.m_nanoseconds += ElapsedNanoseconds(begin, Clock::now());
+		++replay.m_repetitions;
+		if (replay.m_repetitions == 1)
+			VariableSnapshot::Save(parser, path);
+	}
+
+	start = Clock::now();
+	while (KeepRunning(restore, start))
+	{
+		Clock::time_point begin = Clock::now();
+		Parser parser;
+		VariableSnapshot::Restore(parser, path);
+		restore.m_nanoseconds += ElapsedNanoseconds(begin, Clock::now());
+		++restore.m_repetitions;
+	}
+	std::remove(path.c_str());
+
+	double replayNanoseconds = replay.m_nanoseconds / replay.m_repetitions;
+	double restoreNanoseconds = restore.m_nanoseconds / restore.m_repetitions;
+	out << "{\"workload\": \"" << workload.m_name << "\", \"variables\": " << workload.m_size
+		<< ", \"replay_ns\": " << replayNanoseconds
+		<< ", \"restore_ns\": " << restoreNanoseconds
+		<< ", \"speedup\": " << replayNanoseconds / restoreNanoseconds << "}";
+}
+
+//Nanoseconds to run the workload in a new parser, reading every statement or finding it in a compiled cache
+static void WriteCache(std::ostream &out, const Workload &workload)
+{
+	CompiledCache cache;
+	PhaseResult cold, warm;
+	Clock::time_point start = Clock::now();
+	while (KeepRunning(cold, start))
+	{
+		Clock::time_point begin = Clock::now();
+		Parser parser;
+		for (const std::string &statement : workload.m_statements)
+			parser.AddStatement(statement);
+		parser.EvaluateStatements();
+		cold.m_nanoseconds += ElapsedNanoseconds(begin, Clock::now());
+		++cold.m_repetitions;
+		if (cold.m_repetitions == 1)
+		{
+			parser.SetCompiledCache(&cache);
+			parser.Reset();
+			for (const std::string &statement : workload.m_statements)
+				parser.AddStatement(statement);
+			parser.EvaluateStatements();
+		}
+	}
+
+	size_t hits = cache.GetHits();
+	start = Clock::now();
+	while (KeepRunning(warm, start))
+	{
+		Clock::time_point begin = Clock::now();
+		Parser parser;
+		parser.SetCompiledCache(&cache);
+		for (const std::string &statement : workload.m_statements)
+			parser.AddStatement(statement);
+		parser.EvaluateStatements();
+		warm.m_nanoseconds += ElapsedNanoseconds(begin, Clock::now());
+		++warm.m_repetitions;
+	}
+
+	double coldNanoseconds = cold.m_nanoseconds / cold.m_repetitions;
+	double warmNanoseconds = warm.m_nanoseconds / warm.m_repetitions;
+	out << "{\"workload\": \"" << workload.m_name << "\", \"statements\": " << workload.m_statements.size()
+		<< ", \"entries\": " << cache.GetEntries()
+		<< ", \"hit_rate\": " << static_cast<double>(cache.GetHits() - hits) / (warm.m_repetitions * workload.m_statements.size())
+		<< ", \"cold_ns\": " << coldNanoseconds
+		<< ", \"warm_ns\": " << warmNanoseconds
+		<< ", \"speedup\": " << coldNanoseconds / warmNanoseconds << "}";
+}
+
+//Nanoseconds per statement of EvaluateStatements with and without the parse cache of the parser
+static void WriteParseCache(std::ostream &out, const Workload &workload)
+{
+	PhaseResult uncached, cached;
+	double hitRate = 0;
+	for (PhaseResult *result : {&uncached, &cached})
+	{
+		Clock::time_point start = Clock::now();
+		while (KeepRunning(*result, start))
+		{
+			Clock::time_point begin = Clock::now();
+			Parser parser;
+			if (result == &uncached)
+				parser.SetParseCacheLimits(0, 0);
+			for (const std::string &statement : workload.m_statements)
+				parser.AddStatement(statement);
+			parser.EvaluateStatements();
+			result->m_nanoseconds += ElapsedNanoseconds(begin, Clock::now());
+			++result->m_repetitions;
+			hitRate = parser.GetParseCache().GetHitRate();
+		}
+	}
+
+	double statements = static_cast<double>(workload.m_statements.size());
+	double uncachedNanoseconds = uncached.m_nanoseconds / uncached.m_repetitions / statements;
+	double cachedNanoseconds = cached.m_nanoseconds / cached.m_repetitions / statements;
+	out << "{\"workload\": \"" << workload.m_name << "\", \"statements\": " << workload.m_statements.size()
+		<< ", \"hit_rate\": " << hitRate
+		<< ", \"uncached_ns_per_statement\": " << uncachedNanoseconds
+		<< ", \"cached_ns_per_statement\": " << cachedNanoseconds
+		<< ", \"speedup\": " << uncachedNanoseconds / cachedNanoseconds << "}";
+}
+
+//Nanoseconds to get the derivatives of a script with respect to inputs defined before it, read once:
+//by central finite differences, one input per dual evaluation, or a batch of inputs per dual evaluation
+static void WriteDifferentiation(std::ostream &out, size_t inputs, size_t count)
+{
+	std::vector<std::string> variables;
+	Parser parser;
+	for (size_t i = 0; i < inputs; ++i)
+	{
+		variables.push_back("x" + std::to_string(i));
+		parser.RecordVariable(variables[i], 1 + 0.25 * i);
+	}
+	for (size_t i = 0; i < count; ++i)
+	{
+		const std::string &x = variables[i % inputs], &y = variables[(i * 7 + 3) % inputs];
+		parser.AddStatement("r" + std::to_string(i) + "=" + ReplaceAll(ReplaceAll(s_formula, 'X', x), 'Y', y) + "+sin(" + x + "*" + y + ")");
+	}
+	//the last statement depends on this input
+	const std::string last("r" + std::to_string(count - 1));
+	const size_t input = (count - 1) % inputs;
+
+	//the statements are read by the parser and found in its parse cache by the differentiator
+	Differentiator differentiator(parser, variables);
+	differentiator.EvaluateStatements();
+	Program program(parser);
+	Environment environment(program);
+
+	PhaseResult finite, scalar, batched;
+	double finiteDerivative = 0, dualDerivative = 0;
+	Clock::time_point start = Clock::now();
+	while (KeepRunning(finite, start))
+	{
+		Clock::time_point begin = Clock::now();
+		environment.Reset();
+		program.Run(environment);
+		for (size_t i = 0; i < inputs; ++i)
+		{
+			const double h = 1e-6, value = 1 + 0.25 * i;
+			environment.Reset();
+			environment.RecordVariable(variables[i], value + h);
+			program.Run(environment);
+			double plus = environment.LookupVariable(last);
+			environment.Reset();
+			environment.RecordVariable(variables[i], value - h);
+			program.Run(environment);
+			if (i == input)
+				finiteDerivative = (plus - environment.LookupVariable(last)) / (2 * h);
+		}
+		finite.m_nanoseconds += ElapsedNanoseconds(begin, Clock::now());
+		++finite.m_repetitions;
+	}
+	for (PhaseResult *result : {&scalar, &batched})
+	{
+		start = Clock::now();
+		while (KeepRunning(*result, start))
+		{
+			Clock::time_point begin = Clock::now();
+			differentiator.EvaluateStatements(result == &batched);
+			result->m_nanoseconds += ElapsedNanoseconds(begin, Clock::now());
+			++result->m_repetitions;
+		}
+		dualDerivative = differentiator.GetDerivative(last, input);
+	}
+
+	double finiteNanoseconds = finite.m_nanoseconds / finite.m_repetitions;
+	double scalarNanoseconds = scalar.m_nanoseconds / scalar.m_repetitions;
+	double batchedNanoseconds = batched.m_nanoseconds / batched.m_repetitions;
+	out << "{\"inputs\": " << inputs << ", \"statements\": " << count
+		<< ", \"finite_differences_ns\": " << finiteNanoseconds
+		<< ", \"dual_ns\": " << scalarNanoseconds
+		<< ", \"dual_batched_ns\": " << batchedNanoseconds
+		<< ", \"speedup\": " << finiteNanoseconds / scalarNanoseconds
+		<< ", \"batched_speedup\": " << finiteNanoseconds / batchedNanoseconds
+		<< ", \"difference\": " << std::fabs(finiteDerivative - dualDerivative) << "}";
+}
+
+//Nanoseconds to compute the same sum by count pairs of unrolled statements or by one loop statement
+static void WriteLoop(std::ostream &out, size_t count)
+{
+	Workload unrolled{"unrolled", count, {"s=0", "i=0"}};
+	for (size_t i = 0; i < count; ++i)
+	{
+		unrolled.m_statements.push_back("s += i^2");
+		unrolled.m_statements.push_back("i++");
+	}
+	Workload loop{"loop", count, {"s=0", "for i in 0.." + std::to_string(count) + ": s += i^2"}};
+
+	PhaseResult results[2];
+	double sums[2] = {};
+	for (size_t workload = 0; workload < 2; ++workload)
+	{
+		const Workload &statements = workload ? loop : unrolled;
+		PhaseResult &result = results[workload];
+		Clock::time_point start = Clock::now();
+		while (KeepRunning(result, start))
+		{
+			Clock::time_point begin = Clock::now();
+			Parser parser;
+			for (const std::string &statement : statements.m_statements)
+				parser.AddStatement(statement);
+			parser.EvaluateStatements();
+			result.m_nanoseconds += ElapsedNanoseconds(begin, Clock::now());
+			++result.m_repetitions;
+			sums[workload] = parser.LookupVariable("s");
+		}
+	}
+
+	double unrolledNanoseconds = results[0].m_nanoseconds / results[0].m_repetitions;
+	double loopNanoseconds = results[1].m_nanoseconds / results[1].m_repetitions;
+	out << "{\"iterations\": " << count
+		<< ", \"unrolled_ns\": " << unrolledNanoseconds
+		<< ", \"loop_ns\": " << loopNanoseconds
+		<< ", \"loop_ns_per_iteration\": " << loopNanoseconds / count
+		<< ", \"speedup\": " << unrolledNanoseconds / loopNanoseconds
+		<< ", \"same_result\": " << (sums[0] == sums[1] ? "true" : "false") << "}";
+}
+
+//Nanoseconds to run the workload printing every variable or observing only var
+static void WriteDeadStores(std::ostream &out, const Workload &workload, const std::string &var)
+{
+	const std::vector<std::string> observed {var};
+	PhaseResult all, pruned;
+	size_t eliminated = 0;
+	for (PhaseResult *result : {&all, &pruned})
+	{
+		Clock::time_point start = Clock::now();
+		while (KeepRunning(*result, start))
+		{
+			Clock::time_point begin = Clock::now();
+			Parser parser;
+			if (result == &pruned)
+				parser.SetObservedVariables(observed);
+			for (const std::string &statement : workload.m_statements)
+				parser.AddStatement(statement);
+			parser.EvaluateStatements();
+			result->m_nanoseconds += ElapsedNanoseconds(begin, Clock::now());
+			++result->m_repetitions;
+			eliminated = parser.GetEliminatedStatements();
+		}
+	}
+
+	double allNanoseconds = all.m_nanoseconds / all.m_repetitions;
+	double prunedNanoseconds = pruned.m_nanoseconds / pruned.m_repetitions;
+	out << "{\"workload\": \"" << workload.m_name << "\", \"statements\": " << workload.m_statements.size()
+		<< ", \"observed\": \"" << observed[0] << "\", \"eliminated\": " << eliminated
+		<< ", \"all_ns\": " << allNanoseconds
+		<< ", \"observed_ns\": " << prunedNanoseconds
+		<< ", \"speedup\": " << allNanoseconds / prunedNanoseconds << "}";
+}
+
+//What-if variants of a workload, each changing a variable and reading the last one: replaying the
+//whole script per variant against a base evaluated once and forked per variant, see ScenarioRunner
+static void WriteScenarios(std::ostream &out, const Workload &workload, size_t count)
+{
+	std::vector<std::vector<std::string>> scenarios;
+	const std::string last(workload.m_statements.back().substr(0, workload.m_statements.back().find('=')));
+	for (size_t i = 0; i < count; ++i)
+		scenarios.push_back({"v1=" + std::to_string(i), "w=v1*2+" + last});
+
+	size_t threads = std::max<size_t>(4, std::thread::hardware_concurrency());
+	PhaseResult replay, forked, parallel;
+	for (PhaseResult *result : {&replay, &forked, &parallel})
+	{
+		Clock::time_point start = Clock::now();
+		while (KeepRunning(*result, start))
+		{
+			Clock::time_point begin = Clock::now();
+			if (result == &replay)
+			{
+				for (const std::vector<std::string> &scenario : scenarios)
+				{
+					Parser parser;
+					for (const std::string &statement : workload.m_statements)
+						parser.AddStatement(statement);
+					for (const std::string &statement : scenario)
+						parser.AddStatement(statement);
+					parser.EvaluateStatements();
+				}
+			}
+			else
+			{
+				Parser parser;
+				for (const std::string &statement : workload.m_statements)
+					parser.AddStatement(statement);
+				ScenarioRunner runner(parser);
+				for (const std::vector<std::string> &scenario : scenarios)
+					runner.AddScenario(scenario);
+				runner.Run(result == &parallel ? threads : 1);
+			}
+			result->m_nanoseconds += ElapsedNanoseconds(begin, Clock::now());
+			++result->m_repetitions;
+		}
+	}
+
+	double replayNanoseconds = replay.m_nanoseconds / replay.m_repetitions;
+	double forkedNanoseconds = forked.m_nanoseconds / forked.m_repetitions;
+	double parallelNanoseconds = parallel.m_nanoseconds / parallel.m_repetitions;
+	out << "{\"workload\": \"" << workload.m_name << "\", \"statements\": " << workload.m_statements.size()
+		<< ", \"scenarios\": " << count
+		<< ", \"replay_ns\": " << replayNanoseconds
+		<< ", \"forked_ns\": " << forkedNanoseconds
+		<< ", \"threads\": " << threads
+		<< ", \"forked_threads_ns\": " << parallelNanoseconds
+		<< ", \"speedup\": " << replayNanoseconds / forkedNanoseconds
+		<< ", \"threads_speedup\": " << replayNanoseconds / parallelNanoseconds << "}";
+}
+
+//A script run for K inputs: K parser runs, K runs of its program, or one run in K lanes
+template <size_t K>
+static void WriteLanes(std::ostream &out, const Workload &workload, const std::string &var)
+{
+	//var is an input of every run instead of being assigned by the first statement
+	std::vector<std::string> statements(workload.m_statements.begin() + 1, workload.m_statements.end());
+	auto input = [](size_t lane) { return 1.5 + lane * 0.01; };
+	Parser compiler;
+	compiler.RecordVariable(var, 1.5);
+	for (const std::string &statement : statements)
+		compiler.AddStatement(statement);
+	const Program program(compiler);
+	LaneEnvironment<K> lanes(program);
+
+	PhaseResult parsers, programs, laned;
+	for (PhaseResult *result : {&parsers, &programs, &laned})
+	{
+		Clock::time_point start = Clock::now();
+		while (KeepRunning(*result, start))
+		{
+			Clock::time_point begin = Clock::now();
+			if (result == &parsers)
+			{
+				for (size_t lane = 0; lane < K; ++lane)
+				{
+					Parser parser;
+					parser.RecordVariable(var, input(lane));
+					for (const std::string &statement : statements)
+						parser.AddStatement(statement);
+					parser.EvaluateStatements();
+				}
+			}
+			else if (result == &programs)
+			{
+				for (size_t lane = 0; lane < K; ++lane)
+				{
+					Environment environment(program);
+					environment.RecordVariable(var, input(lane));
+					program.Run(environment);
+				}
+			}
+			else
+			{
+				lanes.Reset();
+				for (size_t lane = 0; lane < K; ++lane)
+					lanes.RecordVariable(lane, var, input(lane));
+				lanes.Run();
+			}
+			result->m_nanoseconds += ElapsedNanoseconds(begin, Clock::now());
+			result->m_repetitions += K;
+		}
+	}
+
+	auto perSecond = [](const PhaseResult &result) { return result.m_repetitions / (result.m_nanoseconds / 1e9); };
+	out << "{\"workload\": \"" << workload.m_name << "\", \"statements\": " << statements.size()
+		<< ", \"lanes\": " << K
+		<< ", \"parser_scenarios_per_second\": " << perSecond(parsers)
+		<< ", \"program_scenarios_per_second\": " << perSecond(programs)
+		<< ", \"lanes_scenarios_per_second\": " << perSecond(laned)
+		<< ", \"split_statements\": " << lanes.GetSplitStatements()
+		<< ", \"speedup\": " << perSecond(laned) / perSecond(parsers)
+		<< ", \"program_speedup\": " << perSecond(laned) / perSecond(programs) << "}";
+}
+
+//A script evaluated for every row of two input columns: a parser run per row given its values as
+//statements, against reading the columns from a CSV or binary file and evaluating them in bulk
+static void WriteColumns(std::ostream &out, size_t rows)
+{
+	const std::vector<std::string> script {"z=x*y+sin(x)", "w=z/(y+1)", "r=max(w,0.5)^0.5"};
+	const std::vector<std::string> names {"x", "y"}, selected {"r"};
+	ColumnFile columns;
+	std::vector<double> x(rows), y(rows);
+	for (size_t row = 0; row < rows; ++row)
+	{
+		x[row] = row * 0.001;
+		y[row] = (row % 100) * 0.5;
+	}
+	columns.AddColumn("x", x);
+	columns.AddColumn("y", y);
+	const std::string csvPath("benchmarks.csv"), binaryPath("benchmarks.columns");
+	columns.Save(csvPath);
+	columns.Save(binaryPath);
+
+	Parser compiler;
+	for (const std::string &name : names)
+		compiler.RecordVariable(name, 0);
+	for (const std::string &statement : script)
+		compiler.AddStatement(statement);
+	const Program program(compiler);
+
+	//the parser runs are timed on the first rows only
+	const size_t parsedRows = std::min<size_t>(rows, 2000);
+	PhaseResult statements, csv, binary;
+	size_t csvBytes = 0, binaryBytes = 0;
+	for (PhaseResult *result : {&statements, &csv, &binary})
+	{
+		Clock::time_point start = Clock::now();
+		while (KeepRunning(*result, start))
+		{
+			Clock::time_point begin = Clock::now();
+			if (result == &statements)
+			{
+				for (size_t row = 0; row < parsedRows; ++row)
+				{
+					Parser parser;
+					parser.AddStatement("x=" + std::to_string(x[row]));
+					parser.AddStatement("y=" + std::to_string(y[row]));
+					for (const std::string &statement : script)
+						parser.AddStatement(statement);
+					parser.EvaluateStatements();
+				}
+				result->m_statements += parsedRows;
+			}
+			else
+			{
+				ColumnFile input, output;
+				std::string unknown;
+				input.Load(result == &csv ? csvPath : binaryPath, names);
+				BulkEvaluator(program).Run(input, selected, output, unknown);
+				result->m_statements += input.GetRowCount();
+				result->m_bytes += input.GetFileBytes();
+				(result == &csv ? csvBytes : binaryBytes) = input.GetFileBytes();
+			}
+			result->m_nanoseconds += ElapsedNanoseconds(begin, Clock::now());
+			++result->m_repetitions;
+		}
+	}
+	std::remove(csvPath.c_str());
+	std::remove(binaryPath.c_str());
+
+	auto rowsPerSecond = [](const PhaseResult &result) { return result.m_statements / (result.m_nanoseconds / 1e9); };
+	auto megabytesPerSecond = [](const PhaseResult &result) { return result.m_bytes / 1e6 / (result.m_nanoseconds / 1e9); };
+	out << "{\"rows\": " << rows << ", \"statements\": " << script.size()
+		<< ", \"parser_rows_per_second\": " << rowsPerSecond(statements)
+		<< ", \"csv_bytes\": " << csvBytes
+		<< ", \"csv_rows_per_second\": " << rowsPerSecond(csv)
+		<< ", \"csv_mb_per_second\": " << megabytesPerSecond(csv)
+		<< ", \"binary_bytes\": " << binaryBytes
+		<< ", \"binary_rows_per_second\": " << rowsPerSecond(binary)
+		<< ", \"binary_mb_per_second\": " << megabytesPerSecond(binary)
+		<< ", \"binary_speedup\": " << rowsPerSecond(binary) / rowsPerSecond(statements) << "}";
+}
+
+//Many small scripts from a directory: a new parser per script one after the other, against
+//BatchRunner on one thread and on every core
+static void WriteBatch(std::ostream &out, size_t scripts)
+{
+	const std::string directory("benchmarks.batch");
+	std::filesystem::create_directories(directory);
+	std::vector<std::string> paths;
+	for (size_t script = 0; script < scripts; ++script)
+	{
+		paths.push_back(directory + "/" + std::to_string(script));
+		std::ofstream file(paths.back());
+		//a few scripts are much longer than the others
+		Workload workload = formula_inline(script % 100 ? 20 : 400);
+		for (const std::string &statement : workload.m_statements)
+			file << statement << "\n";
+	}
+
+	size_t cores = std::max(1u, std::thread::hardware_concurrency());
+	PhaseResult separate, single, parallel;
+	for (PhaseResult *result : {&separate, &single, &parallel})
+	{
+		Clock::time_point start = Clock::now();
+		while (KeepRunning(*result, start))
+		{
+			Clock::time_point begin = Clock::now();
+			if (result == &separate)
+			{
+				for (const std::string &path : paths)
+				{
+					Parser parser;
+					std::ifstream file(path);
+					std::string line;
+					while (std::getline(file, line))
+						parser.AddStatement(line);
+					parser.EvaluateStatements();
+					std::ostringstream output;
+					parser.PrintVariables(output);
+				}
+			}
+			else
+			{
+				BatchRunner runner;
+				runner.AddDirectory(directory);
+				runner.Run(result == &single ? 1 : cores);
+			}
+			result->m_nanoseconds += ElapsedNanoseconds(begin, Clock::now());
+			++result->m_repetitions;
+		}
+	}
+	std::filesystem::remove_all(directory);
+
+	auto perSecond = [scripts](const PhaseResult &result) { return scripts * result.m_repetitions / (result.m_nanoseconds / 1e9); };
+	out << "{\"scripts\": " << scripts
+		<< ", \"separate_scripts_per_second\": " << perSecond(separate)
+		<< ", \"batch_scripts_per_second\": " << perSecond(single)
+		<< ", \"threads\": " << cores
+		<< ", \"batch_threads_scripts_per_second\": " << perSecond(parallel)
+		<< ", \"speedup\": " << perSecond(parallel) / perSecond(separate) << "}";
+}
+
+//One generated statement of a sum of products, read on the calling thread and split on
+//several threads, see Parser::SetParseThreads
+static void WriteParallelParse(std::ostream &out, size_t terms)
+{
+	std::string statement("r = 0");
+	for (size_t term = 0; term < terms; ++term)
+		statement += std::string(term % 4 ? " + " : " - ") + std::to_string(term % 97) + ".5*x" + std::to_string(term % 10) +
+			"*(y" + std::to_string(term % 3) + " - " + std::to_string(term % 13) + ")";
+
+	size_t cores = std::max(1u, std::thread::hardware_concurrency());
+	std::vector<size_t> counts {1, 2, 4, 8};
+	if (std::find(counts.begin(), counts.end(), cores) == counts.end())
+		counts.push_back(cores);
+	double sequentialSeconds = 0, sequentialValue = 0;
+	out << "{\"terms\": " << terms << ", \"bytes\": " << statement.size() << ", \"cores\": " << cores << ", \"threads\": [";
+	for (size_t threads : counts)
+	{
+		PhaseResult result;
+		double value = 0;
+		bool split = false;
+		Clock::time_point start = Clock::now();
+		while (KeepRunning(result, start))
+		{
+			Parser parser;
+			for (size_t i = 0; i < 10; ++i)
+				parser.RecordVariable("x" + std::to_string(i), i * 0.25);
+			for (size_t i = 0; i < 3; ++i)
+				parser.RecordVariable("y" + std::to_string(i), i + 0.5);
+			parser.SetParseThreads(threads, 0);
+			parser.AddStatement(statement);
+			CompiledExpression compiled;
+			std::vector<double> stack;
+			Clock::time_point begin = Clock::now();
+			bool read = parser.CompileStatement(0, compiled);
+			result.m_nanoseconds += ElapsedNanoseconds(begin, Clock::now());
+			result.m_bytes += statement.size();
+			++result.m_repetitions;
+			if (read)
+			{
+				compiled.Evaluate(&parser, stack);
+				value = parser.LookupVariable("r");
+			}
+		}
+		//whether the statement was split, not left to the calling thread
+		if (threads > 1)
+		{
+			Parser parser;
+			CompiledExpression compiled;
+			split = ParallelSumParser(threads).Compile(statement, parser, compiled);
+		}
+		double seconds = result.m_nanoseconds / 1e9 / result.m_repetitions;
+		if (threads == 1)
+		{
+			sequentialSeconds = seconds;
+			sequentialValue = value;
+		}
+		out << (threads == 1 ? "\n " : ",\n ") << "{\"threads\": " << threads
+			<< ", \"split\": " << (split ? "true" : "false")
+			<< ", \"ms_per_statement\": " << seconds * 1e3
+			<< ", \"mb_per_second\": " << statement.size() / 1e6 / seconds
+			<< ", \"same_value\": " << (value == sequentialValue ? "true" : "false")
+			<< ", \"speedup\": " << sequentialSeconds / seconds << "}";
+	}
+	out << "]}";
+}
+
+//A script calling the built-in functions with repeated arguments, run by a new parser without
+//a function cache and with one, see Parser::SetFunctionCache
+static void WriteFunctionCache(std::ostream &out, const Workload &workload)
+{
+	PhaseResult plain, cached;
+	double hitRate = 0;
+	for (PhaseResult *result : {&plain, &cached})
+	{
+		Clock::time_point start = Clock::now();
+		while (KeepRunning(*result, start))
+		{
+			Parser parser;
+			FunctionCache cache;
+			if (result == &cached)
+				parser.SetFunctionCache(&cache);
+			for (const std::string &statement : workload.m_statements)
+				parser.AddStatement(statement);
+			Clock::time_point begin = Clock::now();
+			parser.EvaluateStatements();
+			result->m_nanoseconds += ElapsedNanoseconds(begin, Clock::now());
+			++result->m_repetitions;
+			hitRate = cache.GetHitRate();
+		}
+	}
+
+	auto milliseconds = [](const PhaseResult &result) { return result.m_nanoseconds / 1e6 / result.m_repetitions; };
+	out << "{\"workload\": \"" << workload.m_name << "\", \"statements\": " << workload.m_statements.size()
+		<< ", \"plain_ms\": " << milliseconds(plain)
+		<< ", \"cached_ms\": " << milliseconds(cached)
+		<< ", \"hit_rate\": " << hitRate
+		<< ", \"speedup\": " << milliseconds(plain) / milliseconds(cached) << "}";
+}
+
+//Statements per second of a script and of the same script with a stray character in every
+//statement, read with and without the SyntaxChecker, see Parser::EnableSyntaxCheck
+static void WriteMalformed(std::ostream &out, const Workload &workload)
+{
+	std::vector<std::string> malformed(workload.m_statements);
+	for (size_t i = 0; i < malformed.size(); ++i)
+		malformed[i][malformed[i].size() / 2 + i % (malformed[i].size() / 2)] = '#';
+
+	auto statementsPerSecond = [](const std::vector<std::string> &statements, bool check) {
+		PhaseResult result;
+		Clock::time_point start = Clock::now();
+		while (KeepRunning(result, start))
+		{
+			Parser parser;
+			parser.EnableSyntaxCheck(check);
+			for (const std::string &statement : statements)
+				parser.AddStatement(statement);
+			Clock::time_point begin = Clock::now();
+			parser.EvaluateStatements();
+			result.m_nanoseconds += ElapsedNanoseconds(begin, Clock::now());
+			result.m_statements += statements.size();
+			++result.m_repetitions;
+		}
+		return result.m_statements / (result.m_nanoseconds / 1e9);
+	};
+	double valid = statementsPerSecond(workload.m_statements, false), invalid = statementsPerSecond(malformed, false);
+	double checkedValid = statementsPerSecond(workload.m_statements, true), checkedInvalid = statementsPerSecond(malformed, true);
+	out << "{\"workload\": \"" << workload.m_name << "\", \"statements\": " << workload.m_statements.size()
+		<< ", \"valid_per_second\": " << valid
+		<< ", \"malformed_per_second\": " << invalid
+		<< ", \"checked_valid_per_second\": " << checkedValid
+		<< ", \"checked_malformed_per_second\": " << checkedInvalid
+		<< ", \"malformed_speedup\": " << checkedInvalid / invalid << "}";
+}
+
+//Runs of spaces, letters and digits classified by CharacterScanner a byte at a time and with
+//each vector implementation the processor has, alone and within the tokenizer
+static void WriteScanner(std::ostream &out, const Workload &workload)
+{
+	std::string text;
+	for (const std::string &statement : workload.m_statements)
+		text += statement;
+	const CharacterScanner::Implementation best = CharacterScanner::GetImplementation();
+	bool first = true;
+	out << "{\"workload\": \"" << workload.m_name << "\", \"bytes\": " << text.size() << ", \"implementations\": [";
+	for (CharacterScanner::Implementation implementation : {CharacterScanner::Implementation::Scalar,
+		CharacterScanner::Implementation::SSE2, CharacterScanner::Implementation::AVX2})
+	{
+		if (!CharacterScanner::SetImplementation(implementation))
+			continue;
+		PhaseResult scan;
+		size_t tokens = 0;
+		Clock::time_point start = Clock::now();
+		while (KeepRunning(scan, start))
+		{
+			Clock::time_point begin = Clock::now();
+			for (size_t position = 0; position < text.size(); ++tokens)
+			{
+				size_t end = CharacterScanner::SkipSpaces(text.data(), position, text.size());
+				end = CharacterScanner::SkipAlphanumerics(text.data(), end, text.size());
+				position = std::max(end, position + 1);
+			}
+			scan.m_nanoseconds += ElapsedNanoseconds(begin, Clock::now());
+			scan.m_bytes += text.size();
+			++scan.m_repetitions;
+		}
+		PhaseResult tokenizer = benchmark_tokenizer(workload);
+
+		auto megabytesPerSecond = [](const PhaseResult &result) { return result.m_bytes / 1e6 / (result.m_nanoseconds / 1e9); };
+		out << (first ? "\n " : ",\n ") << "{\"implementation\": \"" << CharacterScanner::GetImplementationName(implementation)
+			<< "\", \"tokens\": " << tokens / scan.m_repetitions
+			<< ", \"scan_mb_per_second\": " << megabytesPerSecond(scan)
+			<< ", \"tokenizer_mb_per_second\": " << megabytesPerSecond(tokenizer) << "}";
+		first = false;
+	}
+	CharacterScanner::SetImplementation(best);
+	out << "]}";
+}
+
+static void WritePhase(std::ostream &out, const char *name, const PhaseResult &result)
+{
+	double statements = static_cast<double>(result.m_statements);
+	double seconds = result.m_nanoseconds / 1e9;
+	out << "\"" << name << "\": {"
+		<< "\"repetitions\": " << result.m_repetitions
+		<< ", \"ns_per_statement\": " << result.m_nanoseconds / statements
+		<< ", \"allocations_per_statement\": " << result.m_allocations / statements
+		<< ", \"statements_per_second\": " << statements / seconds
+		<< ", \"mb_per_second\": " << result.m_bytes / seconds / (1024.0 * 1024.0)
+		<< "}";
+}
+
+void Benchmarks::RunBenchmarks(std::ostream &out)
+{
+	std::vector<Workload> workloads {
+		long_sum(2000), deep_parentheses(200), many_variables(1000), function_heavy(500), increments(250),
+		formula_inline(500), formula_functions(500)
+	};
+
+	out << "{\n\"schema\": 1,\n\"benchmarks\": [\n";
+	bool first = true;
+	for (const Workload &workload : workloads)
+	{
+		ParsedScript parsed;
+		PhaseResult tokenizer = benchmark_tokenizer(workload);
+		PhaseResult parser = benchmark_parser(workload, parsed);
+		PhaseResult evaluator = benchmark_evaluator(workload, parsed);
+		PhaseResult compiled = benchmark_compiled(workload, parsed);
+
+		if (first) 
+			first = false; 
+		else 
+			out << ",\n";
+
+		out << "{\"workload\": \"" << workload.m_name << "\", \"size\": " << workload.m_size
+			<< ", \"statements\": " << workload.m_statements.size()
+			<< ", \"bytes\": " << ScriptBytes(workload.m_statements) << ",\n ";
+		WritePhase(out, "tokenizer", tokenizer);
+		out << ",\n ";
+		WritePhase(out, "parser", parser);
+		out << ",\n ";
+		WritePhase(out, "evaluator", evaluator);
+		out << ",\n ";
+		WritePhase(out, "compiled", compiled);
+		out << "}";
+	}
+
+	//one program shared by N threads, each with its own environment
+	out << "\n],\n\"threads\": [\n";
+	WriteThreads(out, many_variables(1000));
+	out << ",\n";
+	WriteThreads(out, formula_functions(500));
+
+	//restoring the variables of a script instead of running it again
+	out << "\n],\n\"snapshot\": [\n";
+	WriteSnapshot(out, many_variables(1000));
+	out << ",\n";
+	WriteSnapshot(out, many_variables(10000));
+
+	//statements compiled by a previous run, found by the hash of their text
+	out << "\n],\n\"cache\": [\n";
+	WriteCache(out, formula_inline(500));
+	out << ",\n";
+	WriteCache(out, function_heavy(500));
+
+	//statements repeated in a script, read once by the parser
+	out << "\n],\n\"parse_cache\": [\n";
+	WriteParseCache(out, repeated_statements(1000));
+	out << ",\n";
+	WriteParseCache(out, increments(250));
+	out << ",\n";
+	WriteParseCache(out, many_variables(1000));
+
+	//gradients with respect to every input, finite differences against dual numbers
+	out << "\n],\n\"differentiation\": [\n";
+	WriteDifferentiation(out, 1, 500);
+	out << ",\n";
+	WriteDifferentiation(out, 16, 500);
+
+	//an iteration written as a loop statement instead of unrolled lines
+	out << "\n],\n\"loops\": [\n";
+	WriteLoop(out, 1000);
+	out << ",\n";
+	WriteLoop(out, 100000);
+
+	//statements no observed variable depends on are skipped
+	out << "\n],\n\"dead_stores\": [\n";
+	WriteDeadStores(out, formula_inline(500), "r499");
+	out << ",\n";
+	WriteDeadStores(out, many_variables(1000), "v999");
+	out << ",\n";
+	Workload sums{"loop_sums", 20, {}};
+	for (size_t i = 0; i < sums.m_size; ++i)
+	{
+		sums.m_statements.push_back("a" + std::to_string(i) + "=0");
+		sums.m_statements.push_back("for i in 0..10000: a" + std::to_string(i) + " += sin(i)");
+	}
+	WriteDeadStores(out, sums, "a19");
+
+	//variants of a script sharing its statements, evaluated once and forked
+	out << "\n],\n\"scenarios\": [\n";
+	WriteScenarios(out, many_variables(1000), 200);
+	out << ",\n";
+	WriteScenarios(out, many_variables(10000), 100);
+
+	//a script evaluated for several inputs at once, a lane each
+	out << "\n],\n\"lanes\": [\n";
+	for (const Workload &workload : {many_variables(1000), repeated_statements(1000)})
+	{
+		const std::string var(workload.m_statements[0].substr(0, workload.m_statements[0].find('=')));
+		if (workload.m_name != "many_variables")
+			out << ",\n";
+		WriteLanes<1>(out, workload, var);
+		out << ",\n";
+		WriteLanes<4>(out, workload, var);
+		out << ",\n";
+		WriteLanes<8>(out, workload, var);
+		out << ",\n";
+		WriteLanes<16>(out, workload, var);
+	}
+
+	//input values read from column files instead of statements
+	out << "\n],\n\"columns\": [\n";
+	WriteColumns(out, 10000);
+	out << ",\n";
+	WriteColumns(out, 1000000);
+
+	//independent scripts of a directory
+	out << "\n],\n\"batch\": [\n";
+	WriteBatch(out, 2000);
+
+	//character classes of the tokenizer, a byte or a vector at a time
+	out << "\n],\n\"scanner\": [\n";
+	WriteScanner(out, long_sum(2000));
+	out << ",\n";
+	Workload spaced{"spaced_names", 500, {}};
+	for (size_t i = 0; i < spaced.m_size; ++i)
+		spaced.m_statements.push_back("accumulatedQuarterlyRevenue" + std::to_string(i) + std::string(40, ' ') + "=" + std::string(40, ' ') + "1234567890123" + std::to_string(i));
+	WriteScanner(out, spaced);
+
+	//a single very long statement read by several threads
+	out << "\n],\n\"parallel_parse\": [\n";
+	WriteParallelParse(out, 20000);
+	out << ",\n";
+	WriteParallelParse(out, 200000);
+
+	//results of the built-in functions kept for repeated arguments
+	out << "\n],\n\"function_cache\": [\n";
+	WriteFunctionCache(out, function_heavy(500));
+	out << ",\n";
+	Workload angles{"trig_loops", 20, {"s=0"}};
+	for (size_t i = 0; i < angles.m_size; ++i)
+		angles.m_statements.push_back("for i in 0..5000: s += sin(i % 360 * 0.0174533) * cos(i % 360 * 0.0174533) + atan2(i % " +
+			std::to_string(i + 2) + ", 3)");
+	WriteFunctionCache(out, angles);
+
+	//malformed statements reported at their first unexpected token
+	out << "\n],\n\"malformed\": [\n";
+	WriteMalformed(out, formula_inline(500));
+	out << ",\n";
+	WriteMalformed(out, function_heavy(500));
+	out << ",\n";
+	WriteMalformed(out, repeated_statements(500));
+	out << "\n]\n}" << std::endl;
+}
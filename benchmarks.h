@@ -0,0 +1,37 @@
+#pragma once
+#include <ostream>
+#include <string>
+#include <vector>
+
+namespace benchmarks
+{
+/*
+	Workload utility class to hold a generated script and the size it was generated for
+*/
+struct Workload
+{
+	std::string m_name;
+	size_t m_size;
+	std::vector<std::string> m_statements;
+};
+
+//Synthetic workload generators
+Workload long_sum(size_t terms);
+Workload deep_parentheses(size_t depth);
+Workload many_variables(size_t count);
+Workload function_heavy(size_t count);
+Workload increments(size_t count);
+//The same formula written in every statement, or defined once as a function and called
+Workload formula_inline(size_t count);
+Workload formula_functions(size_t count);
+//A loop unrolled upstream, the same few statements repeated
+Workload repeated_statements(size_t count);
+
+class Benchmarks
+{
+public:
+    //Run every workload and write the results as JSON
+    static void RunBenchmarks(std::ostream &out);
+};
+    
+}
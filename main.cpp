@@ -2,15 +2,218 @@
 #include "Parser.h"
 #include "Tokenizer.h"
 #include "unittests.h"
+#include "benchmarks.h"
+#include "NumericEngine.h"
+#include "EvaluationServer.h"
+#include "LoadGenerator.h"
+#include "VariableSnapshot.h"
+#include "CompiledCache.h"
+#include "FunctionCache.h"
+#include "Differentiator.h"
+#include "ColumnFile.h"
+#include "BulkEvaluator.h"
+#include "BatchRunner.h"
+#include "Program.h"
 
+#include <algorithm>
+#include <chrono>
 #include <iostream>
+#include <string>
+#include <vector>
 
 
-int main()
+//Comma separated variables, e.g. x,y
+static std::vector<std::string> SplitNames(const std::string &names)
 {
+	std::vector<std::string> res;
+	for (size_t begin = 0, end = 0; begin <= names.size(); begin = end + 1)
+	{
+		end = std::min(names.find(',', begin), names.size());
+		if (end > begin)
+			res.push_back(names.substr(begin, end - begin));
+	}
+	return res;
+}
+
+//Evaluate the statements for every row of the input columns and write the selected variables
+static bool RunColumns(Parser &p, const std::string &inputPath, const std::vector<std::string> &bound,
+	const std::string &outputPath, const std::vector<std::string> &selected, NumericType type)
+{
+	using Clock = std::chrono::steady_clock;
+	if (outputPath.empty() || selected.empty())
+	{
+		std::cout << "--input needs --output and --select" << std::endl;
+		return false;
+	}
+	if (!BulkEvaluator::IsSupported(type))
+	{
+		std::cout << "--input evaluates in double or float, not " << GetNumericTypeName(type) << std::endl;
+		return false;
+	}
+	ColumnFile input, output;
+	Clock::time_point begin = Clock::now();
+	if (!input.Load(inputPath, bound))
+	{
+		std::cout << "Could not read " << inputPath << ": " << input.GetError() << std::endl;
+		return false;
+	}
+
+	//the columns are variables defined before the first statement
+	for (size_t column = 0; column < input.GetColumnCount(); ++column)
+		p.RecordVariable(input.GetName(column), 0);
+	const Program program(p);
+	p.PrintErrors();
+	BulkEvaluator evaluator(program, type);
+	std::string unknown;
+	Clock::time_point loaded = Clock::now();
+	if (!evaluator.Run(input, selected, output, unknown))
+	{
+		std::cout << "Unknown variable " << unknown << std::endl;
+		return false;
+	}
+	Clock::time_point evaluated = Clock::now();
+	if (!output.Save(outputPath))
+	{
+		std::cout << "Could not write " << outputPath << std::endl;
+		return false;
+	}
+	Clock::time_point saved = Clock::now();
+
+	auto seconds = [](Clock::time_point from, Clock::time_point to) { return std::chrono::duration<double>(to - from).count(); };
+	double rows = static_cast<double>(input.GetRowCount()), megabytes = input.GetFileBytes() / 1e6;
+	std::cout << "Read " << input.GetRowCount() << " rows of " << input.GetColumnCount() << " columns in " << seconds(begin, loaded) * 1e3
+		<< " ms, " << megabytes / seconds(begin, loaded) << " MB/s" << std::endl;
+	std::cout << "Evaluated " << input.GetRowCount() << " rows in " << seconds(loaded, evaluated) * 1e3 << " ms, "
+		<< rows / seconds(loaded, evaluated) << " rows/s" << std::endl;
+	std::cout << "Wrote " << output.GetColumnCount() << " columns in " << seconds(evaluated, saved) * 1e3 << " ms, "
+		<< rows / seconds(begin, saved) << " rows/s overall" << std::endl;
+	const std::vector<size_t> &failed = evaluator.GetFailedRows();
+	if (!failed.empty())
+		std::cout << failed.size() << " rows reported errors, the first is row " << failed[0] + 1 << std::endl;
+	return true;
+}
+
+int main(int argc, char *argv[])
+{
+	if (argc > 1 && std::string(argv[1]) == "--bench")
+	{
+		benchmarks::Benchmarks::RunBenchmarks(std::cout);
+		return 0;
+	}
+
+	if (argc > 1 && std::string(argv[1]) == "--complexity")
+	{
+		if (argc > 2)
+			unittests::UnitTests::RunComplexityTests(std::stod(argv[2]));
+		else
+			unittests::UnitTests::RunComplexityTests();
+		return 0;
+	}
+
+	if (argc > 2 && std::string(argv[1]) == "--serve")
+	{
+		EvaluationServer server(argv[2], argc > 3 ? std::stoul(argv[3]) : 16);
+		if (!server.Listen())
+		{
+			std::cout << "Could not listen on " << argv[2] << (EvaluationServer::IsSupported() ? "" : ", Unix domain sockets and epoll are required") << std::endl;
+			return 1;
+		}
+		server.Run();
+		return 0;
+	}
+
+	if (argc > 2 && std::string(argv[1]) == "--load")
+	{
+		LoadGenerator::Options options;
+		if (argc > 3)
+			options.m_clients = std::stoul(argv[3]);
+		if (argc > 4)
+			options.m_requests = std::stoul(argv[4]);
+		if (argc > 5)
+			options.m_pipeline = std::stoul(argv[5]);
+		LoadGenerator::WriteJson(std::cout, options, LoadGenerator::Run(argv[2], options));
+		return 0;
+	}
+
+	if (argc > 2 && std::string(argv[1]) == "--batch")
+	{
+		//a directory of scripts or a manifest listing them, then where to write the results
+		BatchRunner runner;
+		if (!runner.AddDirectory(argv[2]) && !runner.AddManifest(argv[2]))
+		{
+			std::cout << "Could not read the scripts of " << argv[2] << std::endl;
+			return 1;
+		}
+		if (argc > 3)
+			runner.SetResultsDirectory(argv[3]);
+		if (!runner.Run(argc > 4 ? std::stoul(argv[4]) : 0))
+		{
+			std::cout << "The results in " << argv[3] << " would overwrite scripts" << std::endl;
+			return 1;
+		}
+		runner.WriteReport(std::cout);
+		return 0;
+	}
+
+	bool ruleStatistics(false), profile(false), profileJson(false), numeric(false), memoize(false);
+	NumericType numericType(NumericType::Auto);
+	std::string restorePath, snapshotPath, cachePath, inputPath, outputPath;
+	std::vector<std::string> gradient, observed, bound, selected;
+	for (int i = 1; i < argc; ++i)
+	{
+		std::string arg(argv[i]);
+		ruleStatistics |= arg == "--rule-stats";
+		profile |= arg == "--profile";
+		profileJson |= arg == "--profile-json";
+		memoize |= arg == "--memoize";
+		if (arg == "--restore" && i + 1 < argc)
+			restorePath = argv[++i];
+		if (arg == "--snapshot" && i + 1 < argc)
+			snapshotPath = argv[++i];
+		if (arg == "--cache" && i + 1 < argc)
+			cachePath = argv[++i];
+		if (arg == "--gradient" && i + 1 < argc)
+			gradient = SplitNames(argv[++i]);
+		if (arg == "--observe" && i + 1 < argc)
+			observed = SplitNames(argv[++i]);
+		if (arg == "--input" && i + 1 < argc)
+			inputPath = argv[++i];
+		if (arg == "--bind" && i + 1 < argc)
+			bound = SplitNames(argv[++i]);
+		if (arg == "--output" && i + 1 < argc)
+			outputPath = argv[++i];
+		if (arg == "--select" && i + 1 < argc)
+			selected = SplitNames(argv[++i]);
+		if (arg == "--numeric")
+		{
+			numeric = true;
+			if (i + 1 < argc && !ParseNumericType(argv[i + 1], numericType))
+			{
+				std::cout << "Unknown numeric type " << argv[i + 1] << ", expected float, double, long-double, int64 or auto" << std::endl;
+				return 1;
+			}
+			++i;
+		}
+	}
+
 	std::cout << "Enter expressions: ";
 	std::string line;
 	Parser p;
+	p.EnableProfiling(profile || profileJson);
+	p.SetObservedVariables(observed);
+	if (!restorePath.empty() && !VariableSnapshot::Restore(p, restorePath))
+		std::cout << "Could not restore the variables from " << restorePath << std::endl;
+	CompiledCache cache;
+	if (!cachePath.empty())
+	{
+		//a missing file is the first run, it is written below
+		if (!cache.Load(cachePath) && cache.HadVersionMismatch())
+			std::cout << "Ignoring " << cachePath << ", it was written by another version" << std::endl;
+		p.SetCompiledCache(&cache);
+	}
+	FunctionCache functionCache;
+	if (memoize)
+		p.SetFunctionCache(&functionCache);
 	while (std::getline (std::cin, line)) {
 		if (line.length() == 0)
 			break;
@@ -18,8 +221,57 @@ int main()
 		p.AddStatement(line);	
 	}	
 
-	p.EvaluateStatements();
-	p.PrintVariables();
+	if (!gradient.empty())
+	{
+		Differentiator differentiator(p, gradient);
+		differentiator.EvaluateStatements();
+		p.PrintErrors();
+		p.PrintVariables();
+		differentiator.PrintDerivatives(std::cout);
+	}
+	else if (!inputPath.empty())
+	{
+		if (!RunColumns(p, inputPath, bound, outputPath, selected, numeric ? numericType : NumericType::Double))
+			return 1;
+	}
+	else if (numeric)
+	{
+		NumericEngine engine(p, numericType);
+		engine.EvaluateStatements();
+		p.PrintErrors();
+		engine.PrintVariables();
+	}
+	else
+	{
+		p.EvaluateStatements();
+		p.PrintErrors();
+		p.PrintVariables();
+		if (!observed.empty())
+			std::cout << "Eliminated " << p.GetEliminatedStatements() << " of " << p.GetStatementCount() << " statements" << std::endl;
+	}
+	if (!snapshotPath.empty() && !VariableSnapshot::Save(p, snapshotPath))
+		std::cout << "Could not save the variables to " << snapshotPath << std::endl;
+	if (!cachePath.empty())
+	{
+		p.SetCompiledCache(nullptr);
+		if (!cache.Save(cachePath))
+			std::cout << "Could not save the compiled statements to " << cachePath << std::endl;
+		if (profile)
+			std::cout << "Compiled cache: " << cache.GetHits() << " hits, " << cache.GetMisses() << " misses" << std::endl;
+	}
+	if (ruleStatistics)
+		p.PrintParseStatistics();
+	if (profile)
+	{
+		p.GetProfiler().WriteText(std::cout);
+		const ParseCache &parseCache = p.GetParseCache();
+		std::cout << "Parse cache: " << parseCache.GetHits() << " hits, " << parseCache.GetMisses() << " misses, "
+			<< parseCache.GetEvictions() << " evictions" << std::endl;
+		if (memoize)
+			functionCache.PrintStatistics(std::cout);
+	}
+	if (profileJson)
+		p.GetProfiler().WriteJson(std::cout);
 	unittests::UnitTests::RunUnitTests();
 	return 0;
 }
\ No newline at end of file
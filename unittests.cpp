@@ -1,11 +1,47 @@
 #include "unittests.h"
+#include "benchmarks.h"
 #include "Parser.h"
+#include "CompileTimeExpression.h"
+#include "NumericEngine.h"
+#include "Program.h"
+#include "Environment.h"
+#include "LaneEnvironment.h"
+#include "EvaluationServer.h"
+#include "LoadGenerator.h"
+#include "VariableSnapshot.h"
+#include "CompiledCache.h"
+#include "Differentiator.h"
+#include "Liveness.h"
+#include "ScenarioRunner.h"
+#include "ColumnFile.h"
+#include "BulkEvaluator.h"
+#include "BatchRunner.h"
+#include "CharacterScanner.h"
+#include "ParallelSumParser.h"
+#include "FunctionCache.h"
+#include "SyntaxChecker.h"
 
 #include <string>
+#include <cctype>
 #include <iostream>
 #include <map>
 #include <math.h>
 #include <limits>
+#include <chrono>
+#include <functional>
+#include <thread>
+#include <sstream>
+#include <fstream>
+#include <filesystem>
+#include <iterator>
+#include <cstdio>
+
+#ifdef __linux__
+#include <cstring>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#endif
 
 using namespace unittests;
 
@@ -148,9 +184,10 @@ bool test_case7()
 		std::string("e=d"), std::string("e=(++d)"),
 	};
 
+	//(++d) is applied once, it used to be read twice when backtracking from Power to Term
 	std::map<std::string, double> expectedValues {
 		{std::string("a"), 2}, {std::string("b"), 0}, {std::string("c"), 3},
-		{std::string("d"), 4}, {std::string("e"), 4}
+		{std::string("d"), 3}, {std::string("e"), 3}
 	};
 
 	return evaluate_and_compare(statements, expectedValues);
@@ -200,6 +237,1005 @@ bool test_case10()
 	return evaluate_and_compare(statements, expectedValues);
 }
 
+bool test_case11()
+{
+	Parser p;
+	for (const std::string &statement : {std::string("a=5"), std::string("b=a/0"), std::string("c=2+"), 
+		std::string("a%=0"), std::string("d=a")})
+		p.AddStatement(statement);
+
+	p.EvaluateStatements();
+
+	const std::vector<Parser::StatementError> &errors = p.GetErrors();
+	return errors.size() == 3 &&
+		errors[0].m_code == ErrorCode::DivisionByZero && errors[0].m_statement == 1 && errors[0].m_position == 3 &&
+		errors[1].m_code == ErrorCode::SyntaxError && errors[1].m_statement == 2 &&
+		errors[2].m_code == ErrorCode::ModulusByZero && errors[2].m_statement == 3 &&
+		AreSame(p.LookupVariable("d"), 0);
+}
+bool test_case12()
+{
+	Parser p;
+	p.EnableProfiling(true);
+	for (const std::string &statement : {std::string("a=1"), std::string("b=a+2*(a-3)"), std::string("c=")})
+		p.AddStatement(statement);
+
+	p.EvaluateStatements();
+
+	const StatementProfiler &profiler = p.GetProfiler();
+	const LogHistogram &expressions = profiler.GetExpressions();
+	return profiler.GetStatements().size() == 3 && profiler.GetParseLatency().GetCount() == 3 &&
+		profiler.GetStatements()[1].m_expressions > profiler.GetStatements()[0].m_expressions &&
+		expressions.GetPercentile(50) <= expressions.GetPercentile(99.9) && 
+		expressions.GetPercentile(99.9) == expressions.GetMax();
+}
+
+bool test_case13()
+{
+	//long chains are single nodes but keep the left to right order of the binary operations
+	const char *terms[] = {"0.1", "0.7", "1.3"};
+	const double values[] = {0.1, 0.7, 1.3};
+	std::string sum("a=0.1"), product("b=1.5");
+	double a(0.1), b(1.5);
+	for (int i = 1; i < 100000; ++i)
+	{
+		bool substract = i % 4 == 0;
+		sum += std::string(substract ? "-" : "+") + terms[i % 3];
+		a = substract ? a - values[i % 3] : a + values[i % 3];
+	}
+	for (int i = 1; i < 1000; ++i)
+	{
+		product += i % 2 ? "*1.0001" : "/1.0002";
+		b = i % 2 ? b * 1.0001 : b / 1.0002;
+	}
+
+	std::vector<std::string> statements {sum, product};
+	std::map<std::string, double> expectedValues {
+		{std::string("a"), a}, {std::string("b"), b}
+	};
+
+	return evaluate_and_compare(statements, expectedValues);
+}
+
+bool test_case14()
+{
+	std::vector<std::string> statements {
+		std::string("f(x,y)=x*x+y"), std::string("a=f(3,1)"), std::string("g(x)=f(x,x)+1"), 
+		std::string("b=g(2)"), std::string("c=max(1,2)+min(3,4)"), std::string("d=atan2(1,1)+atan(1)"),
+		std::string("k=2"), std::string("h(x)=x*k"), std::string("k=3"), std::string("e=h(2)+pow(2,10)"),
+		std::string("f(x)=x*10"), std::string("z=f(1)+g(1)")
+	};
+
+	//calls read before f was redefined keep the first definition
+	std::map<std::string, double> expectedValues {
+		{std::string("a"), 10}, {std::string("b"), 7}, {std::string("c"), 5},
+		{std::string("d"), atan2(1, 1) + atan(1)}, {std::string("e"), 1030}, {std::string("z"), 13}
+	};
+
+	return evaluate_and_compare(statements, expectedValues);
+}
+
+//Evaluate the literals at compile time into one Parser and as text into another, the variables must agree
+template <typename... Expressions>
+bool compile_time_matches_runtime(Expressions... expressions)
+{
+	Parser compiled, runtime;
+	(expressions.Evaluate(compiled), ...);
+	(runtime.AddStatement(expressions.GetText()), ...);
+	runtime.EvaluateStatements();
+
+	std::vector<std::string> names = runtime.GetVariableNames();
+	if (names.size() != compiled.GetVariableNames().size())
+		return false;
+	for (const std::string &name : names)
+		if (!compiled.HasVariable(name) || !AreSame(compiled.LookupVariable(name), runtime.LookupVariable(name)))
+			return false;
+	return true;
+}
+
+bool test_case15()
+{
+	using namespace compiletime::literals;
+
+	return compile_time_matches_runtime("i=0"_expr, "j=++i"_expr, "x=i++ + 5"_expr, "y= 5 + 3 * 10"_expr, "i += y"_expr) &&
+		compile_time_matches_runtime("a=(5 + 2*3 - 1 + 7 * 8)"_expr, "b=(67 + 2 * 3 - 67 + 2/1 - 7)"_expr, "c=a+b"_expr,
+			"d=b+(2) + (17*2-30) * (5)+2 - (8/2)*4"_expr, "e=4*2.5 + 8.5+1.5 / 3.0"_expr, "f=a+b+c+d+e"_expr) &&
+		compile_time_matches_runtime("a=sin(cos(60))"_expr, "b=cos(sin(60))"_expr, "c=tan(sin(60))"_expr,
+			"d=ceil(floor(5.5))"_expr, "e=floor(ceil(5.5))"_expr, "f=2^3^2 % 7"_expr) &&
+		compile_time_matches_runtime("a=5"_expr, "a+=15"_expr, "b=a"_expr, "b-=15"_expr, "a*=b"_expr, "a/=4"_expr, "a^=2"_expr, "a%=7"_expr) &&
+		compile_time_matches_runtime("abc=   12        -  8   "_expr, "a=142        -9   "_expr, "ab=72+  15"_expr, "xxx=abc"_expr) &&
+		compile_time_matches_runtime("a=0"_expr, "a++"_expr, "++a"_expr, "b=a"_expr, "b--"_expr, "--b"_expr,
+			"c=0"_expr, "c+=a"_expr, "c-=b"_expr, "d=c++"_expr, "e=d"_expr, "e=(++d)"_expr) &&
+		compile_time_matches_runtime("a=1+2+3+4+5+6"_expr, "c=100 * 100 / (5 + 200) * 3 / 2"_expr, "d=(1.0/2.0)/3.0"_expr, "e=1.5e2+2E-1"_expr) &&
+		compile_time_matches_runtime("a=0"_expr, "b=a++ + ++a"_expr, "c=--b + ++b"_expr, "d=max(a,b)+min(1,2)+atan2(1,1)+pow(2,10)"_expr);
+}
+
+bool test_case16()
+{
+	//beyond 2^53 only int64 is exact, auto keeps int64 until the division
+	Parser integers;
+	for (const char *statement : {"a=2^62+1", "b=a-2^62", "m=0-7", "c=m%3", "i=0", "j=i++ + ++i"})
+		integers.AddStatement(statement);
+	NumericEngine integerEngine(integers, NumericType::Auto);
+	integerEngine.EvaluateStatements();
+	bool bRes = integerEngine.GetSelectedType() == NumericType::Int64 && AreSame(integers.LookupVariable("b"), 1) &&
+		AreSame(integers.LookupVariable("c"), -1) && AreSame(integers.LookupVariable("j"), 2);
+
+	Parser mixed;
+	for (const char *statement : {"a=7", "b=a%4", "c=a/2", "d=sin(b)"})
+		mixed.AddStatement(statement);
+	NumericEngine mixedEngine(mixed, NumericType::Auto);
+	mixedEngine.EvaluateStatements();
+	bRes = bRes && mixedEngine.GetSelectedType() == NumericType::Double && AreSame(mixed.LookupVariable("c"), 3.5) &&
+		AreSame(mixed.LookupVariable("d"), sin(3));
+
+	//an overflow in int64 runs the script again in double from its start
+	Parser overflowing, doubles;
+	for (Parser *parser : {&overflowing, &doubles})
+		for (const char *statement : {"i=0", "i++", "a = 10^20", "b = 3037000500*3037000500", "c = i + 1"})
+			parser->AddStatement(statement);
+	NumericEngine overflowEngine(overflowing, NumericType::Auto);
+	overflowEngine.EvaluateStatements();
+	doubles.EvaluateStatements();
+	bRes = bRes && overflowEngine.GetSelectedType() == NumericType::Double && overflowing.LookupVariable("a") == 1e20 &&
+		overflowing.LookupVariable("b") == doubles.LookupVariable("b") && AreSame(overflowing.LookupVariable("c"), 2) &&
+		overflowing.GetVariableNames() == doubles.GetVariableNames();
+
+	//float and long double round every operation in their own precision
+	Parser single, extended;
+	single.AddStatement("a=0.1+0.2+0.3");
+	extended.AddStatement("a=1/3*3-1");
+	NumericEngine(single, NumericType::Float).EvaluateStatements();
+	NumericEngine(extended, NumericType::LongDouble).EvaluateStatements();
+	long double third = 1.0L / 3;
+	bRes = bRes && single.LookupVariable("a") == static_cast<double>(0.1f + 0.2f + 0.3f) &&
+		extended.LookupVariable("a") == static_cast<double>(third * 3 - 1);
+
+	Parser errors;
+	errors.AddStatement("a=5/0");
+	NumericEngine(errors, NumericType::Int64).EvaluateStatements();
+	bRes = bRes && errors.GetErrors().size() == 1 && errors.GetErrors()[0].m_code == ErrorCode::DivisionByZero;
+
+	//in int64 an overflowing operation or an out of range literal is reported, not wrapped around
+	Parser exact;
+	for (const char *statement : {"a = 3037000500", "b = a * a", "c = 9223372036854775807", "d = a + 1"})
+		exact.AddStatement(statement);
+	NumericEngine(exact, NumericType::Int64).EvaluateStatements();
+	return bRes && exact.GetErrors().size() == 2 && exact.GetErrors()[0].m_code == ErrorCode::Overflow && exact.GetErrors()[0].m_statement == 1 &&
+		exact.GetErrors()[1].m_statement == 2 && exact.LookupVariable("c") == 9223372036854775807.0 && AreSame(exact.LookupVariable("d"), 3037000501);
+}
+
+bool test_case17()
+{
+	Parser compiler;
+	compiler.RecordVariable("x", 0);
+	compiler.RecordVariable("k", 10);
+	for (const char *statement : {"f(v)=v*v+1", "y=f(x)+k", "k++", "z=y%5", "w=z/0"})
+		compiler.AddStatement(statement);
+	const Program program(compiler);
+
+	//every thread runs the shared program against its own environment and input
+	const size_t threads = 4;
+	std::vector<char> results(threads, false);
+	std::vector<std::thread> workers;
+	for (size_t t = 0; t < threads; ++t)
+	{
+		workers.emplace_back([&program, &results, t]() {
+			Environment environment(program);
+			bool bRes = true;
+			for (size_t run = 0; run < 1000 && bRes; ++run)
+			{
+				environment.Reset();
+				double x = static_cast<double>(t * 1000 + run);
+				environment.RecordVariable("x", x);
+				program.Run(environment);
+				double y = x * x + 1 + 10;
+				bRes = AreSame(environment.LookupVariable("y"), y) && AreSame(environment.LookupVariable("k"), 11) &&
+					AreSame(environment.LookupVariable("z"), fmod(y, 5)) && environment.GetErrors().size() == 1 &&
+					environment.GetErrors()[0].m_code == ErrorCode::DivisionByZero;
+			}
+			results[t] = bRes;
+		});
+	}
+	for (std::thread &worker : workers)
+		worker.join();
+
+	bool bRes = program.GetErrors().empty() && !compiler.HasErrors();
+	for (char result : results)
+		bRes = bRes && result;
+	return bRes;
+}
+
+bool test_case18()
+{
+	if (!EvaluationServer::IsSupported())
+		return true;
+
+	//more clients than warm sessions, the pool grows by one
+	EvaluationServer server("unittests.sock", 2);
+	if (!server.Listen())
+		return false;
+	std::thread serving([&server]() { server.Run(); });
+
+	LoadGenerator::Options options;
+	options.m_clients = 3;
+	options.m_requests = 300;
+	options.m_pipeline = 8;
+	options.m_request = "a=1+2\nb=a*2\nc=b/0";
+	LoadGenerator::Result result = LoadGenerator::Run("unittests.sock", options);
+
+	//a client closing its side once it sent its requests gets every response, more than the
+	//socket holds at once
+	std::string request, requests;
+	for (size_t i = 0; i < 2000; ++i)
+		request += "v" + std::to_string(i) + "=" + std::to_string(i) + "\n";
+	for (size_t i = 0; i < 64; ++i)
+		EvaluationServer::AppendFrame(requests, request);
+	size_t responses = 0;
+#ifdef __linux__
+	sockaddr_un address{};
+	address.sun_family = AF_UNIX;
+	std::strncpy(address.sun_path, "unittests.sock", sizeof(address.sun_path) - 1);
+	int fd = ::socket(AF_UNIX, SOCK_STREAM, 0);
+	if (fd >= 0 && ::connect(fd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) == 0)
+	{
+		size_t written = 0;
+		for (ssize_t sent; written < requests.size() && (sent = ::write(fd, requests.data() + written, requests.size() - written)) > 0; )
+			written += sent;
+		::shutdown(fd, SHUT_WR);
+		std::string received, response;
+		char buffer[64 * 1024];
+		for (ssize_t count; (count = ::read(fd, buffer, sizeof(buffer))) > 0; )
+			received.append(buffer, count);
+		size_t offset = 0;
+		while (EvaluationServer::ReadFrame(received, offset, response) && response.compare(0, 12, "(v0=0,v1=1,v") == 0)
+			++responses;
+	}
+	if (fd >= 0)
+		::close(fd);
+#endif
+	server.Stop();
+	serving.join();
+
+	return result.m_failedClients == 0 && result.m_requests == 300 && server.GetSessionsCreated() == 3 &&
+		result.m_lastResponse == "Parser: Attempt to divide by zero: c=b/0 (position 3)\n(a=3,b=6,c=0)\n" && responses == 64;
+}
+
+bool test_case19()
+{
+	Parser saved;
+	for (const char *statement : {"zeta=1.5", "alpha=zeta*2", "b=1/3", "zeta++"})
+		saved.AddStatement(statement);
+	saved.EvaluateStatements();
+	bool bRes = VariableSnapshot::Save(saved, "unittests.snapshot");
+
+	//the restored variables print the same, in the order of creation, and a script continues from them
+	Parser restored;
+	restored.RecordVariable("first", 7);
+	bRes = bRes && VariableSnapshot::Restore(restored, "unittests.snapshot");
+	restored.AddStatement("c=alpha+zeta");
+	restored.EvaluateStatements();
+	std::ostringstream expected, actual;
+	saved.PrintVariables(expected);
+	restored.PrintVariables(actual);
+	bRes = bRes && actual.str() == "(first=7," + expected.str().substr(1, expected.str().size() - 3) + ",c=5.5)\n";
+
+	//a truncated file is rejected and leaves the parser unchanged
+	std::ifstream in("unittests.snapshot", std::ios::binary);
+	std::string data((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+	Parser truncated;
+	bRes = bRes && !VariableSnapshot::Restore(truncated, data.data(), data.size() - 1) && truncated.GetVariableNames().empty() &&
+		!VariableSnapshot::Restore(truncated, "unittests.missing");
+	std::remove("unittests.snapshot");
+
+	//names the longest first, by order of creation for a same length
+	Parser names;
+	for (const char *var : {"bb", "a", "ccc", "d", "ee"})
+		names.RecordVariable(var, 1);
+	bRes = bRes && names.GetVariableNames() == std::vector<std::string>{"ccc", "bb", "ee", "a", "d"};
+	names.UndefineVariables(3);
+	bRes = bRes && names.GetVariableNames() == std::vector<std::string>{"ccc", "bb", "a"};
+	return bRes;
+}
+
+bool test_case20()
+{
+	const std::vector<std::string> script {"a=2", "b=a*3+max(a,1)", "c=sin(b)-b%4", "a++", "d=a^2"};
+	auto run = [&script](CompiledCache &cache) {
+		Parser p;
+		p.SetCompiledCache(&cache);
+		for (const std::string &statement : script)
+			p.AddStatement(statement);
+		p.EvaluateStatements();
+		std::ostringstream out;
+		p.PrintVariables(out);
+		return out.str();
+	};
+
+	//the cold run stores the statements, a warm run from the file finds every one
+	CompiledCache cold;
+	std::string expected = run(cold);
+	bool bRes = cold.GetHits() == 0 && cold.GetEntries() == script.size() && cold.Save("unittests.cache");
+	CompiledCache warm;
+	bRes = bRes && warm.Load("unittests.cache") && warm.GetEntries() == script.size();
+	bRes = bRes && run(warm) == expected && warm.GetHits() == script.size() && warm.GetMisses() == 0;
+
+	//a++ was only valid while a was defined
+	Parser undefined;
+	undefined.SetCompiledCache(&warm);
+	undefined.AddStatement("a++");
+	undefined.EvaluateStatements();
+	bRes = bRes && warm.GetMisses() == 1 && undefined.GetErrors().size() == 1;
+
+	//x+++y read as x + ++y while x was undefined is read again once x is defined
+	CompiledCache increments;
+	Parser first, second;
+	first.SetCompiledCache(&increments);
+	for (const char *statement : {"y=1", "a = x+++y"})
+		first.AddStatement(statement);
+	first.EvaluateStatements();
+	bRes = bRes && increments.Save("unittests.cache") && increments.Load("unittests.cache");
+	second.SetCompiledCache(&increments);
+	for (const char *statement : {"x=5", "y=1", "a = x+++y"})
+		second.AddStatement(statement);
+	second.EvaluateStatements();
+	std::ostringstream out;
+	second.PrintVariables(out);
+	bRes = bRes && out.str() == "(x=6,y=1,a=6)\n";
+
+	//a file of another function table is ignored
+	std::fstream file("unittests.cache", std::ios::binary | std::ios::in | std::ios::out);
+	file.seekp(12);
+	file.put('x');
+	file.close();
+	CompiledCache stale;
+	bRes = bRes && !stale.Load("unittests.cache") && stale.HadVersionMismatch() && stale.GetEntries() == 0;
+	std::remove("unittests.cache");
+	return bRes;
+}
+
+bool test_case21()
+{
+	//a repeated statement is read once, i++ is read again while i is undefined
+	Parser p;
+	for (const char *statement : {"i++", "i=0", "y=2"})
+		p.AddStatement(statement);
+	for (size_t n = 0; n < 10; ++n)
+		p.AddStatement("i+=y");
+	p.AddStatement("i++");
+	p.EvaluateStatements();
+	const ParseCache &cache = p.GetParseCache();
+	bool bRes = p.LookupVariable("i") == 21 && cache.GetHits() == 9 && cache.GetMisses() == 5 && p.GetErrors().size() == 1;
+
+	//calls are read again once their function is defined again
+	Parser functions;
+	for (const char *statement : {"f(x)=x", "r=f(3)", "s=r", "f(x)=2*x", "r=f(3)"})
+		functions.AddStatement(statement);
+	functions.EvaluateStatements();
+	bRes = bRes && functions.LookupVariable("r") == 6;
+
+	//the least recently used entry is evicted
+	Parser bounded;
+	bounded.SetParseCacheLimits(2, 1024);
+	for (const char *statement : {"a=1", "b=a", "a=1", "c=2", "a=1"})
+		bounded.AddStatement(statement);
+	bounded.EvaluateStatements();
+	const ParseCache &lru = bounded.GetParseCache();
+	bRes = bRes && lru.GetHits() == 2 && lru.GetEvictions() == 1 && lru.GetEntries() == 2 && lru.GetBytes() <= 1024;
+
+	//x+++y is x + ++y while x is undefined and x++ + y once it is defined
+	Parser cached, uncached;
+	uncached.SetParseCacheLimits(0, 0);
+	for (Parser *parser : {&cached, &uncached})
+	{
+		for (const char *statement : {"y=1", "a = x+++y", "x=5", "a = x+++y"})
+			parser->AddStatement(statement);
+		parser->EvaluateStatements();
+	}
+	std::ostringstream cachedOut, uncachedOut;
+	cached.PrintVariables(cachedOut);
+	uncached.PrintVariables(uncachedOut);
+	bRes = bRes && cachedOut.str() == "(y=2,a=7,x=6)\n" && cachedOut.str() == uncachedOut.str() && cached.GetParseCache().GetHits() == 0;
+	return bRes;
+}
+
+bool test_case22()
+{
+	//the derivative rule of every built-in function matches a central difference
+	const double h = 1e-6;
+	Parser functions;
+	bool bRes = true;
+	for (const char *name : {"sin", "asin", "cos", "acos", "tan", "atan", "ceil", "floor"})
+	{
+		const CompiledExpression::Function &f = *functions.GetFunction(name);
+		bRes = bRes && std::fabs(GetDerivative(f, 0.3) - (f(0.3 + h) - f(0.3 - h)) / (2 * h)) < 1e-6;
+	}
+	for (const char *name : {"min", "max", "atan2", "pow"})
+	{
+		const CompiledExpression::BinaryFunction &f = *functions.GetBinaryFunction(name);
+		double da = 0, db = 0;
+		GetDerivatives(f, 0.7, 0.4, da, db);
+		bRes = bRes && std::fabs(da - (f(0.7 + h, 0.4) - f(0.7 - h, 0.4)) / (2 * h)) < 1e-6 &&
+			std::fabs(db - (f(0.7, 0.4 + h) - f(0.7, 0.4 - h)) / (2 * h)) < 1e-6;
+	}
+
+	auto script = [](double x, double t) {
+		return std::vector<std::string>{"x=" + std::to_string(x), "t=" + std::to_string(t), "y=x^2+sin(x)*t",
+			"z=y/x-max(x,t)%2", "w=atan2(z,x)+pow(x,t)*tan(t)", "x=x*2"};
+	};
+	auto run = [](const std::vector<std::string> &statements, const std::vector<std::string> &variables, bool batched, Parser &p) {
+		for (const std::string &statement : statements)
+			p.AddStatement(statement);
+		Differentiator differentiator(p, variables);
+		differentiator.EvaluateStatements(batched);
+		return differentiator;
+	};
+
+	//the values are those of the parser, the derivatives those of finite differences
+	std::vector<std::string> variables {"x", "t", "u0", "u1", "u2", "u3", "u4", "u5", "u6", "u7"};
+	Parser batchedParser, scalarParser;
+	Differentiator batched = run(script(3, 0.5), variables, true, batchedParser);
+	Differentiator scalar = run(script(3, 0.5), variables, false, scalarParser);
+	bRes = bRes && batched.GetPasses() == 2 && scalar.GetPasses() == variables.size();
+	std::ostringstream values;
+	batchedParser.PrintVariables(values);
+	Parser reference;
+	for (const std::string &statement : script(3, 0.5))
+		reference.AddStatement(statement);
+	reference.EvaluateStatements();
+	std::ostringstream expected;
+	reference.PrintVariables(expected);
+	bRes = bRes && values.str() == expected.str();
+
+	for (const char *var : {"x", "t", "y", "z", "w"})
+	{
+		for (size_t variable = 0; variable < variables.size(); ++variable)
+			bRes = bRes && batched.GetDerivative(var, variable) == scalar.GetDerivative(var, variable);
+		Parser plusX, minusX, plusT, minusT;
+		for (const std::string &statement : script(3 + 1e-3, 0.5))
+			plusX.AddStatement(statement);
+		for (const std::string &statement : script(3 - 1e-3, 0.5))
+			minusX.AddStatement(statement);
+		for (const std::string &statement : script(3, 0.5 + 1e-3))
+			plusT.AddStatement(statement);
+		for (const std::string &statement : script(3, 0.5 - 1e-3))
+			minusT.AddStatement(statement);
+		for (Parser *p : {&plusX, &minusX, &plusT, &minusT})
+			p->EvaluateStatements();
+		double dx = (plusX.LookupVariable(var) - minusX.LookupVariable(var)) / 2e-3;
+		double dt = (plusT.LookupVariable(var) - minusT.LookupVariable(var)) / 2e-3;
+		bRes = bRes && std::fabs(batched.GetDerivative(var, 0) - dx) < 1e-4 && std::fabs(batched.GetDerivative(var, 1) - dt) < 1e-4 &&
+			batched.GetDerivative(var, 2) == 0;
+	}
+	return bRes;
+}
+
+bool test_case23()
+{
+	const std::vector<std::string> script {"s=0", "for i in 0..5: s += i^2", "n=0", "for a in 0..3: for b in 0..a+1: n++",
+		"h=0", "for x in 0.5..3: {t = x; t *= 2; h += t}", "for z in 5..2: q = 1", "for i in 0..3: {s = 1;}"};
+	auto run = [&script](Parser &p, CompiledCache *cache) {
+		p.SetCompiledCache(cache);
+		for (const std::string &statement : script)
+			p.AddStatement(statement);
+		p.EvaluateStatements();
+		std::ostringstream out;
+		p.PrintVariables(out);
+		return out.str();
+	};
+
+	//an empty range runs nothing, a body must be well formed
+	Parser p;
+	std::string expected = run(p, nullptr);
+	bool bRes = expected == "(s=30,i=4,n=6,a=2,b=2,h=9,x=2.5,t=5)\n" && p.GetErrors().size() == 1 && p.GetErrors()[0].m_statement == 7;
+
+	//the tree, the compiled cache and a program shared by threads run the same loops
+	Parser tree;
+	tree.RecordVariable("s", 0);
+	ExpressionPtr loop = tree.EvaluateStatement(script[1]);
+	bRes = bRes && loop && loop->Evaluate() == 5 && tree.LookupVariable("s") == 30;
+	CompiledCache cache;
+	Parser cold, warm;
+	bRes = bRes && run(cold, &cache) == expected && run(warm, &cache) == expected && cache.GetHits() == 7;
+	Parser source;
+	for (const std::string &statement : script)
+		source.AddStatement(statement);
+	Program program(source);
+	Environment environment(program);
+	program.Run(environment);
+	bRes = bRes && environment.LookupVariable("n") == 6 && environment.LookupVariable("h") == 9 && !environment.HasVariable("q");
+
+	//a loop running zero times defines nothing for the statements read after it, as for a parser
+	for (const char *count : {"n = 0", "n = 2"})
+	{
+		Parser zeroSource, zeroParser;
+		for (const char *statement : {count, "for i in 0..n: x = 2", "x++", "a = x"})
+		{
+			zeroSource.AddStatement(statement);
+			zeroParser.AddStatement(statement);
+		}
+		Program zeroProgram(zeroSource);
+		Environment zeroEnvironment(zeroProgram);
+		zeroProgram.Run(zeroEnvironment);
+		zeroParser.EvaluateStatements();
+		std::ostringstream programOut, parserOut;
+		zeroEnvironment.PrintVariables(programOut);
+		zeroParser.PrintVariables(parserOut);
+		bRes = bRes && programOut.str() == parserOut.str() && zeroProgram.GetErrors().size() == zeroParser.GetErrors().size();
+	}
+
+	//a million steps are read once
+	Parser large;
+	large.AddStatement("s=0");
+	large.AddStatement("for i in 0..1000000: s += i % 7");
+	large.EvaluateStatements();
+	bRes = bRes && large.LookupVariable("s") == 2999997 && large.LookupVariable("i") == 999999;
+	return bRes;
+}
+
+bool test_case24()
+{
+	const std::vector<std::string> script {"a=1", "b=2", "c=a+b", "d=c*2", "e=b^2", "a=10", "f=a+1", "g=0", "g++", "h=g*2",
+		"k=5", "k+=1", "unused=k*3", "1/0", "n=0", "x=1", "for j in 0..n: x = 5", "y=x"};
+	Parser all, observed;
+	observed.SetObservedVariables({"d", "h", "k", "y"});
+	for (const std::string &statement : script)
+	{
+		all.AddStatement(statement);
+		observed.AddStatement(statement);
+	}
+	all.EvaluateStatements();
+	observed.EvaluateStatements();
+
+	//e=b^2, a=10, f=a+1, unused=k*3 and 1/0 are skipped, x=1 is kept as the loop may not assign x
+	bool bRes = observed.GetEliminatedStatements() == 5 && !observed.HasErrors() && all.GetErrors().size() == 1;
+	for (const char *var : {"d", "h", "k", "y"})
+		bRes = bRes && observed.LookupVariable(var) == all.LookupVariable(var);
+	std::ostringstream out;
+	observed.PrintVariables(out);
+	bRes = bRes && out.str() == "(d=6,h=2,k=6,y=1)\n";
+
+	//a loop running zero times defines nothing, x++ is then read as it is in a full run
+	for (const char *count : {"0", "2"})
+	{
+		Parser full, observedA;
+		observedA.SetObservedVariables({"a"});
+		for (const std::string &statement : {std::string("n=") + count, std::string("for i in 0..n: x = 2"), std::string("x++"),
+			std::string("for i in 0..0: z = 1"), std::string("a = y+x+z")})
+		{
+			full.AddStatement(statement);
+			observedA.AddStatement(statement);
+		}
+		full.EvaluateStatements();
+		observedA.EvaluateStatements();
+		bRes = bRes && observedA.LookupVariable("a") == full.LookupVariable("a") && observedA.HasVariable("x") == full.HasVariable("x") &&
+			!observedA.HasVariable("z") && observedA.GetErrors().size() == full.GetErrors().size();
+	}
+
+	//the live statements of a loop and of the variables it reads
+	std::vector<CompiledExpression> compiled(3);
+	Parser loop;
+	for (const char *statement : {"s=0", "t=s", "for i in 0..3: {s += i; u = i}"})
+		loop.AddStatement(statement);
+	for (size_t statement = 0; statement < compiled.size(); ++statement)
+	{
+		bRes = bRes && loop.CompileStatement(statement, compiled[statement]);
+		loop.DefineAssignedVariables(compiled[statement]);
+	}
+	bRes = bRes && FindLiveStatements(compiled, {loop.GetVariableSlot("s")}, loop.GetSlotCount()) == std::vector<char>{true, false, true} &&
+		FindLiveStatements(compiled, {loop.GetVariableSlot("t")}, loop.GetSlotCount()) == std::vector<char>{true, true, false};
+	return bRes;
+}
+
+bool test_case25()
+{
+	//a base of 200 variables, scenarios changing some of them
+	Parser parser;
+	parser.AddStatement("a=1");
+	parser.AddStatement("b=a+1");
+	parser.AddStatement("c=b*10");
+	for (size_t i = 0; i < 197; ++i)
+		parser.AddStatement("v" + std::to_string(i) + "=" + std::to_string(i));
+	ScenarioRunner runner(parser);
+	size_t changed = runner.AddScenario({"a=5", "d=a+c"});
+	size_t added = runner.AddScenario({"e=c+1", "e++"});
+	size_t failing = runner.AddScenario({"d++", "f=1/0"});
+	runner.Run(2);
+
+	const VersionedEnvironment &base = runner.GetBase();
+	bool bRes = !runner.GetBaseErrors().size() && base.LookupVariable("a") == 1 && !base.HasVariable("d");
+	std::ostringstream out;
+	runner.GetResult(changed).PrintVariables(out);
+	bRes = bRes && out.str().compare(0, 24, "(a=5,b=2,c=20,v0=0,v1=1,") == 0 &&
+		out.str().find("v196=196,d=25)") != std::string::npos;
+	//d is only assigned by the first scenario
+	bRes = bRes && runner.GetResult(added).LookupVariable("e") == 22 && !runner.GetResult(added).HasVariable("d");
+	bRes = bRes && runner.GetSyntaxErrors(failing).size() == 1 && runner.GetSyntaxErrors(failing)[0].m_statement == 0 &&
+		runner.GetResult(failing).GetErrors().size() == 1 && runner.GetResult(failing).GetErrors()[0].m_code == ErrorCode::DivisionByZero;
+	//a single page of the base was copied, the new variables are on another one
+	bRes = bRes && runner.GetResult(changed).GetPageCount() == 4 && runner.GetResult(changed).GetCopiedPages() == 2 &&
+		runner.GetResult(added).GetCopiedPages() == 1;
+
+	//a fork of a fork keeps the variables of its origin and its writes are its own
+	VersionedEnvironment origin(parser);
+	VersionedEnvironment fork = origin.Fork();
+	fork.RecordVariable(parser.GetVariableSlot("d"), 25);
+	VersionedEnvironment forkOfFork = fork.Fork();
+	forkOfFork.RecordVariable(0, 7);
+	fork.RecordVariable(0, 5);
+	bRes = bRes && origin.LookupVariable("a") == 1 && fork.LookupVariable("a") == 5 && forkOfFork.LookupVariable("a") == 7 &&
+		forkOfFork.LookupVariable("d") == 25 && !origin.HasVariable("d") && forkOfFork.GetVariableOrder().size() == 201;
+
+	//a scenario gives the variables of the base and the scenario replayed by a parser, a loop
+	//running zero times defining nothing
+	const std::vector<std::string> replayBase {"n=0", "y=1"};
+	for (const std::vector<std::string> &statements : std::vector<std::vector<std::string>>{
+		{"for i in 0..n: x = 2", "x++", "a = y+x"}, {"n=2", "for i in 0..n: x = 2", "x++", "a = y+x"}})
+	{
+		Parser scenarioBase, replay;
+		for (const std::string &statement : replayBase)
+		{
+			scenarioBase.AddStatement(statement);
+			replay.AddStatement(statement);
+		}
+		for (const std::string &statement : statements)
+			replay.AddStatement(statement);
+		ScenarioRunner replayed(scenarioBase);
+		replayed.AddScenario(statements);
+		replayed.Run();
+		replay.EvaluateStatements();
+		std::ostringstream scenarioOut, replayOut;
+		replayed.GetResult(0).PrintVariables(scenarioOut);
+		replay.PrintVariables(replayOut);
+		bRes = bRes && scenarioOut.str() == replayOut.str() &&
+			replayed.GetSyntaxErrors(0).size() + replayed.GetResult(0).GetErrors().size() == replay.GetErrors().size();
+	}
+	return bRes;
+}
+
+bool test_case26()
+{
+	Parser parser;
+	parser.RecordVariable("x", 1);
+	for (const char *statement : {"y=x*2", "z=10/x", "w=y+z", "w+=1", "c=0", "for i in 0..x: c += i", "m=max(x,3)+sin(y)", "n=y++"})
+		parser.AddStatement(statement);
+	const Program program(parser);
+
+	//every lane as its own run, the first one dividing by zero
+	LaneEnvironment<4> lanes(program);
+	for (size_t lane = 0; lane < 4; ++lane)
+		lanes.RecordVariable(lane, "x", static_cast<double>(lane));
+	lanes.Run();
+	bool bRes = lanes.GetSplitStatements() == 2;
+	for (size_t lane = 0; lane < 4; ++lane)
+	{
+		Environment environment(program);
+		environment.RecordVariable("x", static_cast<double>(lane));
+		program.Run(environment);
+		std::ostringstream expected, out;
+		environment.PrintVariables(expected);
+		lanes.PrintVariables(lane, out);
+		bRes = bRes && out.str() == expected.str() && lanes.GetErrors(lane).size() == environment.GetErrors().size();
+	}
+	bRes = bRes && lanes.GetErrors(0).size() == 1 && lanes.GetErrors(0)[0].m_code == ErrorCode::DivisionByZero &&
+		lanes.GetErrors(0)[0].m_statement == 1 && lanes.LookupVariable(2, "c") == 1 && lanes.LookupVariable(3, "c") == 3;
+	return bRes;
+}
+
+bool test_case27()
+{
+	//11 rows, more than a block of lanes, the 5th dividing by zero
+	std::ofstream("unittests.csv") << "x, y\r\n1,2\n3,4\n-1.5,6e2\n\n0.25,1\n5,0\n6,1\n7,2\n8,3\n9,4\n10,5\n11,6\n";
+	ColumnFile input, output, reread;
+	bool bRes = input.Load("unittests.csv", {}) && input.GetRowCount() == 11 && input.GetName(1) == "y" && input.GetColumn(1)[2] == 600;
+
+	Parser parser;
+	parser.RecordVariable("x", 0);
+	parser.RecordVariable("y", 0);
+	for (const char *statement : {"z=x*y", "w=x/y", "s=0", "for i in 0..x: s += i"})
+		parser.AddStatement(statement);
+	const Program program(parser);
+	BulkEvaluator evaluator(program);
+	std::string unknown;
+	bRes = bRes && evaluator.Run(input, {"w", "s"}, output, unknown) && evaluator.GetFailedRows() == std::vector<size_t>{4};
+	for (size_t row = 0; row < input.GetRowCount(); ++row)
+	{
+		Environment environment(program);
+		environment.RecordVariable("x", input.GetColumn(0)[row]);
+		environment.RecordVariable("y", input.GetColumn(1)[row]);
+		program.Run(environment);
+		bRes = bRes && output.GetColumn(0)[row] == environment.LookupVariable("w") && output.GetColumn(1)[row] == environment.LookupVariable("s");
+	}
+	bRes = bRes && !evaluator.Run(input, {"w", "q"}, output, unknown) && unknown == "q";
+
+	//in float every row is the run of a NumericEngine in float
+	BulkEvaluator singles(program, NumericType::Float);
+	bRes = bRes && singles.Run(input, {"z", "w", "s"}, output, unknown) && singles.GetFailedRows() == std::vector<size_t>{4};
+	for (size_t row = 0; row < input.GetRowCount(); ++row)
+	{
+		Parser single;
+		single.RecordVariable("x", input.GetColumn(0)[row]);
+		single.RecordVariable("y", input.GetColumn(1)[row]);
+		for (const char *statement : {"z=x*y", "w=x/y", "s=0", "for i in 0..x: s += i"})
+			single.AddStatement(statement);
+		NumericEngine(single, NumericType::Float).EvaluateStatements();
+		for (size_t column = 0; column < 3; ++column)
+			bRes = bRes && output.GetColumn(column)[row] == single.LookupVariable(output.GetName(column));
+	}
+	bRes = bRes && output.GetColumn(1)[2] == static_cast<double>(-1.5f / 600.0f) && output.GetColumn(1)[2] != -1.5 / 600 && BulkEvaluator::IsSupported(NumericType::Float) &&
+		!BulkEvaluator::IsSupported(NumericType::Int64);
+
+	//binary and CSV files read back as written
+	for (const char *path : {"unittests.columns", "unittests.csv"})
+	{
+		bRes = bRes && input.Save(path) && reread.Load(path, {"x", "y"}) && reread.GetRowCount() == 11;
+		for (size_t row = 0; row < reread.GetRowCount(); ++row)
+			bRes = bRes && reread.GetColumn(0)[row] == input.GetColumn(0)[row] && reread.GetColumn(1)[row] == input.GetColumn(1)[row];
+	}
+	std::ofstream("unittests.csv") << "x,y\n1,2\n3,a\n";
+	bRes = bRes && !reread.Load("unittests.csv", {}) && reread.GetError() == "Line 3: invalid number 'a'" && !reread.GetColumnCount();
+	bRes = bRes && !reread.Load("unittests.columns", {"x", "y", "z"});
+	std::remove("unittests.csv");
+	std::remove("unittests.columns");
+	return bRes;
+}
+
+bool test_case28()
+{
+	//a directory of scripts, the same outputs as a parser per script
+	const std::vector<std::vector<std::string>> scripts {{"a=1", "b=a+2"}, {"x=1/0", "", "y=2"}, {"f(x)=x*2", "z=f(3)"}, {"s=(1"}};
+	std::filesystem::create_directories("unittests.batch/scripts");
+	std::vector<std::string> expected;
+	for (size_t script = 0; script < scripts.size(); ++script)
+	{
+		std::ofstream file("unittests.batch/scripts/" + std::to_string(script));
+		Parser parser;
+		for (const std::string &statement : scripts[script])
+		{
+			file << statement << "\n";
+			if (!statement.empty())
+				parser.AddStatement(statement);
+		}
+		parser.EvaluateStatements();
+		std::ostringstream out;
+		parser.PrintErrors(out);
+		parser.PrintVariables(out);
+		expected.push_back(out.str());
+	}
+
+	BatchRunner runner;
+	runner.SetResultsDirectory("unittests.batch/results");
+	bool bRes = runner.AddDirectory("unittests.batch/scripts") && !runner.AddDirectory("unittests.batch/none");
+	runner.Run(2);
+	const std::vector<BatchRunner::ScriptResult> &results = runner.GetResults();
+	bRes = bRes && results.size() == scripts.size();
+	for (size_t script = 0; bRes && script < scripts.size(); ++script)
+	{
+		std::ifstream file("unittests.batch/results/" + std::to_string(script));
+		std::string written((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+		bRes = results[script].m_read && results[script].m_written && results[script].m_output == expected[script] && written == expected[script];
+	}
+	bRes = bRes && results[1].m_errors == 1 && results[3].m_errors == 1 && results[1].m_statements == 2;
+
+	//a manifest relative to its directory, with a missing script
+	std::ofstream("unittests.batch/manifest") << "scripts/2\nscripts/missing\n";
+	BatchRunner manifest;
+	bRes = bRes && manifest.AddManifest("unittests.batch/manifest");
+	manifest.Run(1);
+	bRes = bRes && manifest.GetResults().size() == 2 && manifest.GetResults()[0].m_output == expected[2] && !manifest.GetResults()[1].m_read;
+
+	//scripts of the same name in different directories keep their own results, a script
+	//listed twice has its index prefixed, and results are never written over the scripts
+	std::filesystem::create_directories("unittests.batch/a");
+	std::filesystem::create_directories("unittests.batch/b");
+	std::ofstream("unittests.batch/a/s.txt") << "x=1\n";
+	std::ofstream("unittests.batch/b/s.txt") << "x=2\n";
+	std::ofstream("unittests.batch/names") << "a/s.txt\nb/s.txt\n./a/s.txt\n";
+	BatchRunner names;
+	names.SetResultsDirectory("unittests.batch/named");
+	bRes = bRes && names.AddManifest("unittests.batch/names") && names.Run(2) && names.GetResults()[2].m_name == "2-a/s.txt";
+	for (const char *result : {"a/s.txt", "b/s.txt", "2-a/s.txt"})
+	{
+		std::ifstream file(std::string("unittests.batch/named/") + result);
+		std::string written((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+		bRes = bRes && written == (result[0] == 'b' ? "(x=2)\n" : "(x=1)\n");
+	}
+	BatchRunner overwriting;
+	overwriting.SetResultsDirectory("unittests.batch/scripts/../scripts");
+	bRes = bRes && overwriting.AddDirectory("unittests.batch/scripts") && !overwriting.Run(1);
+	std::ifstream script("unittests.batch/scripts/0");
+	std::string kept((std::istreambuf_iterator<char>(script)), std::istreambuf_iterator<char>());
+	bRes = bRes && kept == "a=1\nb=a+2\n";
+	std::filesystem::remove_all("unittests.batch");
+	return bRes;
+}
+
+bool test_case29()
+{
+	//every implementation finds the same runs as the C locale, at any alignment and length
+	std::string text;
+	for (size_t i = 0; i < 300; ++i)
+	{
+		const char pattern[] = " \t\r\n\v\fazAZ09_.+@[`{/:\x80\xff";
+		text += i % 7 < 4 ? pattern[(i * 7 + i / 3) % (sizeof(pattern) - 1)] : "abc123   XYZ"[(i * 5) % 12];
+	}
+	CharacterScanner::Implementation best = CharacterScanner::GetImplementation();
+	bool bRes = true;
+	for (CharacterScanner::Implementation implementation : {CharacterScanner::Implementation::Scalar,
+		CharacterScanner::Implementation::SSE2, CharacterScanner::Implementation::AVX2})
+	{
+		if (!CharacterScanner::SetImplementation(implementation))
+			continue;
+		for (size_t position = 0; position < text.size(); ++position)
+		{
+			size_t spaces = position, alphanumerics = position, digits = position;
+			while (spaces < text.size() && std::isspace(static_cast<unsigned char>(text[spaces])))
+				++spaces;
+			while (alphanumerics < text.size() && std::isalnum(static_cast<unsigned char>(text[alphanumerics])))
+				++alphanumerics;
+			while (digits < text.size() && std::isdigit(static_cast<unsigned char>(text[digits])))
+				++digits;
+			bRes = bRes && CharacterScanner::SkipSpaces(text.data(), position, text.size()) == spaces &&
+				CharacterScanner::SkipAlphanumerics(text.data(), position, text.size()) == alphanumerics &&
+				CharacterScanner::SkipDigits(text.data(), position, text.size()) == digits;
+		}
+	}
+	CharacterScanner::SetImplementation(best);
+
+	//long runs of spaces, names and digits read by the tokenizer
+	Parser parser;
+	parser.AddStatement(std::string(100, ' ') + "variableWithAVeryLongName1234567890abcdefghijklmnopqrstuvwxyz = 123456789012345678901234567890" + std::string(70, ' ') + "+ 1.5e3+0.25");
+	parser.AddStatement("n = 1234567 + 3 + 007");
+	parser.AddStatement("x = 0");
+	parser.AddStatement("for i in 0..10: x += i");
+	//out of range, the largest double as a stream read gives, and 0
+	parser.AddStatement("big = 1e400");
+	parser.AddStatement("small = 1e-400");
+	parser.EvaluateStatements();
+	bRes = bRes && !parser.HasErrors() && parser.LookupVariable("variableWithAVeryLongName1234567890abcdefghijklmnopqrstuvwxyz") == 123456789012345678901234567890.0 + 1500.25 &&
+		parser.LookupVariable("n") == 1234577 && parser.LookupVariable("x") == 45 &&
+		parser.LookupVariable("big") == std::numeric_limits<double>::max() && parser.LookupVariable("small") == 0;
+	return bRes;
+}
+
+bool test_case30()
+{
+	//a sum read by several threads gives the same variables and errors as read at once
+	std::string sum("s = 0.1");
+	for (size_t i = 0; i < 3000; ++i)
+		sum += std::string(i % 3 ? " + " : "-") + std::to_string(i % 7) + ".3e-1*x" + std::to_string(i % 5) + " - (y+" + std::to_string(i) + ")/3";
+	const std::vector<std::string> statements {
+		"x0 = 1", "x1 = 2", "x2 = 3", "x3 = 4", "x4 = 5", "y = 0.7", "f(a, b) = a*b - a",
+		sum,
+		"t = 1e+2 + 2E-1 - x0++ + --x1 + f(y, x2 + 1) - max(x3, y - 2)^2 + 3 % 2 - 1/(x4-5)",
+		"u = e-1 + n + x2 * (x3 - (x4 + 1)) - 7",
+		"v = 1 + 2 * - 3 + 4",
+		"w = 1 + (2 + 3",
+		"x3 + y - 1",
+		"for i in 0..3: x4 += i - 1"
+	};
+	Parser sequential, parallel;
+	parallel.SetParseThreads(4, 0);
+	for (const std::string &statement : statements)
+	{
+		sequential.AddStatement(statement);
+		parallel.AddStatement(statement);
+	}
+	sequential.EvaluateStatements();
+	parallel.EvaluateStatements();
+
+	std::ostringstream expected, result;
+	sequential.PrintErrors(expected);
+	sequential.PrintVariables(expected);
+	parallel.PrintErrors(result);
+	parallel.PrintVariables(result);
+	bool bRes = expected.str() == result.str() && sequential.GetErrors().size() == 3 && parallel.GetParseThreads() == 4;
+	for (const std::string &var : sequential.GetVariableNames())
+		bRes = bRes && sequential.LookupVariable(var) == parallel.LookupVariable(var);
+
+	//operators outside of parentheses, but those of ++, -- and of exponents
+	std::vector<size_t> operators;
+	const std::string text("a+b*(c-d)-e++ + 1e-3-f(g,h+1) - 2E+2");
+	bRes = bRes && ParallelSumParser::FindOperators(text, 0, 3, operators) &&
+		operators == std::vector<size_t>{1, 9, 14, 20, 30} && !ParallelSumParser::FindOperators("a+(b-c", 0, 1, operators);
+	return bRes;
+}
+
+bool test_case31()
+{
+	//repeated calls of the built-in functions are found in the cache, with the same values
+	const std::vector<std::string> statements {
+		"x = sin(60) + cos(60)", "y = sin(60) * cos(60) + sin(30)", "z = max(x, y) + max(x, y) - min(1, 2)",
+		"for i in 0..100: z += sin(i % 4) + atan2(i % 2, 1)", "w = floor(0.5) + ceil(0.5)"
+	};
+	Parser plain, cached;
+	FunctionCache cache;
+	cached.SetFunctionCache(&cache);
+	for (const std::string &statement : statements)
+	{
+		plain.AddStatement(statement);
+		cached.AddStatement(statement);
+	}
+	plain.EvaluateStatements();
+	cached.EvaluateStatements();
+	bool bRes = cached.GetFunctionCache() == &cache && cache.GetEntries() == 256;
+	for (const std::string &var : plain.GetVariableNames())
+		bRes = bRes && plain.LookupVariable(var) == cached.LookupVariable(var);
+	//sin: 60 and 30, then 4 values in the loop, hit 96 times
+	std::vector<FunctionCache::FunctionStatistics> statistics = cache.GetStatistics();
+	auto find = [&statistics](const std::string &name) {
+		return *std::find_if(statistics.begin(), statistics.end(), [&name](const FunctionCache::FunctionStatistics &s) { return s.m_name == name; });
+	};
+	bRes = bRes && find("sin").m_misses == 6 && find("sin").m_hits == 97 && find("cos").m_hits == 1 && find("max").m_hits == 1 &&
+		find("atan2").m_misses == 2 && find("atan2").m_hits == 98 && find("tan").m_hits + find("tan").m_misses == 0;
+	bRes = bRes && cache.GetHits() + cache.GetMisses() == 2 + 1 + 2 + 1 + 100 + 100 + 2 + 1 + 1 && cache.GetHitRate() > 0.9;
+
+	//arguments compared by their bits, and a table of a single entry keeps the last call only
+	FunctionCache single(1);
+	const CompiledExpression::Function *sine = cached.GetFunction("sin"), *floor = cached.GetFunction("floor");
+	single.AddPureFunction("sin", sine);
+	bRes = bRes && std::signbit(single.Call(*sine, -0.0)) && !std::signbit(single.Call(*sine, 0.0)) && single.GetMisses() == 2;
+	single.Call(*sine, 0.0);
+	single.Call(*sine, 1.0);
+	single.Call(*sine, 0.0);
+	single.Call(*floor, 1.5);
+	bRes = bRes && single.GetHits() == 1 && single.GetMisses() == 4 && single.GetStatistics().size() == 1;
+	single.Clear();
+	bRes = bRes && single.GetHits() + single.GetMisses() == 0 && single.Call(*sine, 1.0) == std::sin(1.0);
+
+	std::ostringstream out;
+	cache.PrintStatistics(out);
+	return bRes && out.str().find("  sin: 97 hits, 6 misses") != std::string::npos && out.str().find("tan:") == std::string::npos;
+}
+bool test_case32()
+{
+	//the statements the checker rejects are those the parser could not read on its own
+	const std::vector<std::string> statements {
+		"x = 1", "v = 1 + 2 * - 3 + 4", "w = 1 + (2 + 3", "f(a, b) = a * b + 1", "y = f(2, 3) + max(x, 4)",
+		"z = f(2)", "z = sin(1, 2)", "x += ++x", "u *= 2", "for i in 0..3: {t = i; t *= 2; x += t}", "for i in 0..3: t++",
+		"for i in 0..3 {x++}", "g(a) = ++a", "++q + 1", "1..2", "", "y = 1e3 ^ 0.5 % 7"
+	};
+	Parser checked, backtracking;
+	backtracking.EnableSyntaxCheck(false);
+	for (const std::string &statement : statements)
+	{
+		checked.AddStatement(statement);
+		backtracking.AddStatement(statement);
+	}
+	checked.EvaluateStatements();
+	backtracking.EvaluateStatements();
+	const std::vector<Parser::StatementError> &errors = checked.GetErrors();
+	bool bRes = errors.size() == backtracking.GetErrors().size() && errors.size() == 10;
+	for (size_t i = 0; bRes && i < errors.size(); ++i)
+		bRes = errors[i].m_statement == backtracking.GetErrors()[i].m_statement && errors[i].m_code == ErrorCode::SyntaxError;
+	for (const std::string &var : backtracking.GetVariableNames())
+		bRes = bRes && checked.LookupVariable(var) == backtracking.LookupVariable(var);
+
+	//the first unexpected token and the tokens which could have been there
+	auto failsAt = [&errors](size_t statement, int position, uint32_t expected) {
+		auto error = std::find_if(errors.begin(), errors.end(), [statement](const Parser::StatementError &e) { return e.m_statement == statement; });
+		return error != errors.end() && error->m_position == position && error->m_expected == expected;
+	};
+	const uint32_t term = SyntaxChecker::s_number | SyntaxChecker::s_name | SyntaxChecker::s_openParenthesis;
+	bRes = bRes && failsAt(1, 12, term | SyntaxChecker::s_increment) &&
+		failsAt(2, 14, SyntaxChecker::s_operator | SyntaxChecker::s_closeParenthesis) &&
+		failsAt(5, 7, SyntaxChecker::s_operator | SyntaxChecker::s_comma) &&
+		failsAt(6, 9, SyntaxChecker::s_operator | SyntaxChecker::s_closeParenthesis) &&
+		failsAt(8, 3, term | SyntaxChecker::s_increment) && failsAt(11, 14, SyntaxChecker::s_operator | SyntaxChecker::s_colon) &&
+		failsAt(12, 7, term) && failsAt(13, 2, SyntaxChecker::s_definedVariable) && failsAt(14, 1, SyntaxChecker::s_operator | SyntaxChecker::s_end) &&
+		failsAt(15, 0, term | SyntaxChecker::s_increment);
+
+	SyntaxChecker checker;
+	checker.SetParser(&checked);
+	bRes = bRes && checker.Check("for j in 0..2: {s = j; for k in 0..s: s += k}") && checker.Check("x += f(x, t)") &&
+		!checker.Check("for j in 0..2: s += j") && checker.GetPosition() == 18 &&
+		checker.GetExpected() == (term | SyntaxChecker::s_increment) &&
+		!checker.Check("for j on 0..2: j") && checker.GetPosition() == 6 && checker.GetExpected() == SyntaxChecker::s_in;
+
+	std::ostringstream out;
+	checked.PrintErrors(out);
+	return bRes && out.str().find("Parser: Could not evaluate the statement: w = 1 + (2 + 3 (position 14, expected an operator or ')')") != std::string::npos;
+}
 
 void UnitTests::RunUnitTests()
 {
@@ -216,6 +1252,86 @@ void UnitTests::RunUnitTests()
 	test_case8() 	? ++passed : ++failed;
 	test_case9() 	? ++passed : ++failed;
 	test_case10() 	? ++passed : ++failed;
+	test_case11() 	? ++passed : ++failed;
+	test_case12() 	? ++passed : ++failed;
+	test_case13() 	? ++passed : ++failed;
+	test_case14() 	? ++passed : ++failed;
+	test_case15() 	? ++passed : ++failed;
+	test_case16() 	? ++passed : ++failed;
+	test_case17() 	? ++passed : ++failed;
+	test_case18() 	? ++passed : ++failed;
+	test_case19() 	? ++passed : ++failed;
+	test_case20() 	? ++passed : ++failed;
+	test_case21() 	? ++passed : ++failed;
+	test_case22() 	? ++passed : ++failed;
+	test_case23() 	? ++passed : ++failed;
+	test_case24() 	? ++passed : ++failed;
+	test_case25() 	? ++passed : ++failed;
+	test_case26() 	? ++passed : ++failed;
+	test_case27() 	? ++passed : ++failed;
+	test_case28() 	? ++passed : ++failed;
+	test_case29() 	? ++passed : ++failed;
+	test_case30() 	? ++passed : ++failed;
+	test_case31() 	? ++passed : ++failed;
+	test_case32() 	? ++passed : ++failed;
+
+	std::cout << "Ran  " << passed+failed <<" tests" << std::endl;
+	std::cout << passed << " tests passed" << std::endl;
+	std::cout << failed << " tests failed" << std::endl;
+}
+
+
+//Best time of several runs of the workload through AddStatement/EvaluateStatements, in seconds
+double time_workload(const benchmarks::Workload &workload)
+{
+	using Clock = std::chrono::steady_clock;
+	const size_t minRuns = 5;
+	const std::chrono::milliseconds minDuration(20);
+
+	double best = std::numeric_limits<double>::max();
+	Clock::time_point start = Clock::now();
+	for (size_t run = 0; run < minRuns || Clock::now() - start < minDuration; ++run)
+	{
+		Clock::time_point begin = Clock::now();
+		Parser p;
+		for (const std::string &statement : workload.m_statements)
+			p.AddStatement(statement);
+		p.EvaluateStatements();
+		best = std::min(best, std::chrono::duration<double>(Clock::now() - begin).count());
+	}
+	return best;
+}
+
+//Fit time = c * size^exponent over doubling sizes and compare the exponent to the allowed one
+bool complexity_test(const std::string &name, const std::function<benchmarks::Workload(size_t)> &generator, 
+	size_t size, size_t doublings, double maxExponent)
+{
+	double sumX(0), sumY(0), sumXX(0), sumXY(0);
+	for (size_t i = 0; i <= doublings; ++i, size *= 2)
+	{
+		double x = std::log(static_cast<double>(size));
+		double y = std::log(time_workload(generator(size)));
+		sumX += x;
+		sumY += y;
+		sumXX += x * x;
+		sumXY += x * y;
+	}
+	double n = static_cast<double>(doublings + 1);
+	double exponent = (n * sumXY - sumX * sumY) / (n * sumXX - sumX * sumX);
+
+	bool bRes = exponent <= maxExponent;
+	std::cout << "  " << name << ": exponent " << exponent << (bRes ? " passed" : " FAILED") << std::endl;
+	return bRes;
+}
+
+void UnitTests::RunComplexityTests(double maxExponent)
+{
+	std::cout << "Running complexity tests (max exponent " << maxExponent << "):" << std::endl;
+	size_t passed(0), failed(0);
+	complexity_test("statement length", benchmarks::long_sum, 500, 5, maxExponent) 			? ++passed : ++failed;
+	complexity_test("nesting depth", benchmarks::deep_parentheses, 25, 5, maxExponent) 		? ++passed : ++failed;
+	complexity_test("variable count", benchmarks::many_variables, 250, 5, maxExponent) 		? ++passed : ++failed;
+	complexity_test("increments", benchmarks::increments, 100, 5, maxExponent) 				? ++passed : ++failed;
 
 	std::cout << "Ran  " << passed+failed <<" tests" << std::endl;
 	std::cout << passed << " tests passed" << std::endl;
@@ -6,6 +6,9 @@ class UnitTests
 {
 public:
     static void RunUnitTests();
+
+    //Run workloads at doubling sizes and fail those whose time grows faster than size^maxExponent
+    static void RunComplexityTests(double maxExponent = 1.5);
 };
     
 }